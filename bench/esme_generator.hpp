@@ -0,0 +1,261 @@
+#pragma once
+
+#include "bench/latency_histogram.hpp"
+
+#include <smpp/smpp.hpp>
+
+#include <fmt/core.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace bench
+{
+/**
+ * @brief In-process ESME load generator built on pa::smpp::client.
+ *
+ * Binds `sessions` transceivers and keeps up to `window` submit_sm outstanding on each of them; with a
+ * non-zero `rate` the submits are paced to that many per second over all sessions. The submit to
+ * submit_resp latency of every response is recorded. Runs on a single io_context and is not thread safe.
+ */
+class esme_generator
+{
+  public:
+    struct options
+    {
+        std::string ip;
+        uint16_t port{};
+        std::string system_id;
+        std::string password;
+        size_t sessions{ 4 };
+        size_t window{ 64 };
+        uint32_t rate{ 0 };
+        std::string destination_prefix{ "98912" };
+    };
+
+    struct counters
+    {
+        uint64_t sent{};
+        uint64_t succeeded{};
+        uint64_t failed{};
+        latency_histogram latency;
+
+        void reset()
+        {
+            sent = 0;
+            succeeded = 0;
+            failed = 0;
+            latency.reset();
+        }
+    };
+
+  private:
+    struct esme_session
+    {
+        std::shared_ptr<pa::smpp::session> session;
+        std::unordered_map<uint32_t, std::chrono::steady_clock::time_point> in_flight;
+    };
+
+    static constexpr auto pacing_period = std::chrono::milliseconds(5);
+
+    boost::asio::io_context* io_context_;
+    const options options_;
+    boost::asio::steady_timer pacing_timer_;
+
+    std::vector<std::shared_ptr<pa::smpp::client>> clients_;
+    std::vector<std::shared_ptr<esme_session>> sessions_;
+    size_t next_session_{};
+
+    double tokens_{};
+    uint64_t message_counter_{};
+    bool running_{ false };
+
+    counters counters_;
+
+  public:
+    esme_generator(boost::asio::io_context* io_context, options options)
+        : io_context_(io_context)
+        , options_(std::move(options))
+        , pacing_timer_(*io_context)
+    {
+    }
+
+    esme_generator(const esme_generator&) = delete;
+    esme_generator& operator=(const esme_generator&) = delete;
+    ~esme_generator() = default;
+
+    /** @brief connects and binds the sessions, load starts with run() */
+    void connect()
+    {
+        auto bind_request = pa::smpp::bind_request{ .bind_type = pa::smpp::bind_type::transceiver,
+                                                    .system_id = options_.system_id,
+                                                    .password = options_.password,
+                                                    .system_type = "smpp" };
+
+        for (size_t i = 0; i < options_.sessions; i++)
+        {
+            auto client = std::make_shared<pa::smpp::client>(io_context_,
+                                                             options_.ip,
+                                                             options_.port,
+                                                             3600,
+                                                             30,
+                                                             bind_request,
+                                                             std::bind_front(&esme_generator::on_bind, this),
+                                                             [](const std::string& error) { fmt::print("esme: {}\n", error); });
+            client->start();
+            clients_.push_back(std::move(client));
+        }
+    }
+
+    void run()
+    {
+        running_ = true;
+
+        if (options_.rate)
+        {
+            do_set_pacing_timer();
+            return;
+        }
+
+        for (auto& s : sessions_)
+            fill_window(*s);
+    }
+
+    void stop()
+    {
+        running_ = false;
+        pacing_timer_.cancel();
+
+        for (auto& s : sessions_)
+        {
+            if (s->session->is_open())
+                s->session->unbind();
+        }
+    }
+
+    size_t bound_sessions() const
+    {
+        return sessions_.size();
+    }
+
+    size_t in_flight() const
+    {
+        size_t result = 0;
+        for (const auto& s : sessions_)
+            result += s->in_flight.size();
+
+        return result;
+    }
+
+    /** @brief counters since the previous call */
+    counters take_counters()
+    {
+        auto result = counters_;
+        counters_.reset();
+        return result;
+    }
+
+  private:
+    void on_bind(const pa::smpp::bind_resp&, std::shared_ptr<pa::smpp::session> session)
+    {
+        auto s = std::make_shared<esme_session>();
+        s->session = session;
+
+        session->response_handler = [this, s](std::shared_ptr<pa::smpp::session>, pa::smpp::response&& resp, uint32_t sequence_number, pa::smpp::command_status status) {
+            on_response(*s, std::move(resp), sequence_number, status);
+        };
+        session->request_handler = [](std::shared_ptr<pa::smpp::session> session, pa::smpp::request&& req, uint32_t sequence_number) {
+            if (std::holds_alternative<pa::smpp::deliver_sm>(req))
+                session->send(pa::smpp::deliver_sm_resp{}, sequence_number, pa::smpp::command_status::rok);
+        };
+        session->close_handler = [this, s](std::shared_ptr<pa::smpp::session>, std::optional<std::string> error) {
+            fmt::print("esme: session closed, {}\n", error.value_or("gracefully"));
+            std::erase(sessions_, s);
+        };
+
+        sessions_.push_back(s);
+
+        if (running_ && !options_.rate)
+            fill_window(*s);
+    }
+
+    void on_response(esme_session& s, pa::smpp::response&& resp, uint32_t sequence_number, pa::smpp::command_status status)
+    {
+        if (!std::holds_alternative<pa::smpp::submit_sm_resp>(resp) && !std::holds_alternative<pa::smpp::generic_nack>(resp))
+            return;
+
+        auto it = s.in_flight.find(sequence_number);
+        if (it == s.in_flight.end())
+            return;
+
+        counters_.latency.record(std::chrono::steady_clock::now() - it->second);
+        s.in_flight.erase(it);
+
+        if (status == pa::smpp::command_status::rok && std::holds_alternative<pa::smpp::submit_sm_resp>(resp))
+            counters_.succeeded++;
+        else
+            counters_.failed++;
+
+        if (running_ && !options_.rate)
+            fill_window(s);
+    }
+
+    void fill_window(esme_session& s)
+    {
+        while (s.in_flight.size() < options_.window)
+            send_one(s);
+    }
+
+    void send_one(esme_session& s)
+    {
+        auto sm = pa::smpp::submit_sm{};
+        sm.source_addr_ton = pa::smpp::ton::international;
+        sm.source_addr_npi = pa::smpp::npi::e164;
+        sm.source_addr = "989000000000";
+        sm.dest_addr_ton = pa::smpp::ton::international;
+        sm.dest_addr_npi = pa::smpp::npi::e164;
+        sm.dest_addr = fmt::format("{}{:07}", options_.destination_prefix, message_counter_++ % 10000000);
+        sm.short_message = "smppgw-bench";
+
+        auto sequence_number = s.session->send(sm);
+        s.in_flight.emplace(sequence_number, std::chrono::steady_clock::now());
+        counters_.sent++;
+    }
+
+    void do_set_pacing_timer()
+    {
+        pacing_timer_.expires_after(pacing_period);
+        pacing_timer_.async_wait([this](std::error_code ec) {
+            if (ec || !running_)
+                return;
+
+            on_pacing_timer();
+            do_set_pacing_timer();
+        });
+    }
+
+    void on_pacing_timer()
+    {
+        constexpr double periods_per_second = std::chrono::seconds(1) / pacing_period;
+
+        // at most one period of unused budget is carried over
+        tokens_ = std::min(tokens_ + options_.rate / periods_per_second, 2 * options_.rate / periods_per_second);
+
+        for (size_t checked = 0; tokens_ >= 1 && checked < sessions_.size();)
+        {
+            auto& s = *sessions_[next_session_++ % sessions_.size()];
+
+            if (s.in_flight.size() >= options_.window)
+            {
+                checked++;
+                continue;
+            }
+
+            send_one(s);
+            tokens_--;
+            checked = 0;
+        }
+    }
+};
+} // namespace bench
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+namespace bench
+{
+/**
+ * @brief Log-linear latency histogram in microseconds.
+ *
+ * Every power of two is split into 32 linear sub-buckets, so a reported percentile is within about 3% of
+ * the recorded value. record() is a couple of instructions and never allocates.
+ */
+class latency_histogram
+{
+    static constexpr unsigned sub_bucket_bits = 5;
+    static constexpr uint64_t sub_bucket_count = uint64_t{ 1 } << sub_bucket_bits;
+
+    std::array<uint64_t, 64 * sub_bucket_count> counts_{};
+    uint64_t total_{};
+    uint64_t max_{};
+
+  public:
+    void record(std::chrono::nanoseconds latency)
+    {
+        auto us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+
+        counts_[index_of(us)]++;
+        total_++;
+
+        if (us > max_)
+            max_ = us;
+    }
+
+    void merge(const latency_histogram& other)
+    {
+        for (size_t i = 0; i < counts_.size(); i++)
+            counts_[i] += other.counts_[i];
+
+        total_ += other.total_;
+
+        if (other.max_ > max_)
+            max_ = other.max_;
+    }
+
+    void reset()
+    {
+        counts_.fill(0);
+        total_ = 0;
+        max_ = 0;
+    }
+
+    uint64_t count() const
+    {
+        return total_;
+    }
+
+    std::chrono::microseconds max() const
+    {
+        return std::chrono::microseconds(max_);
+    }
+
+    /** @brief value at or below which @p percentile percent of the samples are */
+    std::chrono::microseconds percentile(double percentile) const
+    {
+        if (total_ == 0)
+            return {};
+
+        auto rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total_) + 0.5);
+        if (rank == 0)
+            rank = 1;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); i++)
+        {
+            seen += counts_[i];
+            if (seen >= rank)
+                return std::chrono::microseconds(std::min(value_of(i), max_));
+        }
+
+        return std::chrono::microseconds(max_);
+    }
+
+  private:
+    static size_t index_of(uint64_t value)
+    {
+        if (value < sub_bucket_count)
+            return value;
+
+        unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - sub_bucket_bits;
+        return ((shift + 1) << sub_bucket_bits) + ((value >> shift) & (sub_bucket_count - 1));
+    }
+
+    // upper bound of the bucket
+    static uint64_t value_of(size_t index)
+    {
+        if (index < sub_bucket_count)
+            return index;
+
+        unsigned shift = static_cast<unsigned>(index >> sub_bucket_bits) - 1;
+        return ((sub_bucket_count + (index & (sub_bucket_count - 1))) << shift) + ((uint64_t{ 1 } << shift) - 1);
+    }
+};
+} // namespace bench
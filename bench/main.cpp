@@ -0,0 +1,376 @@
+/**
+ * smppgw-bench drives a real smpp_gateway over loopback: an in-process ESME load generator submits through
+ * the gateway, which checks every submit against a PAPER stand-in and forwards it to a boninet (SMSC)
+ * simulator. Ports and routes are read from the same config as the gateway's, see bench/config.json.
+ *
+ *   smppgw-bench [--config <path>] [--sessions <n>] [--window <n>] [--rate <tps>]
+ *                [--warmup <sec>] [--duration <sec>] [--min-tps <tps>]
+ *
+ * Prints one line per second and a final `RESULT {...}` line to track per commit. Exits with 2 when the
+ * measured TPS is below --min-tps.
+ */
+#include "src/smpp_gateway.h"
+#include "src/schema.hpp"
+
+#include "bench/esme_generator.hpp"
+#include "bench/paper_simulator.hpp"
+#include "bench/smsc_simulator.hpp"
+
+#include <boost/asio/signal_set.hpp>
+
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+struct bench_options
+{
+    std::string config_path = (std::filesystem::current_path() / "config.json").string();
+    size_t sessions = 4;
+    size_t window = 64;
+    uint32_t rate = 0;
+    uint32_t warmup = 3;
+    uint32_t duration = 20;
+    uint32_t min_tps = 0;
+};
+
+static bench_options parse_options(int argc, char* argv[])
+{
+    bench_options options;
+
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+
+        if(i + 1 >= argc)
+        {
+            throw std::invalid_argument("missing value of " + arg);
+        }
+
+        const std::string value = argv[++i];
+
+        if(arg == "--config")
+            options.config_path = value;
+        else if(arg == "--sessions")
+            options.sessions = std::stoul(value);
+        else if(arg == "--window")
+            options.window = std::stoul(value);
+        else if(arg == "--rate")
+            options.rate = std::stoul(value);
+        else if(arg == "--warmup")
+            options.warmup = std::stoul(value);
+        else if(arg == "--duration")
+            options.duration = std::stoul(value);
+        else if(arg == "--min-tps")
+            options.min_tps = std::stoul(value);
+        else
+            throw std::invalid_argument("unknown option " + arg);
+    }
+
+    if(options.sessions == 0 || options.window == 0 || options.duration == 0)
+    {
+        throw std::invalid_argument("sessions, window and duration must be positive");
+    }
+
+    return options;
+}
+
+/**
+ * @brief Waits for every peer to bind, then runs the warmup and the measured phase on the bench io_context.
+ */
+class bench_runner
+{
+public:
+    bench_runner(boost::asio::io_context* io_context,
+                 const bench_options& options,
+                 std::vector<std::unique_ptr<bench::smsc_simulator>>& smscs,
+                 std::vector<std::unique_ptr<bench::paper_simulator>>& papers,
+                 bench::esme_generator& esme,
+                 std::function<void()> on_finish)
+        : options_(options)
+        , smscs_(smscs)
+        , papers_(papers)
+        , esme_(esme)
+        , timer_(*io_context)
+        , on_finish_(std::move(on_finish))
+    {
+    }
+
+    void start()
+    {
+        esme_.connect();
+        do_set_timer();
+    }
+
+    bool passed() const
+    {
+        return passed_;
+    }
+
+private:
+    enum class phase
+    {
+        binding,
+        warmup,
+        measure,
+        done
+    };
+
+    static constexpr uint32_t bind_timeout = 15;
+
+    void do_set_timer()
+    {
+        timer_.expires_after(std::chrono::seconds(1));
+        timer_.async_wait([this](std::error_code ec) {
+            if(ec)
+            {
+                return;
+            }
+
+            on_timer();
+
+            if(phase_ != phase::done)
+            {
+                do_set_timer();
+            }
+        });
+    }
+
+    void on_timer()
+    {
+        elapsed_++;
+
+        switch(phase_)
+        {
+            case phase::binding:
+                if(all_bound())
+                {
+                    fmt::print("all peers are bound, warming up for {}s\n", options_.warmup);
+                    phase_ = phase::warmup;
+                    elapsed_ = 0;
+                    esme_.run();
+                }
+                else if(elapsed_ >= bind_timeout)
+                {
+                    fmt::print("peers are not bound after {}s (esme sessions {}/{})\n", bind_timeout, esme_.bound_sessions(), options_.sessions);
+                    finish();
+                }
+                break;
+
+            case phase::warmup:
+                report(esme_.take_counters());
+
+                if(elapsed_ >= options_.warmup)
+                {
+                    phase_ = phase::measure;
+                    elapsed_ = 0;
+                }
+                break;
+
+            case phase::measure:
+            {
+                auto counters = esme_.take_counters();
+                report(counters);
+
+                total_.sent += counters.sent;
+                total_.succeeded += counters.succeeded;
+                total_.failed += counters.failed;
+                total_.latency.merge(counters.latency);
+
+                if(elapsed_ >= options_.duration)
+                {
+                    summarize();
+                    finish();
+                }
+                break;
+            }
+
+            case phase::done:
+                break;
+        } //switch
+    }
+
+    bool all_bound() const
+    {
+        if(esme_.bound_sessions() < options_.sessions)
+        {
+            return false;
+        }
+
+        for(const auto& smsc : smscs_)
+        {
+            if(!smsc->bound_sessions())
+                return false;
+        }
+
+        for(const auto& paper : papers_)
+        {
+            if(!paper->bound_sessions())
+                return false;
+        }
+
+        return true;
+    }
+
+    void report(const bench::esme_generator::counters& counters) const
+    {
+        fmt::print("[{:>8}{:>4}s] tps: {:>7} failed: {:>5} in_flight: {:>6} p50: {:>6}us p99: {:>6}us p999: {:>6}us\n",
+                   phase_ == phase::warmup ? "warmup" : "measure",
+                   elapsed_,
+                   counters.succeeded + counters.failed,
+                   counters.failed,
+                   esme_.in_flight(),
+                   counters.latency.percentile(50).count(),
+                   counters.latency.percentile(99).count(),
+                   counters.latency.percentile(99.9).count());
+    }
+
+    void summarize()
+    {
+        const auto responses = total_.succeeded + total_.failed;
+        const auto tps = responses / options_.duration;
+
+        passed_ = tps >= options_.min_tps;
+
+        fmt::print("\nsessions: {} window: {} rate: {} duration: {}s\n", options_.sessions, options_.window, options_.rate ? std::to_string(options_.rate) : "unlimited", options_.duration);
+        fmt::print("sent: {} succeeded: {} failed: {}\n", total_.sent, total_.succeeded, total_.failed);
+        fmt::print("tps: {} p50: {}us p99: {}us p999: {}us max: {}us\n",
+                   tps,
+                   total_.latency.percentile(50).count(),
+                   total_.latency.percentile(99).count(),
+                   total_.latency.percentile(99.9).count(),
+                   total_.latency.max().count());
+
+        fmt::print("RESULT {{\"revision\":\"{}\",\"sessions\":{},\"window\":{},\"rate\":{},\"duration\":{},\"tps\":{},\"failed\":{},\"p50_us\":{},\"p99_us\":{},\"p999_us\":{}}}\n",
+                   GIT_REVISION,
+                   options_.sessions,
+                   options_.window,
+                   options_.rate,
+                   options_.duration,
+                   tps,
+                   total_.failed,
+                   total_.latency.percentile(50).count(),
+                   total_.latency.percentile(99).count(),
+                   total_.latency.percentile(99.9).count());
+
+        if(!passed_)
+        {
+            fmt::print("tps {} is below the required {}\n", tps, options_.min_tps);
+        }
+    }
+
+    void finish()
+    {
+        phase_ = phase::done;
+        esme_.stop();
+        on_finish_();
+    }
+
+    const bench_options& options_;
+    std::vector<std::unique_ptr<bench::smsc_simulator>>& smscs_;
+    std::vector<std::unique_ptr<bench::paper_simulator>>& papers_;
+    bench::esme_generator& esme_;
+    boost::asio::steady_timer timer_;
+    std::function<void()> on_finish_;
+
+    phase phase_ = phase::binding;
+    uint32_t elapsed_ = 0;
+    bench::esme_generator::counters total_;
+    bool passed_ = false;
+};
+
+int main(int argc, char* argv[])
+{
+    bench_options options;
+
+    try
+    {
+        options = parse_options(argc, argv);
+    }
+    catch(const std::exception& ex)
+    {
+        std::cerr << ex.what() << "\n"
+                  << "usage: smppgw-bench [--config <path>] [--sessions <n>] [--window <n>] [--rate <tps>] [--warmup <sec>] [--duration <sec>] [--min-tps <tps>]\n";
+        return 1;
+    }
+
+    auto config_manager = pa::config::manager{std::make_unique<pa::config::file_source>(options.config_path, schema)};
+    const auto config = config_manager.config();
+    const auto gateway_config = config->at("smpp_gateway");
+
+    logging log{ &config_manager, config->at("logging") };
+
+    // the simulators and the load generator share one thread, the gateway runs on the main thread
+    boost::asio::io_context bench_io_context;
+    auto work = boost::asio::make_work_guard(bench_io_context);
+
+    std::vector<std::unique_ptr<bench::smsc_simulator>> smscs;
+    std::vector<std::unique_ptr<bench::paper_simulator>> papers;
+
+    // the first simulator is named bench_smsc_0, which is the route target in bench/config.json
+    for(auto& address : gateway_config->at("network_interface")->at("address")->nodes())
+    {
+        smscs.push_back(std::make_unique<bench::smsc_simulator>(&bench_io_context, fmt::format("bench_smsc_{}", smscs.size()), address->get<std::string>()));
+    }
+
+    for(auto& address : gateway_config->at("policy")->at("address")->nodes())
+    {
+        papers.push_back(std::make_unique<bench::paper_simulator>(&bench_io_context, fmt::format("bench_paper_{}", papers.size()), address->get<std::string>()));
+    }
+
+    const auto smpp_server_config = gateway_config->at("smpp_server");
+    const auto esme_config = smpp_server_config->at("external_client")->nodes().at(0);
+
+    bench::esme_generator esme(&bench_io_context, {
+        .ip = smpp_server_config->at("ip")->get<std::string>(),
+        .port = smpp_server_config->at("port")->get<uint16_t>(),
+        .system_id = esme_config->at("system_id")->get<std::string>(),
+        .password = esme_config->at("password")->get<std::string>(),
+        .sessions = options.sessions,
+        .window = options.window,
+        .rate = options.rate,
+    });
+
+    boost::asio::io_context io_context;
+
+    auto gateway = std::make_shared<smpp_gateway>(&io_context, &config_manager, gateway_config);
+    gateway->initilize();
+    gateway->start();
+
+    auto stop_gateway = [&]() {
+        boost::asio::post(io_context, [&]() {
+            gateway->stop();
+            io_context.stop();
+        });
+    };
+
+    bench_runner runner(&bench_io_context, options, smscs, papers, esme, stop_gateway);
+    boost::asio::post(bench_io_context, [&]() { runner.start(); });
+
+    std::thread bench_thread([&]() { bench_io_context.run(); });
+
+    boost::asio::signal_set signals(io_context, SIGINT, SIGTERM);
+    signals.async_wait([&](const std::error_code& ec, int) {
+        if(!ec)
+        {
+            gateway->stop();
+            io_context.stop();
+        }
+    });
+
+    io_context.run();
+
+    boost::asio::post(bench_io_context, [&]() {
+        for(auto& smsc : smscs)
+            smsc->stop();
+
+        for(auto& paper : papers)
+            paper->stop();
+
+        work.reset();
+        bench_io_context.stop();
+    });
+
+    bench_thread.join();
+
+    return runner.passed() ? 0 : 2;
+} //main
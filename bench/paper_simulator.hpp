@@ -0,0 +1,76 @@
+#pragma once
+
+#include "paper/command.pb.h"
+
+#include <pinex/p_server.hpp>
+
+namespace bench
+{
+/**
+ * @brief PAPER stand-in, a pinex p_server which accepts every policy request with status OK.
+ *
+ * A batch envelope is answered with one OK response per request it carries.
+ */
+class paper_simulator
+{
+    pa::pinex::p_server server_;
+    std::string ok_response_;
+    size_t bound_sessions_{};
+
+  public:
+    paper_simulator(boost::asio::io_context* io_context, std::string_view system_id, const std::string& address)
+        : server_(io_context,
+                  system_id,
+                  address,
+                  10,
+                  std::bind_front(&paper_simulator::on_request, this),
+                  [](const std::string&, uint32_t, const std::string&) {},
+                  [](const std::string&, uint32_t, const std::string&) {},
+                  std::bind_front(&paper_simulator::on_session, this))
+    {
+        pa::paper::proto::Response resp;
+        resp.set_status(pa::paper::proto::OK);
+        ok_response_ = resp.SerializeAsString();
+    }
+
+    paper_simulator(const paper_simulator&) = delete;
+    paper_simulator& operator=(const paper_simulator&) = delete;
+    ~paper_simulator() = default;
+
+    void stop()
+    {
+        server_.stop();
+    }
+
+    size_t bound_sessions() const
+    {
+        return bound_sessions_;
+    }
+
+  private:
+    void on_request(const std::string& client_id, uint32_t seq_no, const std::string& msg_body)
+    {
+        pa::paper::proto::Request req;
+        if (!req.ParseFromString(msg_body) || req.batch_size() == 0)
+        {
+            server_.send_response(ok_response_, seq_no, client_id);
+            return;
+        }
+
+        pa::paper::proto::Response resp;
+        resp.set_status(pa::paper::proto::OK);
+        for (int i = 0; i < req.batch_size(); i++)
+            resp.add_batch()->set_status(pa::paper::proto::OK);
+
+        server_.send_response(resp.SerializeAsString(), seq_no, client_id);
+    }
+
+    void on_session(const std::string&, session_stat state)
+    {
+        if (state == session_stat::bind)
+            bound_sessions_++;
+        else if (state == session_stat::close && bound_sessions_)
+            bound_sessions_--;
+    }
+};
+} // namespace bench
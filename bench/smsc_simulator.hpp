@@ -0,0 +1,81 @@
+#pragma once
+
+#include "packets/Definition.pb.h"
+#include "packets/SMPP/SubmitSm.pb.h"
+
+#include <pinex/p_server.hpp>
+
+#include <cstring>
+
+namespace bench
+{
+/**
+ * @brief Boninet stand-in, a pinex p_server which answers every AO request with a successful AO response.
+ */
+class smsc_simulator
+{
+    pa::pinex::p_server server_;
+    uint64_t message_id_{};
+    size_t bound_sessions_{};
+
+  public:
+    smsc_simulator(boost::asio::io_context* io_context, std::string_view system_id, const std::string& address)
+        : server_(io_context,
+                  system_id,
+                  address,
+                  10,
+                  std::bind_front(&smsc_simulator::on_request, this),
+                  [](const std::string&, uint32_t, const std::string&) {},
+                  [](const std::string&, uint32_t, const std::string&) {},
+                  std::bind_front(&smsc_simulator::on_session, this))
+    {
+    }
+
+    smsc_simulator(const smsc_simulator&) = delete;
+    smsc_simulator& operator=(const smsc_simulator&) = delete;
+    ~smsc_simulator() = default;
+
+    void stop()
+    {
+        server_.stop();
+    }
+
+    size_t bound_sessions() const
+    {
+        return bound_sessions_;
+    }
+
+  private:
+    void on_request(const std::string& client_id, uint32_t seq_no, const std::string& msg_body)
+    {
+        uint32_t msg_type = 0;
+
+        if (msg_body.size() < sizeof(msg_type))
+            return;
+
+        std::memcpy(&msg_type, msg_body.data(), sizeof(msg_type));
+
+        if (msg_type != SMSC::Protobuf::AO_REQ_TYPE)
+            return;
+
+        SMSC::Protobuf::SMPP::Submit_Sm_Resp resp;
+        resp.set_error_code(0);
+        resp.set_md_message_id(std::to_string(++message_id_));
+
+        std::string msg(sizeof(msg_type), '\0');
+        msg_type = SMSC::Protobuf::AO_RESP_TYPE;
+        std::memcpy(msg.data(), &msg_type, sizeof(msg_type));
+        resp.AppendToString(&msg);
+
+        server_.send_response(msg, seq_no, client_id);
+    }
+
+    void on_session(const std::string&, session_stat state)
+    {
+        if (state == session_stat::bind)
+            bound_sessions_++;
+        else if (state == session_stat::close && bound_sessions_)
+            bound_sessions_--;
+    }
+};
+} // namespace bench
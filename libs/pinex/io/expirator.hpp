@@ -1,10 +1,6 @@
 #pragma once
 
-#include <boost/asio.hpp>
-
-#include <boost/bimap.hpp>
-#include <boost/bimap/unordered_multiset_of.hpp>
-#include <boost/bimap/unordered_set_of.hpp>
+#include <pinex/io/timing_wheel.hpp>
 
 #include <optional>
 
@@ -12,25 +8,29 @@ namespace pa::pinex
 {
 namespace io
 {
+/**
+ * @brief Expires keys after a timeout.
+ *
+ * Keys are kept in a hierarchical timing_wheel; all expirators with the same io_context and period
+ * are driven by one shared tick_source instead of a timer per instance.
+ */
 template<typename Tkey, typename Tinfo>
-class expirator : public std::enable_shared_from_this<expirator<Tkey, Tinfo>>
+class expirator : public tick_source::listener, public std::enable_shared_from_this<expirator<Tkey, Tinfo>>
 {
   public:
     using expiry_handler = std::function<void(Tkey, Tinfo)>;
 
   private:
-    boost::asio::steady_timer timer_;
+    const std::shared_ptr<tick_source> tick_source_;
     const std::chrono::nanoseconds period_{};
-    uint64_t index_{};
-    using bimap_t = boost::bimap<boost::bimaps::unordered_multiset_of<unsigned int>, boost::bimaps::unordered_set_of<Tkey>, boost::bimaps::with_info<Tinfo>>;
-    using value_t = typename bimap_t::value_type;
-    bimap_t index_keys_;
+    timing_wheel<Tkey, Tinfo> wheel_;
     const expiry_handler expiry_handler_{};
 
   public:
     expirator(boost::asio::io_context* io_context_ptr, std::chrono::nanoseconds period, expiry_handler handler)
-      : timer_(*io_context_ptr)
+      : tick_source_(tick_source::get(io_context_ptr, period))
       , period_(period)
+      , wheel_(tick_source_->now())
       , expiry_handler_(std::move(handler))
     {
     }
@@ -39,64 +39,54 @@ class expirator : public std::enable_shared_from_this<expirator<Tkey, Tinfo>>
     expirator& operator=(const expirator&) = delete;
     expirator(expirator&&) = delete;
     expirator& operator=(expirator&&) = delete;
-    ~expirator() = default;
+    ~expirator() override = default;
 
     void start()
     {
-        do_set_timer();
+        tick_source_->subscribe(this->weak_from_this());
     }
 
     void add(Tkey key, std::chrono::nanoseconds expiration_count)
     {
-        index_keys_.insert(value_t(index_ + expiration_count.count() / period_.count(), key));
+        add(std::move(key), expiration_count, Tinfo{});
     }
 
     void add(Tkey key, std::chrono::nanoseconds expiration_count, Tinfo info)
     {
-        index_keys_.insert(value_t(index_ + expiration_count.count() / period_.count(), key, info));
+        const auto now = tick_source_->now();
+        const bool was_empty = wheel_.empty();
+
+        /* the tick source does not tick an empty wheel, its current tick is stale */
+        if (was_empty)
+            wheel_.reset(now);
+
+        if (wheel_.add(std::move(key), now + expiration_count.count() / period_.count(), std::move(info)) && was_empty)
+            tick_source_->wake();
     }
 
     std::optional<Tinfo> get_info(Tkey key)
     {
-        auto it = index_keys_.right.find(key);
-        if (it != index_keys_.right.end())
-            return it->info;
+        if (auto* info = wheel_.get_info(key))
+            return *info;
 
         return {};
     }
 
     bool remove(Tkey key)
     {
-        return index_keys_.right.erase(key);
+        return wheel_.remove(key);
     }
 
-  private:
-    void on_timer()
+    void expire_all()
     {
-        auto range = index_keys_.left.equal_range(index_);
-        std::for_each(range.first, range.second, [this](auto const& it) {
-            expiry_handler_(it.second, it.info);
-        });
-
-        index_keys_.left.erase(index_);
-
-        index_++;
+        wheel_.expire_all(expiry_handler_);
     }
 
-    void do_set_timer()
+    bool on_tick(uint64_t tick) override
     {
-        timer_.expires_after(period_);
-        timer_.async_wait([this, wptr = this->weak_from_this()](std::error_code ec) {
-            if (!wptr.expired())
-            {
-                if (ec)
-                    throw std::runtime_error("io::expirator::async_wait() " + ec.message());
-
-                on_timer();
-                do_set_timer();
-            }
-        });
+        wheel_.advance(tick, expiry_handler_);
+        return !wheel_.empty();
     }
 };
 }  // namespace io
-}  // namespace pa::pinex
\ No newline at end of file
+}  // namespace pa::pinex
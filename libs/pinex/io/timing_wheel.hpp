@@ -0,0 +1,436 @@
+#pragma once
+
+#include <boost/asio.hpp>
+
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace pa::pinex
+{
+namespace io
+{
+/**
+ * @brief Hierarchical timing wheel with 4 levels of 256 slots, indexed by a unique key.
+ *
+ * Entries are kept in a pooled vector and chained per slot by index, keys are found through an
+ * open addressing table. add, remove and lookup are O(1) and do not allocate once the pool has grown.
+ * Deadlines are absolute ticks; advance() fires every entry whose deadline has been reached.
+ */
+template<typename Tkey, typename Tinfo>
+class timing_wheel
+{
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+    static constexpr unsigned slot_bits = 8;
+    static constexpr unsigned slot_count = 1U << slot_bits;
+    static constexpr unsigned level_count = 4;
+
+    struct node
+    {
+        Tkey key{};
+        Tinfo info{};
+        uint64_t deadline{};
+        uint32_t slot{ npos };
+        uint32_t prev{ npos };
+        uint32_t next{ npos };
+    };
+
+    std::vector<node> nodes_;
+    uint32_t free_{ npos };
+    std::vector<uint32_t> slots_ = std::vector<uint32_t>(level_count * slot_count, npos);
+    std::vector<uint32_t> table_ = std::vector<uint32_t>(16, npos);
+    size_t size_{};
+    uint64_t current_{};
+
+  public:
+    explicit timing_wheel(uint64_t current_tick = 0)
+        : current_(current_tick)
+    {
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    /**
+     * @brief moves the current tick of an empty wheel forward to @p tick.
+     *
+     * An empty wheel is not advanced by its owner, so without this the first advance() after an idle period
+     * would walk every idle tick.
+     */
+    void reset(uint64_t tick)
+    {
+        if (size_ == 0 && tick > current_)
+            current_ = tick;
+    }
+
+    /** @brief returns false if the key already exists */
+    bool add(Tkey key, uint64_t deadline, Tinfo info)
+    {
+        if (find(key) != npos)
+            return false;
+
+        if ((size_ + 1) * 2 > table_.size())
+            rehash(table_.size() * 2);
+
+        uint32_t n = allocate();
+        nodes_[n].key = std::move(key);
+        nodes_[n].info = std::move(info);
+        nodes_[n].deadline = deadline;
+
+        insert_key(n);
+        link(n);
+        size_++;
+
+        return true;
+    }
+
+    Tinfo* get_info(const Tkey& key)
+    {
+        auto n = find(key);
+        if (n == npos)
+            return nullptr;
+
+        return &nodes_[n].info;
+    }
+
+    bool remove(const Tkey& key)
+    {
+        auto n = find(key);
+        if (n == npos)
+            return false;
+
+        release(n);
+        return true;
+    }
+
+    /** @brief fires every entry with a deadline up to and including @p tick */
+    template<typename F>
+    void advance(uint64_t tick, F&& handler)
+    {
+        while (current_ <= tick)
+        {
+            if (size_ == 0)
+            {
+                current_ = tick + 1;
+                return;
+            }
+
+            for (unsigned level = level_count - 1; level > 0; level--)
+            {
+                if ((current_ & ((uint64_t{ 1 } << (level * slot_bits)) - 1)) == 0)
+                    cascade(level * slot_count + ((current_ >> (level * slot_bits)) & (slot_count - 1)));
+            }
+
+            auto& head = slots_[current_ & (slot_count - 1)];
+            while (head != npos)
+                fire(head, handler);
+
+            current_++;
+        }
+    }
+
+    template<typename F>
+    void expire_all(F&& handler)
+    {
+        for (auto& head : slots_)
+        {
+            while (head != npos)
+                fire(head, handler);
+        }
+    }
+
+  private:
+    template<typename F>
+    void fire(uint32_t n, F& handler)
+    {
+        unlink(n);
+        erase_key(n);
+
+        Tkey key = std::move(nodes_[n].key);
+        Tinfo info = std::move(nodes_[n].info);
+        recycle(n);
+
+        handler(std::move(key), std::move(info));
+    }
+
+    void cascade(uint32_t slot)
+    {
+        auto n = slots_[slot];
+        slots_[slot] = npos;
+
+        while (n != npos)
+        {
+            auto next = nodes_[n].next;
+            link(n);
+            n = next;
+        }
+    }
+
+    void link(uint32_t n)
+    {
+        auto deadline = std::max(nodes_[n].deadline, current_);
+        auto delta = deadline - current_;
+
+        unsigned level = 0;
+        while (level < level_count - 1 && delta >= (uint64_t{ 1 } << ((level + 1) * slot_bits)))
+            level++;
+
+        // deadlines beyond the last level are parked on it and re-linked when it cascades
+        if (delta >> (level_count * slot_bits))
+            deadline = current_ + (uint64_t{ 1 } << (level_count * slot_bits)) - 1;
+
+        uint32_t slot = level * slot_count + ((deadline >> (level * slot_bits)) & (slot_count - 1));
+
+        nodes_[n].slot = slot;
+        nodes_[n].prev = npos;
+        nodes_[n].next = slots_[slot];
+        if (slots_[slot] != npos)
+            nodes_[slots_[slot]].prev = n;
+        slots_[slot] = n;
+    }
+
+    void unlink(uint32_t n)
+    {
+        auto& entry = nodes_[n];
+        if (entry.prev != npos)
+            nodes_[entry.prev].next = entry.next;
+        else
+            slots_[entry.slot] = entry.next;
+
+        if (entry.next != npos)
+            nodes_[entry.next].prev = entry.prev;
+    }
+
+    uint32_t allocate()
+    {
+        if (free_ == npos)
+        {
+            nodes_.emplace_back();
+            return static_cast<uint32_t>(nodes_.size() - 1);
+        }
+
+        auto n = free_;
+        free_ = nodes_[n].next;
+        return n;
+    }
+
+    void release(uint32_t n)
+    {
+        unlink(n);
+        erase_key(n);
+        recycle(n);
+    }
+
+    void recycle(uint32_t n)
+    {
+        nodes_[n].key = Tkey{};
+        nodes_[n].info = Tinfo{};
+        nodes_[n].slot = npos;
+        nodes_[n].next = free_;
+        free_ = n;
+
+        size_--;
+    }
+
+    size_t bucket(const Tkey& key) const
+    {
+        return std::hash<Tkey>{}(key) & (table_.size() - 1);
+    }
+
+    uint32_t find(const Tkey& key) const
+    {
+        for (auto i = bucket(key);; i = (i + 1) & (table_.size() - 1))
+        {
+            if (table_[i] == npos)
+                return npos;
+
+            if (nodes_[table_[i]].key == key)
+                return table_[i];
+        }
+    }
+
+    void insert_key(uint32_t n)
+    {
+        auto i = bucket(nodes_[n].key);
+        while (table_[i] != npos)
+            i = (i + 1) & (table_.size() - 1);
+
+        table_[i] = n;
+    }
+
+    // linear probing with backward shift deletion, no tombstones
+    void erase_key(uint32_t n)
+    {
+        const auto mask = table_.size() - 1;
+
+        auto i = bucket(nodes_[n].key);
+        while (table_[i] != n)
+            i = (i + 1) & mask;
+
+        for (auto j = (i + 1) & mask; table_[j] != npos; j = (j + 1) & mask)
+        {
+            auto k = bucket(nodes_[table_[j]].key);
+            if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j))
+            {
+                table_[i] = table_[j];
+                i = j;
+            }
+        }
+
+        table_[i] = npos;
+    }
+
+    void rehash(size_t size)
+    {
+        table_.assign(size, npos);
+
+        for (uint32_t n = 0; n < nodes_.size(); n++)
+        {
+            if (nodes_[n].slot != npos)
+                insert_key(n);
+        }
+    }
+};
+
+/**
+ * @brief One steady_timer per io_context and period, shared by every expirator created on them.
+ *
+ * The timer only runs while at least one listener has pending entries.
+ */
+class tick_source : public std::enable_shared_from_this<tick_source>
+{
+  public:
+    class listener
+    {
+      public:
+        virtual ~listener() = default;
+
+        /** @brief returns true while the listener still has pending entries */
+        virtual bool on_tick(uint64_t tick) = 0;
+    };
+
+  private:
+    boost::asio::steady_timer timer_;
+    const std::chrono::nanoseconds period_{};
+    const std::chrono::steady_clock::time_point epoch_{ std::chrono::steady_clock::now() };
+
+    std::mutex mutex_;
+    std::vector<std::weak_ptr<listener>> listeners_;
+    std::vector<std::shared_ptr<listener>> active_;
+
+    bool armed_{ false };
+    bool woken_{ false };
+
+  public:
+    tick_source(boost::asio::io_context* io_context_ptr, std::chrono::nanoseconds period)
+        : timer_(*io_context_ptr)
+        , period_(period)
+    {
+    }
+
+    tick_source(const tick_source&) = delete;
+    tick_source& operator=(const tick_source&) = delete;
+    tick_source(tick_source&&) = delete;
+    tick_source& operator=(tick_source&&) = delete;
+    ~tick_source() = default;
+
+    static std::shared_ptr<tick_source> get(boost::asio::io_context* io_context_ptr, std::chrono::nanoseconds period)
+    {
+        static std::mutex mutex;
+        static std::map<std::pair<boost::asio::io_context*, std::chrono::nanoseconds::rep>, std::weak_ptr<tick_source>> sources;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::erase_if(sources, [](const auto& it) { return it.second.expired(); });
+
+        auto& weak = sources[std::make_pair(io_context_ptr, period.count())];
+        auto source = weak.lock();
+        if (!source)
+        {
+            source = std::make_shared<tick_source>(io_context_ptr, period);
+            weak = source;
+        }
+
+        return source;
+    }
+
+    uint64_t now() const
+    {
+        return static_cast<uint64_t>((std::chrono::steady_clock::now() - epoch_) / period_);
+    }
+
+    void subscribe(std::weak_ptr<listener> listener)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        listeners_.push_back(std::move(listener));
+    }
+
+    /** @brief called by a listener which had no pending entries and got one */
+    void wake()
+    {
+        boost::asio::dispatch(timer_.get_executor(), [this, self = shared_from_this()] {
+            woken_ = true;
+
+            if (!armed_)
+            {
+                armed_ = true;
+                do_set_timer();
+            }
+        });
+    }
+
+  private:
+    void on_timer()
+    {
+        woken_ = false;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::erase_if(listeners_, [this](const auto& weak) {
+                auto listener = weak.lock();
+                if (!listener)
+                    return true;
+
+                active_.push_back(std::move(listener));
+                return false;
+            });
+        }
+
+        auto tick = now();
+        bool pending = false;
+        for (auto& listener : active_)
+            pending |= listener->on_tick(tick);
+
+        active_.clear();
+
+        if (pending || woken_)
+            do_set_timer();
+        else
+            armed_ = false;
+    }
+
+    void do_set_timer()
+    {
+        // holds the source alive while armed, so it is always destroyed on its own io_context
+        timer_.expires_after(period_);
+        timer_.async_wait([this, self = shared_from_this()](std::error_code ec) {
+            if (ec)
+                throw std::runtime_error("io::tick_source::async_wait() " + ec.message());
+
+            on_timer();
+        });
+    }
+};
+}  // namespace io
+}  // namespace pa::pinex
@@ -24,6 +24,10 @@ class session : public std::enable_shared_from_this<session>
     std::function<void()> send_buf_available_handler;                                                            /* optional */
     std::function<void(const std::string&, command_id, std::span<const uint8_t>)> deserialization_error_handler; /* optional */
 
+    /* optional, takes stream_req and stream_resp in place of request_handler and response_handler,
+       the body is a view into the receive buffer which is only valid during the call */
+    std::function<void(command_id, uint32_t, command_status, std::span<const uint8_t>)> stream_handler;
+
   private:
     enum class state
     {
@@ -114,6 +118,26 @@ class session : public std::enable_shared_from_this<session>
         return sequence_number;
     }
 
+    /**
+     * Sends a stream_req whose body is written by write(std::span<uint8_t>) straight into the send buffer,
+     * body_length has to be the exact number of bytes it writes.
+     */
+    template<typename Writer>
+    uint32_t send_stream_request(size_t body_length, Writer&& write)
+    {
+        auto sequence_number = next_sequence_number();
+
+        send_stream_impl(command_id::stream_req, body_length, write, sequence_number, command_status::rok);
+
+        return sequence_number;
+    }
+
+    template<typename Writer>
+    void send_stream_response(size_t body_length, Writer&& write, uint32_t sequence_number, command_status command_status)
+    {
+        send_stream_impl(command_id::stream_resp, body_length, write, sequence_number, command_status);
+    }
+
     void set_send_buf_threshold(size_t size)
     {
         send_buf_threshold_ = size;
@@ -170,6 +194,7 @@ class session : public std::enable_shared_from_this<session>
                 sptr->send_buf_available_handler = {};
                 sptr->close_handler = {};
                 sptr->deserialization_error_handler = {};
+                sptr->stream_handler = {};
             }
         });
     }
@@ -222,7 +247,12 @@ class session : public std::enable_shared_from_this<session>
 
             auto body_buf = std::span{receive_buf_.begin() + header_length, receive_buf_.begin() + command_length};
 
-            if (is_response(command_id))
+            if (stream_handler && (command_id == command_id::stream_req || command_id == command_id::stream_resp))
+            {
+                if (state_ == state::open)
+                    stream_handler(command_id, sequence_number, command_status, body_buf);
+            }
+            else if (is_response(command_id))
             {
                 consume_response_pdu(command_id, command_status, sequence_number, body_buf);
             }
@@ -377,6 +407,39 @@ class session : public std::enable_shared_from_this<session>
         do_send();
     }
 
+    template<typename Writer>
+    void send_stream_impl(command_id command_id, size_t body_length, Writer& write, uint32_t sequence_number, command_status command_status)
+    {
+        if (state_ == state::close)
+            throw std::logic_error{"Send on closed session"};
+
+        if (state_ == state::unbinding)
+            throw std::logic_error{"Send on unbinded session"};
+
+        auto prev_size = pending_send_buf_.size();
+        auto command_length = header_length + body_length;
+
+        pending_send_buf_.resize(prev_size + command_length);
+
+        auto frame = std::span{pending_send_buf_}.subspan(prev_size, command_length);
+
+        try
+        {
+            write(frame.subspan(header_length));
+        }
+        catch (...)
+        {
+            pending_send_buf_.resize(prev_size); /* remove appended data due to incomplete serialization */
+            throw;
+        }
+
+        auto header = serialize_header(command_length, command_id, sequence_number, command_status);
+
+        std::copy(header.begin(), header.end(), frame.begin());
+
+        do_send();
+    }
+
     uint32_t send_command(command_id command_id)
     {
         auto sequence_number = next_sequence_number();
@@ -5,7 +5,9 @@
 #include <pinex/io/expirator.hpp>
 
 #include <any>
+#include <cstring>
 #include <map>
+#include <string_view>
 #include <fmt/core.h>
 
 namespace pa::pinex
@@ -21,7 +23,8 @@ class p_client : public std::enable_shared_from_this<p_client>
 
     bool auto_reconnect_;
 
-    using packet_handler_t = std::function<void(const std::string&, uint32_t, const std::string&)>;
+    /* the body is a view into the session receive buffer, valid only during the call */
+    using packet_handler_t = std::function<void(const std::string&, uint32_t, std::string_view)>;
 
     packet_handler_t request_handler_;
     packet_handler_t response_handler_;
@@ -106,6 +109,7 @@ class p_client : public std::enable_shared_from_this<p_client>
         session->response_handler = std::bind_front(&p_client::on_session_response, this, bind_resp.system_id);
         session->close_handler = std::bind_front(&p_client::on_session_close, this, bind_resp.system_id);
         session->deserialization_error_handler = std::bind_front(&p_client::on_session_deserialization_error, this);
+        session->stream_handler = std::bind_front(&p_client::on_session_stream, this, bind_resp.system_id);
         session->send_buf_available_handler = std::bind_front(&p_client::on_session_send_buf_available, this, bind_resp.system_id);
 
         server_id_ = bind_resp.system_id;
@@ -162,6 +166,26 @@ class p_client : public std::enable_shared_from_this<p_client>
         binded_session_->resume_receiving();
     }
 
+    void on_session_stream(const std::string& server_id,
+                           pa::pinex::command_id command_id,
+                           uint32_t sequence_number,
+                           [[maybe_unused]] pa::pinex::command_status command_status,
+                           std::span<const uint8_t> body)
+    {
+        std::string_view message_body{reinterpret_cast<const char*>(body.data()), body.size()};
+
+        if (command_id == pa::pinex::command_id::stream_req)
+        {
+            if (request_handler_)
+                request_handler_(server_id, sequence_number, message_body);
+            return;
+        }
+
+        packet_expirator_->remove(sequence_number);
+
+        response_handler_(server_id, sequence_number, message_body);
+    }
+
     void on_session_request(const std::string& server_id, pa::pinex::request&& req_packet, uint32_t sequence_number)
     {
         std::visit(
@@ -204,16 +228,31 @@ class p_client : public std::enable_shared_from_this<p_client>
             resp_packet);
     }
 
+    /* requests written in place keep no copy of their body, their timeout comes with an empty one */
     void on_session_timeout(uint32_t sequence_number, std::any user_data)
     {
-        auto sm = std::any_cast<pa::pinex::stream_request>(user_data);
-        timeout_handler_(server_id_, sequence_number, sm.message_body);
+        auto* message_body = std::any_cast<std::string>(&user_data);
+        timeout_handler_(server_id_, sequence_number, message_body ? std::string_view{*message_body} : std::string_view{});
+    }
+
+    static auto copy_writer(std::string_view msg)
+    {
+        return [msg](std::span<uint8_t> out) { std::memcpy(out.data(), msg.data(), msg.size()); };
     }
 
   public:
-    uint32_t send_response(const std::string& msg, uint32_t seq_no)
+    uint32_t send_response(std::string_view msg, uint32_t seq_no)
     {
-        binded_session_->send_response(pa::pinex::stream_response{.message_body = msg}, seq_no, pa::pinex::command_status::rok);
+        return send_response(msg.size(), copy_writer(msg), seq_no);
+    }
+
+    /**
+     * write(std::span<uint8_t>) serializes exactly length bytes of the body straight into the send buffer.
+     */
+    template<typename Writer>
+    uint32_t send_response(size_t length, Writer&& write, uint32_t seq_no)
+    {
+        binded_session_->send_stream_response(length, std::forward<Writer>(write), seq_no, pa::pinex::command_status::rok);
 
         // if (binded_session_->is_send_buf_above_threshold())
         // {
@@ -224,13 +263,21 @@ class p_client : public std::enable_shared_from_this<p_client>
         return seq_no;
     }
 
-    uint32_t send_request(const std::string& msg)
+    uint32_t send_request(std::string_view msg)
     {
-        pa::pinex::stream_request pdu{.message_body = msg};
+        auto seq_no = binded_session_->send_stream_request(msg.size(), copy_writer(msg));
+
+        packet_expirator_->add(seq_no, timeout_sec_, std::string{msg});
 
-        auto seq_no = binded_session_->send_request(pdu);
+        return seq_no;
+    }
 
-        packet_expirator_->add(seq_no, timeout_sec_, pdu);
+    template<typename Writer>
+    uint32_t send_request(size_t length, Writer&& write)
+    {
+        auto seq_no = binded_session_->send_stream_request(length, std::forward<Writer>(write));
+
+        packet_expirator_->add(seq_no, timeout_sec_);
 
         // if (binded_session_->is_send_buf_above_threshold())
         // {
@@ -241,11 +288,9 @@ class p_client : public std::enable_shared_from_this<p_client>
         return seq_no;
     }
 
-    uint32_t send_info(const std::string& msg)
+    uint32_t send_info(std::string_view msg)
     {
-        pa::pinex::stream_request pdu{.message_body = msg};
-
-        auto seq_no = binded_session_->send_request(pdu);
+        auto seq_no = binded_session_->send_stream_request(msg.size(), copy_writer(msg));
 
         // if (binded_session_->is_send_buf_above_threshold())
         // {
@@ -4,6 +4,7 @@
 
 #include <fmt/core.h>
 #include <map>
+#include <string_view>
 
 namespace pa::pinex
 {
@@ -14,7 +15,7 @@ class p_client_list
     //this use to prevent shared_ptr from deleting
     std::set<std::shared_ptr<pa::pinex::p_client>> p_client_list_;
 
-    using packet_handler_t = std::function<void(const std::string&, uint32_t, const std::string&)>;
+    using packet_handler_t = std::function<void(const std::string&, uint32_t, std::string_view)>;
     using session_handler_t = std::function<void(const std::string&, session_stat)>;
 
     int last_index_;
@@ -79,7 +80,7 @@ class p_client_list
 
   public:
     //TODO: change return value type
-    uint32_t send_response(const std::string& msg, uint32_t seq_no, const std::string& id)
+    uint32_t send_response(std::string_view msg, uint32_t seq_no, const std::string& id)
     {
         try
         {
@@ -97,7 +98,27 @@ class p_client_list
         return 0;
     }
 
-    uint32_t send_request(const std::string& msg, const std::string& id)
+    /* write(std::span<uint8_t>) serializes exactly length bytes of the body straight into the send buffer */
+    template<typename Writer>
+    uint32_t send_response(size_t length, Writer&& write, uint32_t seq_no, const std::string& id)
+    {
+        try
+        {
+            auto clnt = binded_clients_.at(id);
+            clnt->send_response(length, std::forward<Writer>(write), seq_no);
+
+            return seq_no;
+        }
+        catch (const std::out_of_range& e)
+        {
+            fmt::print("could not find connection with id {}\n", id);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    uint32_t send_request(std::string_view msg, const std::string& id)
     {
         try
         {
@@ -114,7 +135,25 @@ class p_client_list
         return 0;
     }
 
-    std::tuple<uint32_t, std::string> send_request(const std::string& msg)
+    template<typename Writer>
+    uint32_t send_request(size_t length, Writer&& write, const std::string& id)
+    {
+        try
+        {
+            auto clnt = binded_clients_.at(id);
+            auto seq_no = clnt->send_request(length, std::forward<Writer>(write));
+
+            return seq_no;
+        }
+        catch (const std::exception& e)
+        {
+            fmt::print("could not find connection with id {}\n", id);
+        }
+
+        return 0;
+    }
+
+    std::tuple<uint32_t, std::string> send_request(std::string_view msg)
     {
         if (binded_clients_.size() > 0)
         {
@@ -131,7 +170,7 @@ class p_client_list
         return {0, ""};
     }
 
-    uint32_t broad_cast(const std::string& msg)
+    uint32_t broad_cast(std::string_view msg)
     {
         for (auto&& itr : binded_clients_)
         {
@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <span>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 
@@ -91,6 +93,10 @@ struct smart
     }
 };
 
+/**
+ * Octet strings deserialize into the member's type: `std::string` copies the bytes, `std::string_view`
+ * refers into the received buffer (see the *_view PDUs).
+ */
 template<size_t MAXLEN>
 struct c_octet_str
 {
@@ -102,7 +108,7 @@ struct c_octet_str
         if (null_pos == buf->end())
             throw std::length_error{ "c_octet_str can't find null character, field_name:" + std::string{ name } };
 
-        auto str = std::string{ buf->begin(), null_pos };
+        auto str = T{ reinterpret_cast<const char*>(buf->data()), static_cast<size_t>(null_pos - buf->begin()) };
 
         if (str.size() >= MAXLEN)
             throw std::length_error{ "c_octet_str exceed its limit, field_name:" + std::string{ name } };
@@ -136,7 +142,7 @@ struct u8_octet_str
         if (buf->size() <= length)
             throw std::length_error{ "octet_str buf is smaller than its length field, field_name:" + std::string{ name } };
 
-        auto str = std::string{ buf->begin() + 1, buf->begin() + length + 1 }; // One for length field
+        auto str = T{ reinterpret_cast<const char*>(buf->data()) + 1, length }; // One for length field
 
         if (str.size() > MAXLEN)
             throw std::length_error{ "octet_str exceed its limit, field_name:" + std::string{ name } };
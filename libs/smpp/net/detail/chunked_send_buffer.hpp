@@ -0,0 +1,133 @@
+#pragma once
+
+#include <boost/asio/buffer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace pa::smpp::detail
+{
+/**
+ * Outgoing bytes kept in fixed-size chunks which are recycled through a small pool.
+ *
+ * Appending never moves bytes which are already queued, and one write hands the whole chunk list to the
+ * socket as a scatter-gather buffer sequence (writev), so many PDUs go out in a single syscall.
+ */
+template<std::size_t ChunkSize>
+class chunked_send_buffer
+{
+    struct chunk
+    {
+        std::array<uint8_t, ChunkSize> data;
+        std::size_t size{};
+    };
+
+    static constexpr std::size_t max_buffers_per_write{ 64 };
+    static constexpr std::size_t max_pooled_chunks{ 16 };
+
+    std::deque<std::unique_ptr<chunk>> pending_;
+    std::vector<std::unique_ptr<chunk>> writing_;
+    std::vector<std::unique_ptr<chunk>> pool_;
+    std::vector<boost::asio::const_buffer> buffers_;
+    std::size_t pending_size_{ 0 };
+    std::size_t writing_size_{ 0 };
+
+  public:
+    chunked_send_buffer() = default;
+    chunked_send_buffer(const chunked_send_buffer&) = delete;
+    chunked_send_buffer& operator=(const chunked_send_buffer&) = delete;
+    chunked_send_buffer(chunked_send_buffer&&) = delete;
+    chunked_send_buffer& operator=(chunked_send_buffer&&) = delete;
+    ~chunked_send_buffer() = default;
+
+    void append(std::span<const uint8_t> data)
+    {
+        while (!data.empty())
+        {
+            if (pending_.empty() || pending_.back()->size == ChunkSize)
+                pending_.push_back(acquire());
+
+            auto& c = *pending_.back();
+            auto n = std::min(ChunkSize - c.size, data.size());
+
+            std::memcpy(c.data.data() + c.size, data.data(), n);
+            c.size += n;
+            pending_size_ += n;
+
+            data = data.subspan(n);
+        }
+    }
+
+    std::size_t pending_size() const
+    {
+        return pending_size_;
+    }
+
+    std::size_t writing_size() const
+    {
+        return writing_size_;
+    }
+
+    bool is_writing() const
+    {
+        return !writing_.empty();
+    }
+
+    bool empty() const
+    {
+        return pending_.empty() && writing_.empty();
+    }
+
+    /** Moves the queued chunks into the writing set and returns them as one buffer sequence. */
+    const std::vector<boost::asio::const_buffer>& start_write()
+    {
+        buffers_.clear();
+
+        while (!pending_.empty() && writing_.size() < max_buffers_per_write)
+        {
+            auto& c = pending_.front();
+
+            buffers_.emplace_back(c->data.data(), c->size);
+            writing_size_ += c->size;
+            pending_size_ -= c->size;
+
+            writing_.push_back(std::move(c));
+            pending_.pop_front();
+        }
+
+        return buffers_;
+    }
+
+    /** Recycles the chunks of the finished write. */
+    void finish_write()
+    {
+        for (auto& c : writing_)
+        {
+            if (pool_.size() < max_pooled_chunks)
+            {
+                c->size = 0;
+                pool_.push_back(std::move(c));
+            }
+        }
+
+        writing_.clear();
+        writing_size_ = 0;
+    }
+
+  private:
+    std::unique_ptr<chunk> acquire()
+    {
+        if (pool_.empty())
+            return std::make_unique<chunk>();
+
+        auto c = std::move(pool_.back());
+        pool_.pop_back();
+        return c;
+    }
+};
+} // namespace pa::smpp::detail
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <smpp/common.hpp>
+#include <smpp/net/detail/chunked_send_buffer.hpp>
 #include <smpp/net/detail/flat_buffer.hpp>
 #include <smpp/pdu.hpp>
 
@@ -21,6 +22,7 @@ class session : public std::enable_shared_from_this<session>
   public:
     std::function<void(std::shared_ptr<session>, std::optional<std::string>)> close_handler;                                               /* required */
     std::function<void(std::shared_ptr<session>, request&&, uint32_t)> request_handler;                                                    /* optional */
+    std::function<void(std::shared_ptr<session>, const submit_sm_view&, uint32_t)> submit_sm_view_handler;                                 /* optional, replaces request_handler for submit_sm */
     std::function<void(std::shared_ptr<session>, response&&, uint32_t, command_status)> response_handler;                                  /* optional */
     std::function<void(std::shared_ptr<session>)> send_buf_available_handler;                                                              /* optional */
     std::function<void(std::shared_ptr<session>, const std::string&, command_id, std::span<const uint8_t>)> deserialization_error_handler; /* optional */
@@ -57,11 +59,14 @@ class session : public std::enable_shared_from_this<session>
     boost::asio::steady_timer inactivity_timer_;
     boost::asio::steady_timer enquirelink_timer_;
 
-    std::vector<uint8_t> writing_send_buf_;
-    std::vector<uint8_t> pending_send_buf_;
+    std::vector<uint8_t> encode_buf_; /* one PDU at a time, keeps its capacity */
+    detail::chunked_send_buffer<16 * 1024> send_buf_;
     size_t send_buf_threshold_{ 1024 * 1024 };
     detail::flat_buffer<uint8_t, 1024 * 1024> receive_buf_{};
 
+    boost::asio::io_context* transfer_io_context_{ nullptr };
+    std::function<void(std::shared_ptr<session>)> transfer_handler_;
+
   public:
     explicit session(boost::asio::ip::tcp::socket socket,
                      uint32_t inactivity_threshold,
@@ -146,7 +151,27 @@ class session : public std::enable_shared_from_this<session>
 
     bool is_send_buf_above_threshold() const
     {
-        return pending_send_buf_.size() > send_buf_threshold_;
+        return send_buf_.pending_size() > send_buf_threshold_;
+    }
+
+    /**
+     * Moves the connection to a new session that runs on `io_context`.
+     *
+     * Receiving is paused and pending writes are flushed first; then the socket and any bytes
+     * already received are handed to a new (not yet started) session which is passed to `handler`.
+     * This session is closed silently afterwards, none of its handlers are invoked anymore.
+     * `handler` is invoked on this session's executor.
+     */
+    void transfer(boost::asio::io_context* io_context, std::function<void(std::shared_ptr<session>)> handler)
+    {
+        if (state_ != state::open)
+            throw std::logic_error{ "Transfer on a session which is not open" };
+
+        transfer_io_context_ = io_context;
+        transfer_handler_ = std::move(handler);
+
+        pause_receiving();
+        do_transfer();
     }
 
     void pause_receiving()
@@ -189,6 +214,7 @@ class session : public std::enable_shared_from_this<session>
             if(sptr)
             {
                 sptr->request_handler = {};
+                sptr->submit_sm_view_handler = {};
                 sptr->response_handler = {};
                 sptr->send_buf_available_handler = {};
                 sptr->close_handler = {};
@@ -282,6 +308,7 @@ class session : public std::enable_shared_from_this<session>
         if (receiving_state_ == receiving_state::pending_pause)
         {
             receiving_state_ = receiving_state::paused;
+            do_transfer();
             return;
         }
 
@@ -362,6 +389,7 @@ class session : public std::enable_shared_from_this<session>
     void consume_request_pdu(command_id command_id, command_status /* command_status */, uint32_t sequence_number, std::span<const uint8_t> buf)
     {
         request req;
+        std::optional<submit_sm_view> submit_view;
 
         try
         {
@@ -388,7 +416,10 @@ class session : public std::enable_shared_from_this<session>
                     req = deserialize<query_sm>(buf);
                     break;
                 case command_id::submit_sm:
-                    req = deserialize<submit_sm>(buf);
+                    if (submit_sm_view_handler)
+                        submit_view = deserialize<submit_sm_view>(buf);
+                    else
+                        req = deserialize<submit_sm>(buf);
                     break;
                 case command_id::deliver_sm:
                     req = deserialize<deliver_sm>(buf);
@@ -418,6 +449,10 @@ class session : public std::enable_shared_from_this<session>
 
         if (req.index() != 0 && state_ == state::open && request_handler)
             request_handler(shared_from_this(), std::move(req), sequence_number);
+
+        // buf stays valid until do_receive() consumes this pdu after we return
+        if (submit_view && state_ == state::open && submit_sm_view_handler)
+            submit_sm_view_handler(shared_from_this(), *submit_view, sequence_number);
     }
 
     template<typename PDU>
@@ -429,26 +464,18 @@ class session : public std::enable_shared_from_this<session>
         if (state_ == state::unbinding)
             throw std::logic_error{ "Send on unbinding session" };
 
-        auto prev_size = pending_send_buf_.size();
-
         /* reserver for header (because we don't know command length before serializing the PDU) */
-        pending_send_buf_.resize(prev_size + header_length);
+        encode_buf_.resize(header_length);
 
-        try
-        {
-            serialize_to(&pending_send_buf_, pdu);
-        }
-        catch (...)
-        {
-            pending_send_buf_.resize(prev_size); /* remove appended data due to incomplete serialization */
-            throw;
-        }
+        serialize_to(&encode_buf_, pdu); /* nothing has been queued yet if it throws */
 
-        auto command_length = pending_send_buf_.size() - prev_size;
+        auto command_length = encode_buf_.size();
 
         auto header = serialize_header(command_length, detail::command_id_of(pdu), sequence_number, cmd_status);
 
-        std::copy(header.begin(), header.end(), pending_send_buf_.begin() + static_cast<std::ptrdiff_t>(prev_size));
+        std::copy(header.begin(), header.end(), encode_buf_.begin());
+
+        send_buf_.append(encode_buf_);
 
         do_send();
     }
@@ -466,36 +493,85 @@ class session : public std::enable_shared_from_this<session>
     {
         auto header = serialize_header(header_length, command_id, sequence_number, cmd_status);
 
-        pending_send_buf_.insert(pending_send_buf_.end(), header.begin(), header.end());
+        send_buf_.append(header);
 
         do_send();
     }
 
     void do_send()
     {
-        if (!writing_send_buf_.empty())
+        if (send_buf_.is_writing())
             return; /* ongoing async_write would call this function after it finished */
 
-        std::swap(writing_send_buf_, pending_send_buf_);
+        auto was_above_threshold = is_send_buf_above_threshold();
 
-        /* if pending_send_buf_ has been above the threshold, notify it becomes available again */
-        if (writing_send_buf_.size() > send_buf_threshold_ && send_buf_available_handler)
+        /* all queued PDUs go out in one scatter-gather write */
+        const auto& buffers = send_buf_.start_write();
+
+        /* if pending part of send_buf_ has been above the threshold, notify it becomes available again */
+        if (was_above_threshold && !is_send_buf_above_threshold() && send_buf_available_handler)
             send_buf_available_handler(shared_from_this());
 
-        boost::asio::async_write(socket_, boost::asio::buffer(writing_send_buf_), [this, wptr = weak_from_this()](std::error_code ec, size_t) {
+        boost::asio::async_write(socket_, buffers, [this, wptr = weak_from_this()](std::error_code ec, size_t) {
             if (wptr.expired())
                 return;
 
             if (ec)
                 return close(ec.message());
 
-            writing_send_buf_.clear();
+            send_buf_.finish_write();
 
-            if (!pending_send_buf_.empty())
+            if (send_buf_.pending_size() != 0)
                 do_send();
+            else
+                do_transfer();
         });
     }
 
+    void do_transfer()
+    {
+        if (!transfer_handler_ || state_ != state::open)
+            return;
+
+        /* wait until the receive loop is stopped and everything has been written */
+        if (receiving_state_ != receiving_state::paused || !send_buf_.empty())
+            return;
+
+        auto handler = std::exchange(transfer_handler_, {});
+
+        boost::system::error_code ec;
+        const auto protocol = socket_.local_endpoint(ec).protocol();
+        if (ec)
+            return close(ec.message());
+
+        state_ = state::close;
+
+        request_handler = {};
+        submit_sm_view_handler = {};
+        response_handler = {};
+        send_buf_available_handler = {};
+        close_handler = {};
+        deserialization_error_handler = {};
+
+        inactivity_timer_.cancel();
+        enquirelink_timer_.cancel();
+
+        auto native_handle = socket_.release(ec);
+        if (ec)
+            return;
+
+        auto next = std::make_shared<session>(
+            boost::asio::ip::tcp::socket{ *transfer_io_context_, protocol, native_handle },
+            inactivity_threshold_,
+            enquirelink_threshold_);
+
+        next->sequence_number_ = sequence_number_;
+        next->send_buf_threshold_ = send_buf_threshold_;
+        next->receive_buf_.commit(boost::asio::buffer_copy(next->receive_buf_.prepare(receive_buf_.size()), receive_buf_.data()));
+
+        handler(std::move(next));
+    }
+
     static bool is_response(command_id command_id)
     {
         return static_cast<uint32_t>(command_id) & 0x80000000;
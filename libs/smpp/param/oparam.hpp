@@ -4,7 +4,9 @@
 
 #include <map>
 #include <memory>
+#include <optional>
 #include <span>
+#include <string_view>
 #include <vector>
 
 namespace pa::smpp
@@ -95,4 +97,90 @@ class oparam
         oparam_[tag] = static_cast<uint8_t>(val);
     }
 };
-} // namespace pa::smpp
\ No newline at end of file
+
+/**
+ * Optional parameters of a received PDU, referring into the receive buffer.
+ *
+ * The TLVs are validated on construction but not copied; lookups scan them linearly, which is cheaper
+ * than building a map for the handful of parameters a PDU carries.
+ */
+class oparam_view
+{
+    std::span<const uint8_t> buf_;
+
+    static uint16_t deserialize_u16(std::span<const uint8_t, 2> data)
+    {
+        return data[0] << 8 | data[1];
+    }
+
+    template<typename F>
+    void for_each(F&& f) const
+    {
+        for (auto buf = buf_; buf.size() >= 4;)
+        {
+            auto constexpr header_length = 4;
+            auto tag = static_cast<oparam_tag>(deserialize_u16(buf.subspan<0, 2>()));
+            auto val_length = deserialize_u16(buf.subspan<2, 2>());
+            auto val_buf = buf.subspan(header_length, val_length);
+
+            if (f(tag, std::string_view{ reinterpret_cast<const char*>(val_buf.data()), val_buf.size() }))
+                return;
+
+            buf = buf.last(buf.size() - (val_length + header_length));
+        }
+    }
+
+  public:
+    oparam_view() = default;
+
+    explicit oparam_view(std::span<const uint8_t>* buf)
+        : buf_(*buf)
+    {
+        while (buf->size() >= 4)
+        {
+            auto constexpr header_length = 4;
+            auto val_length = deserialize_u16(buf->subspan<2, 2>());
+
+            if (val_length > buf->size() - header_length)
+                throw std::length_error{ "oparam val length is bigger than available buf" };
+
+            *buf = buf->last(buf->size() - (val_length + header_length));
+        }
+
+        buf_ = buf_.first(buf_.size() - buf->size());
+    }
+
+    bool contains(oparam_tag tag) const
+    {
+        bool found = false;
+        for_each([&](oparam_tag t, std::string_view) { return found = (t == tag); });
+        return found;
+    }
+
+    std::string_view get_as_string(oparam_tag tag) const
+    {
+        std::optional<std::string_view> val;
+        for_each([&](oparam_tag t, std::string_view v) {
+            if (t == tag)
+                val = v;
+            return val.has_value();
+        });
+
+        if (!val)
+            throw std::logic_error{ "oparam doesn't exist" };
+        return *val;
+    }
+
+    /** Copies the parameters; like oparam's constructor the first one wins if a tag is repeated. */
+    oparam to_oparam() const
+    {
+        oparam result;
+        for_each([&](oparam_tag t, std::string_view v) {
+            if (!result.contains(t))
+                result.set_as_string(t, std::string{ v });
+            return false;
+        });
+        return result;
+    }
+};
+} // namespace pa::smpp
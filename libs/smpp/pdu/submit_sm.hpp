@@ -29,6 +29,54 @@ struct submit_sm
     bool operator==(const submit_sm&) const = default;
 };
 
+/**
+ * submit_sm decoded without copying: strings and optional parameters refer into the session's receive
+ * buffer and are only valid during the handler invocation which receives the view.
+ */
+struct submit_sm_view
+{
+    std::string_view service_type{};
+    smpp::ton source_addr_ton{ ton::unknown };
+    smpp::npi source_addr_npi{ npi::unknown };
+    std::string_view source_addr{};
+    smpp::ton dest_addr_ton{ ton::unknown };
+    smpp::npi dest_addr_npi{ npi::unknown };
+    std::string_view dest_addr{};
+    smpp::esm_class esm_class{};
+    uint8_t protocol_id{};
+    smpp::priority_flag priority_flag{ priority_flag::gsm_non_priority };
+    std::string_view schedule_delivery_time{};
+    std::string_view validity_period{};
+    smpp::registered_delivery registered_delivery{};
+    smpp::replace_if_present_flag replace_if_present_flag{ replace_if_present_flag::no };
+    smpp::data_coding data_coding{ data_coding::defaults };
+    uint8_t sm_default_msg_id{};
+    std::string_view short_message{};
+    smpp::oparam_view oparam{};
+
+    submit_sm to_submit_sm() const
+    {
+        return submit_sm{ .service_type = std::string{ service_type },
+                          .source_addr_ton = source_addr_ton,
+                          .source_addr_npi = source_addr_npi,
+                          .source_addr = std::string{ source_addr },
+                          .dest_addr_ton = dest_addr_ton,
+                          .dest_addr_npi = dest_addr_npi,
+                          .dest_addr = std::string{ dest_addr },
+                          .esm_class = esm_class,
+                          .protocol_id = protocol_id,
+                          .priority_flag = priority_flag,
+                          .schedule_delivery_time = std::string{ schedule_delivery_time },
+                          .validity_period = std::string{ validity_period },
+                          .registered_delivery = registered_delivery,
+                          .replace_if_present_flag = replace_if_present_flag,
+                          .data_coding = data_coding,
+                          .sm_default_msg_id = sm_default_msg_id,
+                          .short_message = std::string{ short_message },
+                          .oparam = oparam.to_oparam() };
+    }
+};
+
 namespace detail
 {
 inline auto command_id_of(const submit_sm&)
@@ -59,5 +107,29 @@ inline consteval auto members<submit_sm>()
                        meta<u8_octet_str<254>>(&o::short_message, "short_message"),
                        meta<smart>(&o::oparam, "oparam") };
 }
+
+template<>
+inline consteval auto members<submit_sm_view>()
+{
+    using o = submit_sm_view;
+    return std::tuple{ meta<c_octet_str<6>>(&o::service_type, "service_type"),
+                       meta<enum_u8>(&o::source_addr_ton, "source_addr_ton"),
+                       meta<enum_u8>(&o::source_addr_npi, "source_addr_npi"),
+                       meta<c_octet_str<21>>(&o::source_addr, "source_addr"),
+                       meta<enum_u8>(&o::dest_addr_ton, "dest_addr_ton"),
+                       meta<enum_u8>(&o::dest_addr_npi, "dest_addr_npi"),
+                       meta<c_octet_str<21>>(&o::dest_addr, "dest_addr"),
+                       meta<enum_flag>(&o::esm_class, "esm_class"),
+                       meta<u8>(&o::protocol_id, "protocol_id"),
+                       meta<enum_u8>(&o::priority_flag, "priority_flag"),
+                       meta<c_octet_str<17>>(&o::schedule_delivery_time, "schedule_delivery_time"),
+                       meta<c_octet_str<17>>(&o::validity_period, "validity_period"),
+                       meta<enum_flag>(&o::registered_delivery, "registered_delivery"),
+                       meta<enum_u8>(&o::replace_if_present_flag, "replace_if_present_flag"),
+                       meta<enum_u8>(&o::data_coding, "data_coding"),
+                       meta<u8>(&o::sm_default_msg_id, "sm_default_msg_id"),
+                       meta<u8_octet_str<254>>(&o::short_message, "short_message"),
+                       meta<smart>(&o::oparam, "oparam") };
+}
 } // namespace detail
 } // namespace pa::smpp
\ No newline at end of file
@@ -109,7 +109,7 @@ class user_data_header
     }
 };
 
-inline std::pair<user_data_header, std::string> unpack_short_message(esm_class esm_class, data_coding data_coding, const std::string& short_message)
+inline std::pair<user_data_header, std::string> unpack_short_message(esm_class esm_class, data_coding data_coding, std::string_view short_message)
 {
     if (extract_unicode(data_coding) == data_coding_unicode::ascii_8_bit && short_message.length() > 160)
         throw std::runtime_error{ "unpacking short_message failed, short_message length is larger than 160" };
@@ -119,15 +119,18 @@ inline std::pair<user_data_header, std::string> unpack_short_message(esm_class e
 
     if (esm_class.gsm_network_features == gsm_network_features::udhi || esm_class.gsm_network_features == gsm_network_features::both)
     {
+        if (short_message.empty())
+            throw std::runtime_error{ "unpacking short_message failed, UDH lenght is larger than short_message" };
+
         const auto udh_length = static_cast<uint8_t>(short_message[0]);
 
         if (udh_length >= short_message.length())
             throw std::runtime_error{ "unpacking short_message failed, UDH lenght is larger than short_message" };
 
-        return { user_data_header{ short_message.substr(1, udh_length) }, short_message.substr(1 + udh_length) };
+        return { user_data_header{ short_message.substr(1, udh_length) }, std::string{ short_message.substr(1 + udh_length) } };
     }
 
-    return { user_data_header{}, short_message };
+    return { user_data_header{}, std::string{ short_message } };
 }
 
 inline std::string pack_short_message(const user_data_header& user_data_header, std::string_view body, data_coding data_coding)
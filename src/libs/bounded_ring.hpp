@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+namespace io
+{
+/**
+ * @brief Bounded lock-free multi-producer multi-consumer queue (D. Vyukov's sequence-per-cell ring).
+ *
+ * try_push() and try_pop() never block and never allocate; a full ring makes try_push() fail so the
+ * caller decides what to drop.
+ */
+template<typename T>
+class bounded_ring
+{
+  public:
+    explicit bounded_ring(size_t capacity)
+        : mask_(round_up(capacity) - 1)
+        , cells_(std::make_unique<cell[]>(mask_ + 1))
+    {
+        for (size_t i = 0; i <= mask_; i++)
+            cells_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+
+    bounded_ring(const bounded_ring&) = delete;
+    bounded_ring& operator=(const bounded_ring&) = delete;
+    bounded_ring(bounded_ring&&) = delete;
+    bounded_ring& operator=(bounded_ring&&) = delete;
+    ~bounded_ring() = default;
+
+    bool try_push(T&& value)
+    {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            cell& c = cells_[pos & mask_];
+            size_t sequence = c.sequence_.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (diff == 0)
+            {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    c.value_ = std::move(value);
+                    c.sequence_.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(T& value)
+    {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+
+        while (true)
+        {
+            cell& c = cells_[pos & mask_];
+            size_t sequence = c.sequence_.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+            if (diff == 0)
+            {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    value = std::move(c.value_);
+                    c.sequence_.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // empty
+            }
+            else
+            {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t capacity() const
+    {
+        return mask_ + 1;
+    }
+
+  private:
+    static size_t round_up(size_t capacity)
+    {
+        if (capacity < 2)
+            throw std::invalid_argument("io::bounded_ring capacity must be at least 2");
+
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+
+        return size;
+    }
+
+    struct cell
+    {
+        std::atomic<size_t> sequence_;
+        T value_;
+    };
+
+    static constexpr size_t cache_line_size_ = 64;
+
+    const size_t mask_;
+    const std::unique_ptr<cell[]> cells_;
+    alignas(cache_line_size_) std::atomic<size_t> enqueue_pos_{ 0 };
+    alignas(cache_line_size_) std::atomic<size_t> dequeue_pos_{ 0 };
+};
+} // namespace io
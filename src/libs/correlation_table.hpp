@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace io
+{
+/**
+ * @brief In-flight requests keyed by (connection, sequence number).
+ *
+ * Connection names are interned once into a small index, so a key is a packed 64-bit value and neither
+ * insert nor take formats or hashes a string. Entries live in a flat open addressing table preallocated
+ * for `max_in_flight` entries; it only grows if more requests than that are outstanding.
+ * Sequence number 0 is never used by pinex, key 0 marks an empty slot.
+ */
+template<typename T>
+class correlation_table
+{
+  public:
+    explicit correlation_table(size_t max_in_flight = 4096)
+        : slots_(std::bit_ceil(std::max<size_t>(max_in_flight * 2, 16)))
+    {
+    }
+
+    bool insert(const std::string& connection, uint32_t sequence_number, T value)
+    {
+        if ((size_ + 1) * 2 > slots_.size())
+            rehash(slots_.size() * 2);
+
+        const auto key = make_key(intern(connection), sequence_number);
+
+        for (auto i = bucket(key);; i = (i + 1) & (slots_.size() - 1))
+        {
+            if (slots_[i].key == key)
+                return false;
+
+            if (slots_[i].key == 0)
+            {
+                slots_[i].key = key;
+                slots_[i].value = std::move(value);
+                size_++;
+                return true;
+            }
+        }
+    }
+
+    /** @brief removes and returns the entry, nothing if it is unknown (already answered or expired) */
+    std::optional<T> take(const std::string& connection, uint32_t sequence_number)
+    {
+        const auto connection_index = find_connection(connection);
+        if (!connection_index)
+            return {};
+
+        const auto key = make_key(*connection_index, sequence_number);
+
+        for (auto i = bucket(key);; i = (i + 1) & (slots_.size() - 1))
+        {
+            if (slots_[i].key == 0)
+                return {};
+
+            if (slots_[i].key == key)
+            {
+                std::optional<T> result{ std::move(slots_[i].value) };
+                erase(i);
+                return result;
+            }
+        }
+    }
+
+    /** @brief the entry if it is still in flight, the pointer is valid until the next insert or take */
+    T* find(const std::string& connection, uint32_t sequence_number)
+    {
+        const auto connection_index = find_connection(connection);
+        if (!connection_index)
+            return nullptr;
+
+        const auto key = make_key(*connection_index, sequence_number);
+
+        for (auto i = bucket(key);; i = (i + 1) & (slots_.size() - 1))
+        {
+            if (slots_[i].key == 0)
+                return nullptr;
+
+            if (slots_[i].key == key)
+                return &slots_[i].value;
+        }
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+  private:
+    struct slot
+    {
+        uint64_t key{};
+        T value{};
+    };
+
+    static uint64_t make_key(uint32_t connection_index, uint32_t sequence_number)
+    {
+        return (uint64_t{ connection_index } << 32) | sequence_number;
+    }
+
+    size_t bucket(uint64_t key) const
+    {
+        // fibonacci hashing, spreads consecutive sequence numbers over the table
+        return (key * 0x9E3779B97F4A7C15ULL) >> (64 - std::countr_zero(slots_.size()));
+    }
+
+    // a handful of peers per client list, a linear scan beats hashing the name
+    std::optional<uint32_t> find_connection(const std::string& connection) const
+    {
+        for (uint32_t i = 0; i < connections_.size(); i++)
+        {
+            if (connections_[i] == connection)
+                return i;
+        }
+
+        return {};
+    }
+
+    uint32_t intern(const std::string& connection)
+    {
+        if (auto index = find_connection(connection))
+            return *index;
+
+        connections_.push_back(connection);
+        return static_cast<uint32_t>(connections_.size() - 1);
+    }
+
+    // linear probing with backward shift deletion, no tombstones
+    void erase(size_t i)
+    {
+        const auto mask = slots_.size() - 1;
+
+        for (auto j = (i + 1) & mask; slots_[j].key != 0; j = (j + 1) & mask)
+        {
+            auto k = bucket(slots_[j].key);
+            if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j))
+            {
+                slots_[i] = std::move(slots_[j]);
+                i = j;
+            }
+        }
+
+        slots_[i].key = 0;
+        slots_[i].value = T{};
+        size_--;
+    }
+
+    void rehash(size_t size)
+    {
+        auto old = std::exchange(slots_, std::vector<slot>(size));
+
+        for (auto& s : old)
+        {
+            if (s.key == 0)
+                continue;
+
+            auto i = bucket(s.key);
+            while (slots_[i].key != 0)
+                i = (i + 1) & (slots_.size() - 1);
+
+            slots_[i] = std::move(s);
+        }
+    }
+
+    std::vector<slot> slots_;
+    size_t size_{};
+    std::vector<std::string> connections_;
+};
+} // namespace io
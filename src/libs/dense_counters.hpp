@@ -0,0 +1,185 @@
+#pragma once
+
+#include <prometheus/collectable.h>
+#include <prometheus/metric_family.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace io
+{
+/** @brief one counter of a dense_counters block, `family` indexes the block's family table */
+struct counter_spec
+{
+    size_t family;
+    std::string_view name;
+    std::string_view category{};
+};
+
+struct counter_family_spec
+{
+    std::string_view name;
+    std::string_view help;
+};
+
+/**
+ * @brief thread which increments a counter.
+ *
+ * Every lane has a single writer: `shard` is the io_context which owns the block (e.g. an external client's
+ * shard), `control` is the smpp_gateway io_context. A counter may be written from both, the lanes are summed on scrape.
+ */
+enum class counter_lane : size_t
+{
+    shard = 0,
+    control = 1
+};
+
+/**
+ * @brief Contiguous array of counters of one component, folded into prometheus only when scraped.
+ *
+ * An increment is a relaxed load and store of the writer's own slot, i.e. one plain add without a lock prefix
+ * or CAS loop. The label sets are built by the collector on scrape from the static spec tables, so creating
+ * a block costs one allocation.
+ */
+class dense_counters
+{
+  public:
+    dense_counters(std::span<const counter_family_spec> families,
+                   std::span<const counter_spec> counters,
+                   std::vector<prometheus::ClientMetric::Label> labels)
+        : families_(families)
+        , counters_(counters)
+        , labels_(std::move(labels))
+        , lane_size_((counters.size() + slots_per_line - 1) / slots_per_line * slots_per_line)
+        , values_(std::make_unique<slot[]>(lane_size_ * lanes))
+    {
+    }
+
+    dense_counters(const dense_counters&) = delete;
+    dense_counters& operator=(const dense_counters&) = delete;
+    ~dense_counters() = default;
+
+    template<typename E>
+    void increment(E counter, counter_lane lane = counter_lane::shard)
+    {
+        auto& value = values_[static_cast<size_t>(lane) * lane_size_ + static_cast<size_t>(counter)].value;
+        value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /** @brief sum of all lanes, may be called from any thread */
+    uint64_t value(size_t counter) const
+    {
+        uint64_t sum = 0;
+        for (size_t lane = 0; lane < lanes; lane++)
+            sum += values_[lane * lane_size_ + counter].value.load(std::memory_order_relaxed);
+
+        return sum;
+    }
+
+    std::span<const counter_family_spec> families() const
+    {
+        return families_;
+    }
+
+    std::span<const counter_spec> counters() const
+    {
+        return counters_;
+    }
+
+    const std::vector<prometheus::ClientMetric::Label>& labels() const
+    {
+        return labels_;
+    }
+
+  private:
+    static constexpr size_t lanes = 2;
+    static constexpr size_t slots_per_line = 64 / sizeof(uint64_t);
+
+    struct slot
+    {
+        std::atomic<uint64_t> value{ 0 };
+    };
+
+    std::span<const counter_family_spec> families_;
+    std::span<const counter_spec> counters_;
+    std::vector<prometheus::ClientMetric::Label> labels_;
+    size_t lane_size_; // rounded up to whole cache lines, so the lanes never share one
+    std::unique_ptr<slot[]> values_;
+};
+
+/**
+ * @brief Exposes every registered dense_counters block as prometheus counter families.
+ *
+ * Registered on the exposer beside the registry; family names must not be registered in the registry too.
+ */
+class dense_collector : public prometheus::Collectable
+{
+  public:
+    void add(std::shared_ptr<const dense_counters> counters)
+    {
+        std::lock_guard lock(mutex_);
+        blocks_.push_back(std::move(counters));
+    }
+
+    void remove(const dense_counters* counters)
+    {
+        std::lock_guard lock(mutex_);
+        std::erase_if(blocks_, [counters](const auto& block) { return block.get() == counters; });
+    }
+
+    std::vector<prometheus::MetricFamily> Collect() const override
+    {
+        std::map<std::string_view, prometheus::MetricFamily> families;
+
+        std::lock_guard lock(mutex_);
+
+        for (const auto& block : blocks_)
+        {
+            const auto block_families = block->families();
+            const auto counters = block->counters();
+
+            for (size_t i = 0; i < counters.size(); i++)
+            {
+                const auto& spec = counters[i];
+                const auto& family_spec = block_families[spec.family];
+
+                auto [it, inserted] = families.try_emplace(family_spec.name);
+                auto& family = it->second;
+                if (inserted)
+                {
+                    family.name = family_spec.name;
+                    family.help = family_spec.help;
+                    family.type = prometheus::MetricType::Counter;
+                }
+
+                auto& metric = family.metric.emplace_back();
+                metric.label = block->labels();
+                metric.label.push_back({ "name", std::string(spec.name) });
+                if (!spec.category.empty())
+                    metric.label.push_back({ "category", std::string(spec.category) });
+
+                std::sort(metric.label.begin(), metric.label.end());
+                metric.counter.value = static_cast<double>(block->value(i));
+            }
+        }
+
+        std::vector<prometheus::MetricFamily> result;
+        result.reserve(families.size());
+        for (auto& [name, family] : families)
+            result.push_back(std::move(family));
+
+        return result;
+    }
+
+  private:
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<const dense_counters>> blocks_;
+};
+} // namespace io
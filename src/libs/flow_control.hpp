@@ -30,6 +30,7 @@ enum class flow_method
     normal_distro = 3,
     credit = 4,
     limit_credit = 5,
+    token_bucket = 6,
 };
 
 class flow_control : public std::enable_shared_from_this<flow_control>
@@ -39,10 +40,8 @@ class flow_control : public std::enable_shared_from_this<flow_control>
 
     flow_control(boost::asio::io_context* io_context_ptr, pa::config::manager* config_manager, const std::shared_ptr<pa::config::node>& config, const flow_handler& flow_handler)
         : config_{ config }
-        , config_obs_max_packets_per_second_replace_{ config_manager->on_replace(
-              config->at("max_packets_per_second"),
-              std::bind_front(&flow_control::on_max_packets_per_second_replace, this)) }
-        , config_obs_flow_method_replace_{ config_manager->on_replace(config->at("flow_method"), std::bind_front(&flow_control::on_flow_method_replace, this)) }
+        , config_obs_max_packets_per_second_replace_{ observe(config_manager, config->at("max_packets_per_second"), &flow_control::on_max_packets_per_second_replace) }
+        , config_obs_flow_method_replace_{ observe(config_manager, config->at("flow_method"), &flow_control::on_flow_method_replace) }
         , available_credit_{ 0 }
         , credit_arr_ind_{ 0 }
         , last_sec_{ 0 }
@@ -77,6 +76,10 @@ class flow_control : public std::enable_shared_from_this<flow_control>
         {
             flow_method_ = flow_method::limit_credit;
         }
+        else if (conf == "token_bucket")
+        {
+            flow_method_ = flow_method::token_bucket;
+        }
         else
         {
             LOG_CRITICAL("This flow_method({}) is not valid", conf);
@@ -85,9 +88,7 @@ class flow_control : public std::enable_shared_from_this<flow_control>
         try
         {
             should_reject_packet_ = config_->at("should_reject_packet")->get<bool>();
-            config_obs_should_reject_packet_replace_ = config_manager->on_replace(
-                config->at("should_reject_packet"),
-                std::bind_front(&flow_control::on_should_reject_packet_replace, this));
+            config_obs_should_reject_packet_replace_ = observe(config_manager, config->at("should_reject_packet"), &flow_control::on_should_reject_packet_replace);
         }
         catch (const std::logic_error&)
         {
@@ -97,9 +98,7 @@ class flow_control : public std::enable_shared_from_this<flow_control>
         try
         {
             credit_windows_size_ = config_->at("credit_windows_size")->get<uint32_t>();
-            config_obs_credit_windows_size_replace_ = config_manager->on_replace(
-                config->at("credit_windows_size"),
-                std::bind_front(&flow_control::on_credit_windows_size_replace, this));
+            config_obs_credit_windows_size_replace_ = observe(config_manager, config->at("credit_windows_size"), &flow_control::on_credit_windows_size_replace);
         }
         catch (const std::logic_error&)
         {
@@ -109,13 +108,25 @@ class flow_control : public std::enable_shared_from_this<flow_control>
         try
         {
             max_slippage_ = config_->at("max_slippage")->get<uint32_t>();
-            config_obs_max_slippage_replace_ = config_manager->on_replace(config->at("max_slippage"), std::bind_front(&flow_control::on_max_slippage_replace, this));
+            config_obs_max_slippage_replace_ = observe(config_manager, config->at("max_slippage"), &flow_control::on_max_slippage_replace);
         }
         catch (const std::logic_error&)
         {
             max_slippage_ = 0;
         }
 
+        try
+        {
+            burst_size_ = config_->at("burst_size")->get<uint32_t>();
+            config_obs_burst_size_replace_ = observe(config_manager, config->at("burst_size"), &flow_control::on_burst_size_replace);
+        }
+        catch (const std::logic_error&)
+        {
+            burst_size_ = 0;
+        }
+
+        update_token_bucket();
+
         credit_arr_.clear();
         credit_arr_.resize(credit_windows_size_);
 
@@ -337,6 +348,27 @@ class flow_control : public std::enable_shared_from_this<flow_control>
                 return 0;
             }
 
+            case flow_method::token_bucket:
+            {
+                // GCRA: a packet conforms unless the theoretical arrival time is more than the burst tolerance ahead
+                if (max_packets_per_second_ == 0)
+                {
+                    return 1000000;
+                }
+
+                const auto now = std::chrono::steady_clock::now();
+                const auto tat = std::max(theoretical_arrival_time_, now);
+
+                if (tat - now > burst_tolerance_)
+                {
+                    auto remain = std::chrono::ceil<std::chrono::microseconds>(tat - now - burst_tolerance_).count();
+                    return remain > 0 ? remain : 1;
+                }
+
+                theoretical_arrival_time_ = tat + emission_interval_;
+                return 0;
+            }
+
             case flow_method::disabled:
             default:
                 return 0;
@@ -368,6 +400,19 @@ class flow_control : public std::enable_shared_from_this<flow_control>
     }
 
   private:
+    using config_handler = void (flow_control::*)(const std::shared_ptr<pa::config::node>&);
+
+    // config observers are notified on the config manager's thread, changes are applied on the io_context which owns this flow_control
+    pa::config::manager::observer observe(pa::config::manager* config_manager, const std::shared_ptr<pa::config::node>& config, config_handler handler)
+    {
+        return config_manager->on_replace(config, [this, handler](const std::shared_ptr<pa::config::node>& node) {
+            boost::asio::dispatch(timer_.get_executor(), [this, handler, node, wptr = this->weak_from_this()] {
+                if (!wptr.expired())
+                    (this->*handler)(node);
+            });
+        });
+    }
+
     void remove_past_data(uint64_t time_in_micro)
     {
         switch (flow_method_)
@@ -435,6 +480,27 @@ class flow_control : public std::enable_shared_from_this<flow_control>
     void on_max_packets_per_second_replace(const std::shared_ptr<pa::config::node>& config)
     {
         max_packets_per_second_ = config->get<uint32_t>();
+        update_token_bucket();
+    }
+
+    void on_burst_size_replace(const std::shared_ptr<pa::config::node>& config)
+    {
+        burst_size_ = config->get<uint32_t>();
+        update_token_bucket();
+    }
+
+    // burst_size defaults to one second worth of packets, like the window of fixed_flow
+    void update_token_bucket()
+    {
+        if (max_packets_per_second_ == 0)
+        {
+            return;
+        }
+
+        const uint32_t burst = burst_size_ ? burst_size_ : max_packets_per_second_;
+
+        emission_interval_ = std::chrono::nanoseconds(std::chrono::seconds(1)) / max_packets_per_second_;
+        burst_tolerance_ = emission_interval_ * (burst - 1);
     }
 
     void on_flow_method_replace(const std::shared_ptr<pa::config::node>& config)
@@ -464,6 +530,11 @@ class flow_control : public std::enable_shared_from_this<flow_control>
         {
             flow_method_ = flow_method::limit_credit;
         }
+        else if (conf == "token_bucket")
+        {
+            flow_method_ = flow_method::token_bucket;
+            theoretical_arrival_time_ = {};
+        }
         else
         {
             LOG_CRITICAL("This flow_method({}) is not valid", conf);
@@ -498,6 +569,7 @@ class flow_control : public std::enable_shared_from_this<flow_control>
     pa::config::manager::observer config_obs_should_reject_packet_replace_;
     pa::config::manager::observer config_obs_credit_windows_size_replace_;
     pa::config::manager::observer config_obs_max_slippage_replace_;
+    pa::config::manager::observer config_obs_burst_size_replace_;
 
     uint32_t max_packets_per_second_;
     flow_method flow_method_;
@@ -520,6 +592,12 @@ class flow_control : public std::enable_shared_from_this<flow_control>
 
     std::chrono::time_point<std::chrono::steady_clock> last_time_;
 
+    // token_bucket method, constant state whatever the rate is
+    uint32_t burst_size_ = 0;
+    std::chrono::nanoseconds emission_interval_{};
+    std::chrono::nanoseconds burst_tolerance_{};
+    std::chrono::time_point<std::chrono::steady_clock> theoretical_arrival_time_{};
+
     boost::asio::steady_timer timer_;
     flow_handler flow_handler_{};
 };
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "logging.hpp"
+
+#include <boost/asio.hpp>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace io
+{
+/**
+ * @brief A fixed set of io_contexts, each one driven by its own thread.
+ *
+ * Every io_context is a shard: objects created on it (sockets, timers, ...) are only touched by
+ * the shard's thread, so no locking is needed inside a shard. Work that crosses shards must be
+ * handed over explicitly with boost::asio::post / boost::asio::dispatch.
+ */
+class io_context_pool
+{
+  public:
+    explicit io_context_pool(size_t pool_size)
+    {
+        if (pool_size == 0)
+            throw std::invalid_argument("io::io_context_pool size must be greater than zero");
+
+        for (size_t i = 0; i < pool_size; i++)
+        {
+            auto io_context = std::make_unique<boost::asio::io_context>(1 /* concurrency hint */);
+            work_guards_.emplace_back(boost::asio::make_work_guard(*io_context));
+            io_contexts_.emplace_back(std::move(io_context));
+        }
+    }
+
+    io_context_pool(const io_context_pool&) = delete;
+    io_context_pool& operator=(const io_context_pool&) = delete;
+    io_context_pool(io_context_pool&&) = delete;
+    io_context_pool& operator=(io_context_pool&&) = delete;
+
+    ~io_context_pool()
+    {
+        stop();
+    }
+
+    void run()
+    {
+        if (!threads_.empty())
+            return;
+
+        for (size_t i = 0; i < io_contexts_.size(); i++)
+        {
+            threads_.emplace_back([io_context = io_contexts_[i].get(), i] {
+                LOG_INFO("io_context shard {} is running", i);
+                io_context->run();
+                LOG_INFO("io_context shard {} is stopped", i);
+            });
+        }
+    }
+
+    void stop()
+    {
+        work_guards_.clear();
+
+        for (auto& io_context : io_contexts_)
+            io_context->stop();
+
+        for (auto& thread : threads_)
+        {
+            if (thread.joinable())
+                thread.join();
+        }
+
+        threads_.clear();
+    }
+
+    /** @brief returns shards in round-robin order */
+    boost::asio::io_context* get_io_context()
+    {
+        auto* io_context = io_contexts_[next_index_].get();
+
+        if (++next_index_ == io_contexts_.size())
+            next_index_ = 0;
+
+        return io_context;
+    }
+
+    size_t size() const
+    {
+        return io_contexts_.size();
+    }
+
+  private:
+    std::vector<std::unique_ptr<boost::asio::io_context>> io_contexts_;
+    std::vector<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> work_guards_;
+    std::vector<std::thread> threads_;
+    size_t next_index_{ 0 };
+};
+} // namespace io
@@ -23,12 +23,12 @@ public:
 
         if((config->at("output_mode")->get<std::string>() == "console") || (config->at("output_mode")->get<std::string>() == "both"))
         {
-            sink_list.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_st>());
+            sink_list.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
         }
 
         if((config->at("output_mode")->get<std::string>() == "file") || (config->at("output_mode")->get<std::string>() == "both"))
         {
-            sink_list.push_back(std::make_shared<spdlog::sinks::rotating_file_sink_st>(
+            sink_list.push_back(std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
                                     config->at("file_name")->get<std::string>(),
                                     config->at("max_file_size")->get<std::uint32_t>() * 1024 * 1024,
                                     config->at("max_files")->get<std::uint32_t>(),
@@ -0,0 +1,475 @@
+#pragma once
+
+#include "logging.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace io
+{
+/**
+ * @brief Persistent append-only queue of records in memory-mapped segment files.
+ *
+ * Every record carries its length, a checksum and a state word. append() writes into the mapping and returns
+ * only after msync(MS_SYNC) has written the pages of the record to disk, so an appended record survives an
+ * OS crash or a power loss and may be acknowledged to its sender. Completing a record flips its state in
+ * place without a sync, so after a crash a completed record may be offered again (at least once delivery).
+ * A segment file is deleted once all of its records are completed. On construction the segments of a previous run are scanned, a torn
+ * record ends a segment, and every record which was not completed is offered again by next().
+ * Not thread safe, it is owned by one io_context.
+ */
+class mmap_queue
+{
+  public:
+    mmap_queue(std::string path, size_t segment_size, size_t max_segments)
+        : path_(std::move(path))
+        , segment_size_(std::clamp<size_t>(segment_size, 4096, max_segment_size))
+        , max_segments_(std::max<size_t>(max_segments, 1))
+    {
+        if (path_.empty() || path_.back() != '/')
+            path_ += '/';
+
+        std::filesystem::create_directories(path_);
+
+        recover();
+    }
+
+    mmap_queue(const mmap_queue&) = delete;
+    mmap_queue& operator=(const mmap_queue&) = delete;
+
+    ~mmap_queue()
+    {
+        for (auto& [seq, seg] : segments_)
+            close_segment(seg);
+    }
+
+    /** @brief false if the record does not fit, the queue is at max_segments or the segment file or its sync fails */
+    bool append(std::string_view record)
+    {
+        const auto needed = aligned(sizeof(record_header) + record.size());
+        if (needed > segment_size_ - file_header_size)
+            return false;
+
+        if (write_seq_ == 0 || segments_.at(write_seq_).write_offset + needed > segment_size_)
+        {
+            if (!open_write_segment())
+                return false;
+        }
+
+        auto& seg = segments_.at(write_seq_);
+        auto* header = header_at(seg, seg.write_offset);
+
+        std::memcpy(seg.data + seg.write_offset + sizeof(record_header), record.data(), record.size());
+        header->checksum = checksum(record);
+        header->state = pending_state;
+        /* written last, a zero length ends the segment */
+        std::atomic_ref(header->length).store(static_cast<uint32_t>(record.size()), std::memory_order_release);
+
+        if (!sync(seg, seg.write_offset, needed))
+        {
+            /* a zero length ends the segment again, the record is not offered after a restart */
+            std::atomic_ref(header->length).store(0, std::memory_order_release);
+            return false;
+        }
+
+        seg.write_offset += needed;
+        seg.records++;
+        pending_++;
+
+        return true;
+    }
+
+    /** @brief true if next() has a record to offer */
+    bool has_next() const
+    {
+        if (!retry_.empty())
+            return true;
+
+        for (auto it = segments_.lower_bound(read_seq_); it != segments_.end(); ++it)
+        {
+            if (it->second.read_offset < it->second.write_offset)
+                return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief next record which was neither completed nor handed out yet, with its id.
+     *
+     * The view points into the mapping and stays valid until the record is completed.
+     */
+    std::optional<std::pair<uint64_t, std::string_view>> next()
+    {
+        if (!retry_.empty())
+        {
+            const auto id = retry_.front();
+            retry_.pop_front();
+
+            auto& seg = segments_.at(id >> 32);
+            return std::pair{ id, payload_at(seg, static_cast<uint32_t>(id)) };
+        }
+
+        for (auto it = segments_.lower_bound(read_seq_); it != segments_.end(); ++it)
+        {
+            auto& seg = it->second;
+            read_seq_ = it->first;
+
+            while (seg.read_offset < seg.write_offset)
+            {
+                const auto offset = seg.read_offset;
+                const auto* header = header_at(seg, offset);
+
+                seg.read_offset += aligned(sizeof(record_header) + header->length);
+
+                if (header->state == pending_state)
+                    return std::pair{ make_id(it->first, offset), payload_at(seg, offset) };
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    /** @brief marks a record handed out by next() as done, it is never offered again */
+    void complete(uint64_t id)
+    {
+        auto it = segments_.find(id >> 32);
+        if (it == segments_.end())
+            return;
+
+        auto& seg = it->second;
+        auto* header = header_at(seg, static_cast<uint32_t>(id));
+        if (header->state == done_state)
+            return;
+
+        header->state = done_state;
+        seg.done++;
+        pending_--;
+
+        if (seg.done == seg.records && it->first != write_seq_)
+            remove_segment(it);
+    }
+
+    /** @brief offers a record handed out by next() again, before any record not handed out yet */
+    void retry(uint64_t id)
+    {
+        retry_.push_back(id);
+    }
+
+    /** @brief holds a record handed out by next() back, it is not offered again before release_deferred() */
+    void defer(uint64_t id)
+    {
+        deferred_.push_back(id);
+    }
+
+    /** @brief offers the deferred records again, as if each of them was retried */
+    void release_deferred()
+    {
+        retry_.insert(retry_.end(), deferred_.begin(), deferred_.end());
+        deferred_.clear();
+    }
+
+    /** @brief number of records which are not completed */
+    size_t size() const
+    {
+        return pending_;
+    }
+
+  private:
+    struct record_header
+    {
+        uint32_t length;
+        uint32_t checksum;
+        uint32_t state;
+        uint32_t reserved;
+    };
+
+    struct segment
+    {
+        int fd{ -1 };
+        uint8_t* data{ nullptr };
+        size_t size{ 0 };
+        size_t write_offset{ file_header_size };
+        size_t read_offset{ file_header_size };
+        size_t records{ 0 };
+        size_t done{ 0 };
+    };
+
+    static constexpr std::string_view magic{ "SGWMMAPQ" };
+    static constexpr size_t file_header_size{ 16 };
+    static constexpr uint32_t pending_state{ 1 };
+    static constexpr uint32_t done_state{ 2 };
+    static constexpr std::string_view segment_extension{ ".mq" };
+    static constexpr size_t max_segment_size{ 1u << 30 }; // record offsets are the low 32 bits of an id
+
+    static size_t aligned(size_t size)
+    {
+        return (size + 7) & ~size_t{ 7 };
+    }
+
+    static uint64_t make_id(uint64_t seq, size_t offset)
+    {
+        return seq << 32 | offset;
+    }
+
+    static uint32_t checksum(std::string_view data)
+    {
+        uint32_t hash = 2166136261u;
+        for (auto c : data)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 16777619u;
+        }
+
+        return hash;
+    }
+
+    static record_header* header_at(segment& seg, size_t offset)
+    {
+        return reinterpret_cast<record_header*>(seg.data + offset);
+    }
+
+    static std::string_view payload_at(segment& seg, size_t offset)
+    {
+        return { reinterpret_cast<const char*>(seg.data + offset + sizeof(record_header)), header_at(seg, offset)->length };
+    }
+
+    std::string segment_name(uint64_t seq) const
+    {
+        return fmt::format("{}{:016}{}", path_, seq, segment_extension);
+    }
+
+    bool map_segment(segment& seg, const std::string& name, int flags)
+    {
+        seg.fd = ::open(name.c_str(), flags | O_RDWR | O_CLOEXEC, 0644);
+        if (seg.fd == -1)
+        {
+            LOG_ERROR("could not open mmap_queue segment {}, error: {}", name, std::strerror(errno));
+            return false;
+        }
+
+        /* the blocks are allocated up front, a sparse file would raise SIGBUS in append() once the disk is full */
+        if (flags & O_CREAT)
+        {
+            if (const int error = ::posix_fallocate(seg.fd, 0, static_cast<off_t>(segment_size_)); error != 0)
+            {
+                LOG_ERROR("could not allocate mmap_queue segment {}, error: {}", name, std::strerror(error));
+                close_segment(seg);
+                ::unlink(name.c_str());
+                return false;
+            }
+        }
+
+        seg.size = static_cast<size_t>(::lseek(seg.fd, 0, SEEK_END));
+        if (seg.size < file_header_size)
+        {
+            LOG_ERROR("mmap_queue segment {} is truncated", name);
+            close_segment(seg);
+            return false;
+        }
+
+        auto* data = ::mmap(nullptr, seg.size, PROT_READ | PROT_WRITE, MAP_SHARED, seg.fd, 0);
+        if (data == MAP_FAILED)
+        {
+            LOG_ERROR("could not map mmap_queue segment {}, error: {}", name, std::strerror(errno));
+            close_segment(seg);
+            return false;
+        }
+
+        seg.data = static_cast<uint8_t*>(data);
+        return true;
+    }
+
+    /* writes the pages holding [offset, offset + length) to disk */
+    static bool sync(segment& seg, size_t offset, size_t length)
+    {
+        static const auto page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+
+        const auto begin = offset & ~(page_size - 1);
+        if (::msync(seg.data + begin, offset + length - begin, MS_SYNC) == -1)
+        {
+            LOG_ERROR("could not sync mmap_queue segment, error: {}", std::strerror(errno));
+            return false;
+        }
+
+        return true;
+    }
+
+    /* makes a created or deleted segment file durable */
+    bool sync_directory() const
+    {
+        const int fd = ::open(path_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd == -1)
+            return false;
+
+        const bool synced = ::fsync(fd) == 0;
+        ::close(fd);
+
+        return synced;
+    }
+
+    static void close_segment(segment& seg)
+    {
+        if (seg.data)
+            ::munmap(seg.data, seg.size);
+
+        if (seg.fd != -1)
+            ::close(seg.fd);
+
+        seg.data = nullptr;
+        seg.fd = -1;
+    }
+
+    bool open_write_segment()
+    {
+        if (write_seq_ != 0)
+        {
+            auto it = segments_.find(write_seq_);
+            write_seq_ = 0;
+
+            if (it->second.done == it->second.records)
+                remove_segment(it);
+        }
+
+        if (segments_.size() >= max_segments_)
+            return false;
+
+        const auto seq = next_seq_++;
+        segment seg;
+        if (!map_segment(seg, segment_name(seq), O_CREAT | O_EXCL))
+            return false;
+
+        std::memcpy(seg.data, magic.data(), magic.size());
+
+        if (!sync(seg, 0, file_header_size) || !sync_directory())
+        {
+            LOG_ERROR("could not sync new mmap_queue segment {}", segment_name(seq));
+            close_segment(seg);
+            ::unlink(segment_name(seq).c_str());
+            return false;
+        }
+
+        segments_.emplace(seq, seg);
+        write_seq_ = seq;
+
+        return true;
+    }
+
+    void remove_segment(std::map<uint64_t, segment>::iterator it)
+    {
+        close_segment(it->second);
+        ::unlink(segment_name(it->first).c_str());
+        segments_.erase(it);
+    }
+
+    /* a segment ends at the first zero length, out of bounds or corrupt record */
+    void scan(segment& seg, const std::string& name)
+    {
+        size_t offset = file_header_size;
+
+        while (offset + sizeof(record_header) <= seg.size)
+        {
+            const auto* header = header_at(seg, offset);
+            if (header->length == 0)
+                break;
+
+            const auto end = aligned(offset + sizeof(record_header) + header->length);
+            if (end > seg.size || (header->state != pending_state && header->state != done_state) ||
+                header->checksum != checksum(payload_at(seg, offset)))
+            {
+                LOG_WARN("mmap_queue segment {} has a torn record at offset {}, the rest of it is dropped", name, offset);
+                break;
+            }
+
+            seg.records++;
+            if (header->state == done_state)
+                seg.done++;
+
+            offset = end;
+        }
+
+        seg.write_offset = offset;
+    }
+
+    void recover()
+    {
+        std::vector<uint64_t> seqs;
+
+        for (const auto& entry : std::filesystem::directory_iterator(path_))
+        {
+            if (!entry.is_regular_file() || entry.path().extension() != segment_extension)
+                continue;
+
+            try
+            {
+                seqs.push_back(std::stoull(entry.path().stem().string()));
+            }
+            catch (...)
+            {
+                LOG_WARN("ignore unknown file {} in mmap_queue", entry.path().string());
+            }
+        }
+
+        std::sort(seqs.begin(), seqs.end());
+
+        for (auto seq : seqs)
+        {
+            next_seq_ = seq + 1;
+
+            const auto name = segment_name(seq);
+            segment seg;
+            if (!map_segment(seg, name, 0))
+                continue;
+
+            if (std::memcmp(seg.data, magic.data(), magic.size()) != 0)
+            {
+                LOG_WARN("ignore mmap_queue segment {} without a valid header", name);
+                close_segment(seg);
+                continue;
+            }
+
+            scan(seg, name);
+
+            if (seg.done == seg.records)
+            {
+                close_segment(seg);
+                ::unlink(name.c_str());
+                continue;
+            }
+
+            pending_ += seg.records - seg.done;
+            segments_.emplace(seq, seg);
+        }
+
+        if (pending_)
+            LOG_INFO("{} records in {} segments are recovered from mmap_queue {}", pending_, segments_.size(), path_);
+    }
+
+    std::string path_;
+    size_t segment_size_;
+    size_t max_segments_;
+
+    std::map<uint64_t, segment> segments_; // oldest first
+    uint64_t next_seq_{ 1 };
+    uint64_t write_seq_{ 0 }; // 0 if no segment of this run is open for appending
+    uint64_t read_seq_{ 0 };  // segments before it have been handed out completely
+    std::deque<uint64_t> retry_;
+    std::vector<uint64_t> deferred_;
+    size_t pending_{ 0 };
+};
+} // namespace io
@@ -3,11 +3,13 @@
 #include <prometheus/counter.h>
 #include <prometheus/gauge.h>
 #include <prometheus/family.h>
+#include <prometheus/client_metric.h>
 
 #include <pa/config.hpp>
 
 #include <map>
 #include <string>
+#include <vector>
 
 inline prometheus::Counter& add_counter(prometheus::Family<prometheus::Counter>& family, const std::shared_ptr<pa::config::node>& config, std::map<std::string, std::string> lables)
 {
@@ -37,4 +39,23 @@ inline void remove_counter(prometheus::Family<prometheus::Counter>& family, prom
 inline void remove_gauge(prometheus::Family<prometheus::Gauge>& family, prometheus::Gauge *metric)
 {
     return family.Remove(metric);
-}
\ No newline at end of file
+}
+
+/** @brief constant labels of a io::dense_counters block, the configured labels plus `lables` */
+inline std::vector<prometheus::ClientMetric::Label> make_labels(const std::shared_ptr<pa::config::node>& config, std::map<std::string, std::string> lables)
+{
+    for(const auto& label : config->nodes())
+    {
+        lables.emplace(label->at("key")->get<std::string>(), label->at("value")->get<std::string>());
+    }
+
+    std::vector<prometheus::ClientMetric::Label> result;
+    result.reserve(lables.size());
+
+    for(auto& [name, value] : lables)
+    {
+        result.push_back({ name, value });
+    }
+
+    return result;
+}
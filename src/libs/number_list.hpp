@@ -0,0 +1,188 @@
+#pragma once
+
+#include "logging.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace io
+{
+/**
+ * @brief Read-only set of phone numbers backed by a memory-mapped file.
+ *
+ * The file is a plain array of numbers as native uint64_t, sorted ascending. A blocked Bloom filter is built
+ * in front of it on load, so a number which is not in the list is answered from one cache line and only the
+ * rare candidates are searched in the mapping. A new list must be written to a new file or renamed over the old
+ * one, never rewritten in place while it is mapped. Immutable after construction, any thread may query it.
+ */
+class number_list
+{
+  public:
+    /** @throws std::runtime_error if the file can not be mapped or is not a sorted array of numbers */
+    explicit number_list(const std::string& path, size_t bits_per_number = 10)
+        : path_(path)
+    {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ == -1)
+            throw std::runtime_error(fmt::format("could not open number list {}, error: {}", path, std::strerror(errno)));
+
+        struct stat st;
+        if (::fstat(fd_, &st) == -1 || st.st_size % sizeof(uint64_t) != 0)
+        {
+            ::close(fd_);
+            throw std::runtime_error(fmt::format("number list {} is not an array of 64 bit numbers", path));
+        }
+
+        size_ = static_cast<size_t>(st.st_size) / sizeof(uint64_t);
+
+        if (size_)
+        {
+            auto* data = ::mmap(nullptr, size_ * sizeof(uint64_t), PROT_READ, MAP_SHARED, fd_, 0);
+            if (data == MAP_FAILED)
+            {
+                ::close(fd_);
+                throw std::runtime_error(fmt::format("could not map number list {}, error: {}", path, std::strerror(errno)));
+            }
+
+            numbers_ = static_cast<const uint64_t*>(data);
+        }
+
+        if (!std::is_sorted(numbers_, numbers_ + size_))
+        {
+            unmap();
+            throw std::runtime_error(fmt::format("number list {} is not sorted", path));
+        }
+
+        build_filter(bits_per_number);
+
+        LOG_INFO("number list {} is loaded with {} numbers", path_, size_);
+    }
+
+    number_list(const number_list&) = delete;
+    number_list& operator=(const number_list&) = delete;
+
+    ~number_list()
+    {
+        unmap();
+    }
+
+    bool contains(uint64_t number) const
+    {
+        if (size_ == 0)
+            return false;
+
+        const auto h = mix(number);
+        const auto& b = blocks_[h & (blocks_.size() - 1)];
+        const auto bits = mix(h);
+
+        for (unsigned i = 0; i < hashes_; i++)
+        {
+            const auto bit = (bits >> (i * 9)) & 511;
+            if (!(b[bit >> 6] & (uint64_t{ 1 } << (bit & 63))))
+                return false;
+        }
+
+        return std::binary_search(numbers_, numbers_ + size_, number);
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    const std::string& path() const
+    {
+        return path_;
+    }
+
+    /** @brief the number of an all-digit address, nullopt for alphanumeric or too long addresses */
+    static std::optional<uint64_t> to_number(std::string_view address)
+    {
+        if (address.empty() || address.size() > 19)
+            return std::nullopt;
+
+        uint64_t number = 0;
+        for (auto c : address)
+        {
+            if (c < '0' || c > '9')
+                return std::nullopt;
+
+            number = number * 10 + static_cast<uint64_t>(c - '0');
+        }
+
+        return number;
+    }
+
+  private:
+    /* 512 bit blocks, one mix picks the block and a second one gives 9 bits to each hash */
+    using block = std::array<uint64_t, 8>;
+
+    static uint64_t mix(uint64_t h)
+    {
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebull;
+        h ^= h >> 31;
+        return h;
+    }
+
+    void build_filter(size_t bits_per_number)
+    {
+        bits_per_number = std::clamp<size_t>(bits_per_number, 4, 24);
+
+        // about ln2 * bits per number, 64 bits of the mix leave room for 7 hashes
+        hashes_ = std::clamp<unsigned>(static_cast<unsigned>(bits_per_number * 7 / 10), 1, 7);
+
+        const auto blocks = std::max<size_t>((size_ * bits_per_number + 511) / 512, 1);
+        blocks_.assign(std::bit_ceil(blocks), block{});
+
+        for (size_t i = 0; i < size_; i++)
+        {
+            const auto h = mix(numbers_[i]);
+            auto& b = blocks_[h & (blocks_.size() - 1)];
+            const auto bits = mix(h);
+
+            for (unsigned k = 0; k < hashes_; k++)
+            {
+                const auto bit = (bits >> (k * 9)) & 511;
+                b[bit >> 6] |= uint64_t{ 1 } << (bit & 63);
+            }
+        }
+    }
+
+    void unmap()
+    {
+        if (numbers_)
+            ::munmap(const_cast<uint64_t*>(numbers_), size_ * sizeof(uint64_t));
+
+        if (fd_ != -1)
+            ::close(fd_);
+
+        numbers_ = nullptr;
+        fd_ = -1;
+    }
+
+    std::string path_;
+    int fd_{ -1 };
+    const uint64_t* numbers_{ nullptr };
+    size_t size_{ 0 };
+
+    std::vector<block> blocks_;
+    unsigned hashes_{ 1 };
+};
+} // namespace io
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <google/protobuf/arena.h>
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace io
+{
+/**
+ * @brief Per-message protobuf arenas whose first block is recycled.
+ *
+ * make_message() places the message, its nested messages and strings in an arena of its own, starting in a
+ * block taken from the pool, so parsing a typical packet does not call malloc at all. The returned shared_ptr
+ * owns the arena; when the last copy goes the arena is destroyed at once and its block returns to the pool.
+ * Messages are created on one thread and often released on another, so the pool is locked.
+ */
+class arena_pool
+{
+  public:
+    static constexpr size_t block_size{ 4096 };
+    static constexpr size_t max_pooled_blocks{ 4096 };
+
+    static arena_pool& instance()
+    {
+        // never destroyed, messages may still be released while static objects are torn down at exit
+        static auto* pool = new arena_pool;
+        return *pool;
+    }
+
+    template<typename T>
+    std::shared_ptr<T> make_message()
+    {
+        auto holder = std::make_shared<arena_holder>(block_ptr(acquire()));
+        auto* message = google::protobuf::Arena::CreateMessage<T>(&holder->arena);
+
+        // aliasing constructor, the message lives exactly as long as its arena
+        return std::shared_ptr<T>(std::move(holder), message);
+    }
+
+  private:
+    struct block_deleter
+    {
+        void operator()(char* block) const
+        {
+            arena_pool::instance().release(block);
+        }
+    };
+
+    using block_ptr = std::unique_ptr<char[], block_deleter>;
+
+    static google::protobuf::ArenaOptions options(char* block)
+    {
+        google::protobuf::ArenaOptions options;
+        options.initial_block = block;
+        options.initial_block_size = block_size;
+        return options;
+    }
+
+    /* the arena is destroyed before its block is released, it walks its blocks while freeing them */
+    struct arena_holder
+    {
+        explicit arena_holder(block_ptr b)
+            : block(std::move(b))
+            , arena(options(block.get()))
+        {
+        }
+
+        block_ptr block;
+        google::protobuf::Arena arena;
+    };
+
+    char* acquire()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            if (!free_.empty())
+            {
+                auto* block = free_.back();
+                free_.pop_back();
+                return block;
+            }
+        }
+
+        return new char[block_size];
+    }
+
+    void release(char* block)
+    {
+        {
+            std::lock_guard lock(mutex_);
+            if (free_.size() < max_pooled_blocks)
+            {
+                free_.push_back(block);
+                return;
+            }
+        }
+
+        delete[] block;
+    }
+
+    arena_pool() = default;
+
+    std::mutex mutex_;
+    std::vector<char*> free_;
+};
+
+/**
+ * @brief Arena for a message which is built and serialized within one call.
+ *
+ * Its first block is a per-thread buffer, so building a message does not allocate. Only one scratch_arena per
+ * thread uses the buffer at a time, a nested one falls back to heap blocks.
+ */
+class scratch_arena
+{
+  public:
+    scratch_arena()
+        : owns_buffer_(!buffer_in_use_)
+        , arena_(owns_buffer_ ? options() : google::protobuf::ArenaOptions{})
+    {
+        if (owns_buffer_)
+            buffer_in_use_ = true;
+    }
+
+    scratch_arena(const scratch_arena&) = delete;
+    scratch_arena& operator=(const scratch_arena&) = delete;
+
+    ~scratch_arena()
+    {
+        if (owns_buffer_)
+            buffer_in_use_ = false;
+    }
+
+    template<typename T>
+    T* make_message()
+    {
+        return google::protobuf::Arena::CreateMessage<T>(&arena_);
+    }
+
+  private:
+    static constexpr size_t buffer_size{ 8192 };
+
+    static google::protobuf::ArenaOptions options()
+    {
+        google::protobuf::ArenaOptions options;
+        options.initial_block = buffer_.data();
+        options.initial_block_size = buffer_.size();
+        return options;
+    }
+
+    alignas(16) static inline thread_local std::array<char, buffer_size> buffer_;
+    static inline thread_local bool buffer_in_use_{ false };
+
+    bool owns_buffer_;
+    google::protobuf::Arena arena_;
+};
+} // namespace io
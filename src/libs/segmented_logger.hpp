@@ -3,10 +3,19 @@
 #include "logging.hpp"
 #include <pa/config.hpp>
 
-#include <deque>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
@@ -114,6 +123,14 @@ static std::string parse_format(const std::string& input)
 }
 } // namespace details
 
+/**
+ * @brief Writes records into segmented files: a file is created in create_path and moved to close_path
+ * when it reaches records_threshold records, is open for time_threshold or the day changes.
+ *
+ * record() only appends to a preallocated in-memory buffer. A dedicated writer thread swaps it with a
+ * second buffer and does the write(2)/fdatasync calls and the file rotation, so disk stalls never
+ * block the caller.
+ */
 class segmented_logger
 {
   public:
@@ -161,14 +178,30 @@ class segmented_logger
 
         buffer_size_ = config_->at("buffer_size")->get<uint32_t>();
         number_of_records_threshold_ = config_->at("records_threshold")->get<uint32_t>();
-        time_threshold_ = std::chrono::seconds(config_->at("time_threshold")->get<uint32_t>());
+        time_threshold_ = config_->at("time_threshold")->get<uint32_t>();
+
+        for (auto* records_buffer : { &front_, &back_ })
+        {
+            records_buffer->records_.reserve(static_cast<size_t>(buffer_size_) * expected_record_size_);
+            records_buffer->ends_.reserve(buffer_size_);
+        }
 
         prepare_folders();
+
+        writer_ = std::thread(&segmented_logger::run, this);
     }
 
     virtual ~segmented_logger()
     {
-        close_file();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+
+        cv_.notify_one();
+
+        if (writer_.joinable())
+            writer_.join();
     }
 
     segmented_logger(const segmented_logger&) = delete;
@@ -176,89 +209,49 @@ class segmented_logger
     segmented_logger& operator=(const segmented_logger&) = delete;
     segmented_logger& operator=(segmented_logger&&) = delete;
 
-    void record(const std::string& log)
-    {
-        if (is_enabled_)
-        {
-            records_.push_back(log);
-            check_for_flush();
-        }
-    }
-
-    void close_file()
+    void record(std::string_view log)
     {
-        if (!file_handler_.is_open())
+        if (!is_enabled_)
             return;
 
-        if ((file_mode_ == details::file_mode::text) && text_file_footer_.length())
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        front_.records_.append(log);
+        if (file_mode_ == details::file_mode::text)
         {
-            file_handler_.write(text_file_footer_.c_str(), text_file_footer_.length());
+            front_.records_.push_back('\n');
         }
 
-        file_handler_.close();
-
-        LOG_INFO("LOG file ({}) is closed.", file_name_);
-
-        std::string current_path = create_path_ + file_name_;
-
-        struct timeval close_time_timeval;
-        struct tm close_time_tm;
-        gettimeofday(&close_time_timeval, nullptr);
-        localtime_r(&close_time_timeval.tv_sec, &close_time_tm);
-
-        auto close_file_name = fmt::format(
-            fmt::runtime(parsed_format_), //file_name_format_,
-            (creation_time_tm_.tm_year + 1900),
-            (creation_time_tm_.tm_year - 100),
-            (creation_time_tm_.tm_mon + 1),
-            creation_time_tm_.tm_mday,
-            creation_time_tm_.tm_hour,
-            creation_time_tm_.tm_min,
-            creation_time_tm_.tm_sec,
-            (creation_time_timeval_.tv_usec / 100),
-            (close_time_tm.tm_year + 1900),
-            (close_time_tm.tm_year - 100),
-            (close_time_tm.tm_mon + 1),
-            close_time_tm.tm_mday,
-            close_time_tm.tm_hour,
-            close_time_tm.tm_min,
-            close_time_tm.tm_sec,
-            (close_time_timeval.tv_usec / 100),
-            file_seq_no_);
-
-        // copy file to close_folder that was specified in config file
-        if (close_path_ != "")
-        {
-            std::string new_path = close_path_ + close_file_name;
+        front_.ends_.push_back(front_.records_.size());
 
-            int result = rename(current_path.c_str(), new_path.c_str());
+        if (front_.ends_.size() == buffer_size_)
+            cv_.notify_one();
+    }
 
-            if (result == 0)
-            {
-                // chmod(new_path.c_str(), 0776); // Set write permission on closed file.
-                LOG_INFO("File was copied in close-folder successfully");
-            }
-            else
-            {
-                LOG_ERROR("Couldn't copy file to close-folder");
-            }
-        }
+    /**
+     * @brief flushes the buffered records and closes the current file; blocks until the writer thread is done
+     */
+    void close_file()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
 
-        number_of_records_in_file_ = 0;
-        last_write_ = std::chrono::steady_clock::now();
+        if (stop_)
+            return;
 
-        file_seq_no_++;
-        if(file_seq_no_ >= 10000)
-            file_seq_no_ = 1;
+        auto generation = ++close_requested_;
+        cv_.notify_one();
+        closed_cv_.wait(lock, [&] { return closed_ >= generation || stop_; });
     }
 
     inline void set_header(const std::string& header)
     {
+        std::lock_guard<std::mutex> lock(mutex_);
         text_file_header_ = header;
     }
 
     inline void set_footer(const std::string& footer)
     {
+        std::lock_guard<std::mutex> lock(mutex_);
         text_file_footer_ = footer;
     }
 
@@ -268,35 +261,81 @@ class segmented_logger
     }
 
   private:
-    void check_for_flush()
+    struct buffer
     {
-        if (records_.size() >= buffer_size_)
-            write_buffer_to_file();
+        std::string records_;      // records back to back, text records end with '\n'
+        std::vector<size_t> ends_; // end offset of every record in records_
+
+        void clear()
+        {
+            records_.clear();
+            ends_.clear();
+        }
+    };
 
-        time_t currentTime = time(nullptr);
-        struct tm currentTime_tm;
-        localtime_r(&currentTime, &currentTime_tm);
-        const auto since_last_write = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - last_write_);
+    // runs on the writer thread, everything below it is only touched from there
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
 
-        if ((number_of_records_in_file_ >= number_of_records_threshold_) ||
-            (since_last_write >= time_threshold_) ||
-            (currentTime_tm.tm_mday != creation_time_tm_.tm_mday))
+        while (true)
         {
-            write_buffer_to_file();
-            close_file();
+            cv_.wait_for(lock, std::chrono::seconds(1), [this] {
+                return stop_ || (close_requested_ != closed_) || (front_.ends_.size() >= buffer_size_);
+            });
+
+            const bool stopping = stop_;
+            const auto close_generation = close_requested_;
+            const auto now = std::chrono::steady_clock::now();
+            const auto time_threshold = std::chrono::seconds(time_threshold_.load());
+
+            const bool close_now = stopping || (close_generation != closed_) || rotation_due(now, time_threshold);
+            const bool flush_now = close_now || (front_.ends_.size() >= buffer_size_) || (now - last_write_ >= time_threshold);
+
+            if (flush_now)
+                std::swap(front_, back_);
 
-            number_of_records_in_file_ = 0;
+            const std::string header = text_file_header_;
+            const std::string footer = text_file_footer_;
 
-            if (currentTime_tm.tm_mday != creation_time_tm_.tm_mday)
+            lock.unlock();
+
+            if (flush_now)
             {
-                file_seq_no_ = 1;
+                write_buffer_to_file(header, footer);
+                back_.clear();
+                last_write_ = now;
             }
 
-            LOG_INFO("File is closed.");
+            if (close_now)
+                do_close_file(footer);
+
+            lock.lock();
+
+            closed_ = close_generation;
+            closed_cv_.notify_all();
+
+            if (stopping)
+                break;
         }
     }
 
-    void open_new_file()
+    bool rotation_due(std::chrono::steady_clock::time_point now, std::chrono::seconds time_threshold) const
+    {
+        if (fd_ == -1)
+            return false;
+
+        if (now - file_opened_ >= time_threshold)
+            return true;
+
+        time_t current_time = time(nullptr);
+        struct tm current_time_tm;
+        localtime_r(&current_time, &current_time_tm);
+
+        return current_time_tm.tm_mday != creation_time_tm_.tm_mday;
+    }
+
+    void open_new_file(const std::string& header)
     {
         auto current_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now().time_since_epoch());
         file_name_ = std::to_string(current_time.count()) + incomplete_file_extension_;
@@ -304,53 +343,147 @@ class segmented_logger
         std::string fullPath = create_path_ + file_name_;
         LOG_INFO("Creating  new file with name: {}", fullPath);
 
-        file_handler_.open(fullPath.c_str(), std::ios::out | ((file_mode_ == details::file_mode::binary) ? std::ios::binary : std::ios::app));
+        fd_ = ::open(fullPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
 
-        if (!file_handler_.is_open())
+        if (fd_ == -1)
         {
-            LOG_CRITICAL("Couldn't open a new log file({}).", fullPath);
+            LOG_CRITICAL("Couldn't open a new log file({}), error: {}", fullPath, std::strerror(errno));
             return;
         }
 
         gettimeofday(&creation_time_timeval_, nullptr);
         localtime_r(&creation_time_timeval_.tv_sec, &creation_time_tm_);
+        file_opened_ = std::chrono::steady_clock::now();
+
+        if ((file_mode_ == details::file_mode::text) && header.length())
+        {
+            write_to_file(header.c_str(), header.length());
+            write_to_file("\n", 1);
+        }
+    }
+
+    void write_to_file(const char* data, size_t size)
+    {
+        while (size)
+        {
+            auto written = ::write(fd_, data, size);
+
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                LOG_ERROR("Couldn't write to log file({}), error: {}", file_name_, std::strerror(errno));
+                return;
+            }
+
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    // writes back_ with one write(2) per file, rotating whenever a file reaches records_threshold
+    void write_buffer_to_file(const std::string& header, const std::string& footer)
+    {
+        size_t record = 0;
+        size_t offset = 0;
 
-        if ((file_mode_ == details::file_mode::text) && text_file_header_.length())
+        while (record < back_.ends_.size())
         {
-            file_handler_.write(text_file_header_.c_str(), text_file_header_.length());
-            file_handler_.write("\n", 1);
+            if (fd_ == -1)
+            {
+                LOG_INFO("Open new file.");
+                open_new_file(header);
+
+                if (fd_ == -1)
+                    return;
+            }
+
+            const size_t threshold = std::max<size_t>(number_of_records_threshold_.load(), 1);
+            const size_t count = std::min(back_.ends_.size() - record, threshold - std::min<size_t>(number_of_records_in_file_, threshold - 1));
+            const size_t end = back_.ends_[record + count - 1];
+
+            write_to_file(back_.records_.data() + offset, end - offset);
+            LOG_INFO("LOG buffer flushed to file({})", file_name_);
+
+            number_of_records_in_file_ += count;
+            record += count;
+            offset = end;
+
+            if (number_of_records_in_file_ >= threshold)
+                do_close_file(footer);
         }
+
+        if (fd_ != -1)
+            ::fdatasync(fd_);
     }
 
-    void write_buffer_to_file()
+    void do_close_file(const std::string& footer)
     {
-        if (records_.empty())
+        if (fd_ == -1)
             return;
 
-        if (!file_handler_.is_open())
+        if ((file_mode_ == details::file_mode::text) && footer.length())
         {
-            LOG_INFO("Open new file.");
-            open_new_file();
+            write_to_file(footer.c_str(), footer.length());
         }
 
-        LOG_INFO("LOG buffer flushed to file({})", file_name_);
+        ::fdatasync(fd_);
+        ::close(fd_);
+        fd_ = -1;
+
+        LOG_INFO("LOG file ({}) is closed.", file_name_);
+
+        std::string current_path = create_path_ + file_name_;
+
+        struct timeval close_time_timeval;
+        struct tm close_time_tm;
+        gettimeofday(&close_time_timeval, nullptr);
+        localtime_r(&close_time_timeval.tv_sec, &close_time_tm);
+
+        auto close_file_name = fmt::format(
+            fmt::runtime(parsed_format_), //file_name_format_,
+            (creation_time_tm_.tm_year + 1900),
+            (creation_time_tm_.tm_year - 100),
+            (creation_time_tm_.tm_mon + 1),
+            creation_time_tm_.tm_mday,
+            creation_time_tm_.tm_hour,
+            creation_time_tm_.tm_min,
+            creation_time_tm_.tm_sec,
+            (creation_time_timeval_.tv_usec / 100),
+            (close_time_tm.tm_year + 1900),
+            (close_time_tm.tm_year - 100),
+            (close_time_tm.tm_mon + 1),
+            close_time_tm.tm_mday,
+            close_time_tm.tm_hour,
+            close_time_tm.tm_min,
+            close_time_tm.tm_sec,
+            (close_time_timeval.tv_usec / 100),
+            file_seq_no_);
+
+        // copy file to close_folder that was specified in config file
+        if (close_path_ != "")
+        {
+            std::string new_path = close_path_ + close_file_name;
 
-        const auto chunk_begin = records_.begin();
-        const auto chunk_end = records_.begin() + std::min(records_.size(), static_cast<size_t>(number_of_records_threshold_ - number_of_records_in_file_));
+            int result = rename(current_path.c_str(), new_path.c_str());
 
-        std::for_each(chunk_begin, chunk_end, [&](const auto& str) {
-            file_handler_.write(str.c_str(), str.length());
-            if (file_mode_ == details::file_mode::text)
+            if (result == 0)
             {
-                file_handler_.write("\n", 1);
+                // chmod(new_path.c_str(), 0776); // Set write permission on closed file.
+                LOG_INFO("File was copied in close-folder successfully");
             }
+            else
+            {
+                LOG_ERROR("Couldn't copy file to close-folder");
+            }
+        }
 
-            number_of_records_in_file_++;
-        });
-
-        records_.erase(chunk_begin, chunk_end);
+        number_of_records_in_file_ = 0;
 
-        file_handler_.flush();
+        file_seq_no_++;
+        if ((file_seq_no_ >= 10000) || (close_time_tm.tm_mday != creation_time_tm_.tm_mday))
+            file_seq_no_ = 1;
     }
 
     void prepare_folders()
@@ -450,7 +583,7 @@ class segmented_logger
 
     inline void on_time_threshold_replace(const std::shared_ptr<pa::config::node>& config)
     {
-        time_threshold_ = std::chrono::seconds(config->get<uint32_t>());
+        time_threshold_ = config->get<uint32_t>();
     }
 
     pa::config::manager* config_manager_;
@@ -461,7 +594,7 @@ class segmented_logger
     pa::config::manager::observer config_obs_records_threshold_replace_;
     pa::config::manager::observer config_obs_time_threshold_replace_;
 
-    bool is_enabled_;
+    std::atomic<bool> is_enabled_;
 
     details::file_mode file_mode_;
 
@@ -472,30 +605,40 @@ class segmented_logger
     // auto fmt::runtime(string_view s) -> runtime_format_string<>
     // std::string s = fmt::format(FMT_COMPILE("{}"), 42);
 
-
-
-    std::string file_name_;     // Name of Current File
-    std::fstream file_handler_; // Handler for Current File
+    std::string file_name_; // Name of Current File
+    int fd_ = -1;           // Descriptor of Current File
 
     std::string create_path_; // The Path where Files are kept after creation
     std::string close_path_;  // The Path where Files will be put after closing
 
-    unsigned int buffer_size_; // Maximum size of data in buffer
+    std::atomic<uint32_t> buffer_size_; // Maximum number of records in buffer
 
     // Creation time of current file
     struct timeval creation_time_timeval_;
     struct tm creation_time_tm_;
+    std::chrono::time_point<std::chrono::steady_clock> file_opened_;
 
     std::string text_file_header_;
     std::string text_file_footer_;
 
-    unsigned int number_of_records_in_file_;
-    unsigned int number_of_records_threshold_;
-    std::chrono::seconds time_threshold_; // a file can remain open up to this threshold time
+    size_t number_of_records_in_file_;
+    std::atomic<uint32_t> number_of_records_threshold_;
+    std::atomic<uint32_t> time_threshold_; // a file can remain open up to this threshold time, in seconds
 
     std::string incomplete_file_extension_ = ".incomp";
 
-    std::deque<std::string> records_;
+    static constexpr size_t expected_record_size_ = 256; // used to preallocate the buffers
+
+    std::mutex mutex_; // guards front_, the header/footer and the fields below
+    std::condition_variable cv_;
+    std::condition_variable closed_cv_;
+    buffer front_; // filled by record()
+    buffer back_;  // written by the writer thread
+    bool stop_ = false;
+    uint64_t close_requested_ = 0;
+    uint64_t closed_ = 0;
 
     std::chrono::time_point<std::chrono::steady_clock> last_write_{ std::chrono::steady_clock::now() };
+
+    std::thread writer_;
 };
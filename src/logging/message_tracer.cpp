@@ -1,6 +1,12 @@
 #include "src/logging/message_tracer.h"
 
 #include <chrono>
+#include <filesystem>
+
+constexpr static size_t MAX_BATCH_SIZE = 1000;
+constexpr static size_t SPOOL_SEGMENT_SIZE = 64 * 1024 * 1024;
+constexpr static auto IDLE_WAIT = std::chrono::milliseconds(10);
+constexpr static auto DROP_REPORT_INTERVAL = std::chrono::seconds(10);
 
 message_tracer::message_tracer(std::shared_ptr<smpp_gateway> smpp_gateway, pa::config::manager* config_manager, const std::shared_ptr<pa::config::node>& config)
     : smpp_gateway_(smpp_gateway)
@@ -10,17 +16,98 @@ message_tracer::message_tracer(std::shared_ptr<smpp_gateway> smpp_gateway, pa::c
     , topic_ {config->at("topic")->get<std::string>()}
     , config_obs_replace_{config_manager->on_replace(config, std::bind_front(&message_tracer::on_config_replace, this))}
 {
-    //Construct the configuration
-    cppkafka::Configuration kafka_config = {
-        { "metadata.broker.list", this->brokers_ }
-    };
+    try
+    {
+        mode_ = (config->at("mode")->get<std::string>() == "async") ? tracer_mode::async : tracer_mode::sync;
+    }
+    catch(...)
+    {
+        mode_ = tracer_mode::sync;
+    }
 
-    kafka_config.set_delivery_report_callback([&](cppkafka::Producer&, const cppkafka::Message& msg)
+    try
     {
-        LOG_INFO("delivery_report_callback topic({})", msg.get_topic());
-    });
+        sink_ = (config->at("sink")->get<std::string>() == "file") ? tracer_sink::file : tracer_sink::kafka;
+    }
+    catch(...)
+    {
+        sink_ = tracer_sink::kafka;
+    }
 
-    this->producer_ = std::make_unique<cppkafka::Producer>(kafka_config);
+    if(sink_ == tracer_sink::file)
+    {
+        std::string file_path = "./tracer/trace.bin";
+
+        try
+        {
+            file_path = config->at("file_path")->get<std::string>();
+        }
+        catch(...)
+        {
+        }
+
+        auto parent = std::filesystem::path(file_path).parent_path();
+        if(!parent.empty())
+        {
+            std::filesystem::create_directories(parent);
+        }
+
+        file_sink_ = std::fopen(file_path.c_str(), "ab");
+
+        if(!file_sink_)
+        {
+            throw std::runtime_error("could not open tracer file " + file_path);
+        }
+
+        // the file sink is written by the background thread only
+        mode_ = tracer_mode::async;
+    }
+    else
+    {
+        create_producer();
+    }
+
+    if(mode_ == tracer_mode::async)
+    {
+        size_t queue_size = 65536;
+
+        try
+        {
+            queue_size = config->at("queue_size")->get<uint32_t>();
+        }
+        catch(...)
+        {
+        }
+
+        ring_ = std::make_unique<io::bounded_ring<std::string>>(queue_size);
+
+        if(sink_ == tracer_sink::kafka)
+        {
+            std::string spool_path = "./tracer/spool";
+            size_t spool_segment_size = SPOOL_SEGMENT_SIZE;
+
+            try
+            {
+                spool_path = config->at("spool_path")->get<std::string>();
+            }
+            catch(...)
+            {
+            }
+
+            try
+            {
+                spool_segment_size = config->at("spool_segment_size")->get<uint32_t>();
+            }
+            catch(...)
+            {
+            }
+
+            spool_ = std::make_unique<tracer_spool>(spool_path, spool_segment_size);
+            spooling_ = !spool_->empty();
+        }
+
+        worker_ = std::thread(&message_tracer::run, this);
+    }
 
     //todo mohsen
     //mQueueFullEvent.SetMonitoringName("Broker.QueueFullEvent");
@@ -29,26 +116,76 @@ message_tracer::message_tracer(std::shared_ptr<smpp_gateway> smpp_gateway, pa::c
 message_tracer::~message_tracer()
 {
     stop();
+
+    if(file_sink_)
+    {
+        std::fclose(file_sink_);
+    }
 }
 
 void message_tracer::stop()
 {
-    this->producer_->flush();
+    stop_.store(true);
+
+    if(worker_.joinable())
+    {
+        worker_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(producer_mutex_);
+
+    if(this->producer_)
+    {
+        this->producer_->flush();
+    }
+
+    // the final flush may have spooled undelivered events
+    if(spool_)
+    {
+        spool_->flush();
+    }
 }
 
-void message_tracer::on_config_replace(const std::shared_ptr<pa::config::node>& config)
+void message_tracer::create_producer()
 {
     //Construct the configuration
     cppkafka::Configuration kafka_config = {
         { "metadata.broker.list", this->brokers_ }
     };
 
-    kafka_config.set_delivery_report_callback([&](cppkafka::Producer&, const cppkafka::Message& msg)
+    kafka_config.set_delivery_report_callback([this](cppkafka::Producer&, const cppkafka::Message& msg)
     {
-        LOG_INFO("delivery_report_callback topic({})", msg.get_topic());
+        if(!msg.get_error())
+        {
+            LOG_INFO("delivery_report_callback topic({})", msg.get_topic());
+            return;
+        }
+
+        // in async mode the callback runs on the background thread, which owns the spool
+        const auto error = msg.get_error().get_error();
+        if(spool_ && (error == RD_KAFKA_RESP_ERR__MSG_TIMED_OUT || error == RD_KAFKA_RESP_ERR__TRANSPORT || error == RD_KAFKA_RESP_ERR__ALL_BROKERS_DOWN))
+        {
+            const auto& payload = msg.get_payload();
+            spool_->append(std::string_view(reinterpret_cast<const char*>(payload.get_data()), payload.get_size()));
+            spooling_ = true;
+            return;
+        }
+
+        LOG_ERROR("trace delivery to topic({}) failed: {}", msg.get_topic(), msg.get_error().to_string());
     });
 
-    this->producer_ = std::make_unique<cppkafka::Producer>(kafka_config);
+    auto producer = std::make_unique<cppkafka::Producer>(kafka_config);
+
+    std::lock_guard<std::mutex> lock(producer_mutex_);
+    this->producer_ = std::move(producer);
+}
+
+void message_tracer::on_config_replace(const std::shared_ptr<pa::config::node>& config)
+{
+    if(sink_ == tracer_sink::kafka)
+    {
+        create_producer();
+    }
 
     //todo mohsen
     //mQueueFullEvent.SetMonitoringName("Broker.QueueFullEvent");
@@ -92,6 +229,17 @@ void message_tracer::trace_message(uint32_t                     message_type,
         std::string data;
         obj->SerializeToString(&data);
 
+        if(mode_ == tracer_mode::async)
+        {
+            // never block the caller, a full ring drops the event
+            if(!ring_->try_push(std::move(data)))
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            return;
+        }
+
         produce(data);
     }
 } //message_tracer::trace_message
@@ -100,6 +248,8 @@ void message_tracer::produce(const std::string& data)
 {
     //LOG_DEBUG("produce to kafka called");
 
+    std::lock_guard<std::mutex> lock(producer_mutex_);
+
     this->producer_->poll(std::chrono::milliseconds(0));
     int err = RD_KAFKA_RESP_ERR_UNKNOWN;
 
@@ -136,3 +286,122 @@ void message_tracer::produce(const std::string& data)
 
     //LOG_DEBUG("Produce to kafka returned");
 } //message_tracer::Produce
+
+void message_tracer::run()
+{
+    std::string data;
+    auto last_drop_report = std::chrono::steady_clock::now();
+
+    while(true)
+    {
+        const bool stopping = stop_.load();
+        size_t count = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(producer_mutex_);
+
+            while(count < MAX_BATCH_SIZE && ring_->try_pop(data))
+            {
+                deliver(data);
+                count++;
+            }
+
+            if(sink_ == tracer_sink::file)
+            {
+                if(count)
+                {
+                    std::fflush(file_sink_);
+                }
+            }
+            else
+            {
+                if(spooling_)
+                {
+                    // replay stops at the first event the producer can not take yet
+                    spool_->replay([this](std::string_view record) { return try_produce(record); });
+                    spool_->flush();
+
+                    if(spool_->empty())
+                    {
+                        spooling_ = false;
+                        LOG_INFO("tracer spool is replayed");
+                    }
+                }
+
+                this->producer_->poll(std::chrono::milliseconds(0));
+            }
+        }
+
+        if(auto now = std::chrono::steady_clock::now(); now - last_drop_report >= DROP_REPORT_INTERVAL)
+        {
+            last_drop_report = now;
+
+            if(auto dropped = dropped_.exchange(0); dropped)
+            {
+                LOG_WARN("{} trace events are dropped, tracer queue is full", dropped);
+            }
+        }
+
+        if(count == 0)
+        {
+            if(stopping)
+            {
+                break;
+            }
+
+            std::this_thread::sleep_for(IDLE_WAIT);
+        }
+    }
+} //message_tracer::run
+
+void message_tracer::deliver(const std::string& data)
+{
+    if(sink_ == tracer_sink::file)
+    {
+        write_to_file(data);
+        return;
+    }
+
+    // once spooling, new events are spooled behind the older ones until the spool is replayed
+    if(spooling_ || !try_produce(data))
+    {
+        if(!spooling_)
+        {
+            LOG_WARN("tracer producer queue is full, spooling events");
+            spooling_ = true;
+        }
+
+        spool_->append(data);
+    }
+}
+
+bool message_tracer::try_produce(std::string_view data)
+{
+    try
+    {
+        this->producer_->produce(cppkafka::MessageBuilder(this->topic_).payload(cppkafka::Buffer(data.data(), data.size())));
+    }
+    catch(cppkafka::HandleException& e)
+    {
+        if(e.get_error().get_error() == RD_KAFKA_RESP_ERR__QUEUE_FULL)
+        {
+            return false;
+        }
+
+        // retrying would not help, the event is dropped
+        LOG_ERROR("produce trace to topic {} failed: {}", this->topic_, e.what());
+    }
+
+    return true;
+}
+
+void message_tracer::write_to_file(std::string_view data)
+{
+    const auto length = static_cast<uint32_t>(data.size());
+
+    if(std::fwrite(&length, sizeof(length), 1, file_sink_) != 1 ||
+       std::fwrite(data.data(), 1, data.size(), file_sink_) != data.size())
+    {
+        LOG_ERROR("could not write trace event to file");
+    }
+}
@@ -1,9 +1,16 @@
 #pragma once
 
 #include "src/smpp_gateway.h"
+#include "src/libs/bounded_ring.hpp"
+#include "src/logging/tracer_spool.h"
 #include "tracer/MessageTracer.pb.h"
 #include <cppkafka/producer.h>
 
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
 class message_tracer
 {
 public:
@@ -28,7 +35,25 @@ public:
                        const std::string&           error_str);
 
 private:
+    enum class tracer_mode
+    {
+        sync,  // produce on the caller's thread, retry while the producer queue is full
+        async  // queue events in a bounded ring, a background thread produces or spools them
+    };
+
+    enum class tracer_sink
+    {
+        kafka,
+        file   // length-prefixed serialized packets, for running without a broker
+    };
+
     void produce(const std::string& data);
+    void create_producer();
+
+    void run();
+    void deliver(const std::string& data);
+    bool try_produce(std::string_view data);
+    void write_to_file(std::string_view data);
 
 private:
     std::shared_ptr<smpp_gateway> smpp_gateway_;
@@ -39,6 +64,8 @@ private:
     bool enabled_ = false;
 
     std::unique_ptr<cppkafka::Producer> producer_;
+    // trace_message() is called from every io_context shard
+    std::mutex producer_mutex_;
 
     std::string brokers_;
 
@@ -47,7 +74,18 @@ private:
     std::string queue_buffering_max_messages = "5000";
     std::string batch_num_messages = "1000";
     std::string queue_buffering_max_ms = "100";
-    
+
+    tracer_mode mode_ = tracer_mode::sync;
+    tracer_sink sink_ = tracer_sink::kafka;
+
+    std::unique_ptr<io::bounded_ring<std::string>> ring_; // async mode only
+    std::unique_ptr<tracer_spool> spool_;                 // async mode with kafka sink only
+    std::FILE* file_sink_ = nullptr;
+    bool spooling_ = false; // events go to the spool until it is replayed, to keep their order
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> stop_{false};
+    std::thread worker_;
+
     pa::config::manager::observer config_obs_replace_;
 
     //todo mohsen
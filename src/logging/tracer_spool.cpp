@@ -0,0 +1,192 @@
+#include "src/logging/tracer_spool.h"
+
+#include "src/libs/logging.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+static const std::string spool_extension = ".spool";
+
+tracer_spool::tracer_spool(const std::string& spool_path, size_t segment_size)
+    : spool_path_{spool_path}
+    , segment_size_{segment_size}
+{
+    if(spool_path_.empty() || spool_path_.back() != '/')
+    {
+        spool_path_ += '/';
+    }
+
+    fs::create_directories(spool_path_);
+
+    for(const auto& entry : fs::directory_iterator(spool_path_))
+    {
+        if(entry.is_regular_file() && entry.path().extension() == spool_extension)
+        {
+            try
+            {
+                segments_.push_back(std::stoull(entry.path().stem().string()));
+            }
+            catch(...)
+            {
+                LOG_WARN("ignore unknown file {} in tracer spool", entry.path().string());
+            }
+        }
+    }
+
+    std::sort(segments_.begin(), segments_.end());
+
+    if(!segments_.empty())
+    {
+        next_seq_ = segments_.back() + 1;
+        LOG_INFO("{} tracer spool segments are found in {}, they will be replayed", segments_.size(), spool_path_);
+    }
+}
+
+tracer_spool::~tracer_spool()
+{
+    // unconsumed records stay on disk and are replayed by the next run
+    close_write_segment();
+
+    if(read_file_)
+    {
+        std::fclose(read_file_);
+    }
+}
+
+std::string tracer_spool::segment_name(uint64_t seq) const
+{
+    return fmt::format("{}{:016}{}", spool_path_, seq, spool_extension);
+}
+
+bool tracer_spool::append(std::string_view record)
+{
+    if(!write_file_)
+    {
+        write_seq_ = next_seq_++;
+        write_file_ = std::fopen(segment_name(write_seq_).c_str(), "wb");
+
+        if(!write_file_)
+        {
+            LOG_ERROR("could not create tracer spool segment {}", segment_name(write_seq_));
+            return false;
+        }
+
+        write_size_ = 0;
+    }
+
+    const auto length = static_cast<uint32_t>(record.size());
+
+    if(std::fwrite(&length, sizeof(length), 1, write_file_) != 1 ||
+       std::fwrite(record.data(), 1, record.size(), write_file_) != record.size())
+    {
+        LOG_ERROR("could not write to tracer spool segment {}", segment_name(write_seq_));
+        return false;
+    }
+
+    write_size_ += sizeof(length) + record.size();
+
+    if(write_size_ >= segment_size_)
+    {
+        close_write_segment();
+    }
+
+    return true;
+} //tracer_spool::append
+
+void tracer_spool::flush()
+{
+    if(write_file_)
+    {
+        std::fflush(write_file_);
+    }
+}
+
+void tracer_spool::close_write_segment()
+{
+    if(!write_file_)
+    {
+        return;
+    }
+
+    std::fclose(write_file_);
+    write_file_ = nullptr;
+
+    segments_.push_back(write_seq_);
+    write_size_ = 0;
+}
+
+bool tracer_spool::read_record()
+{
+    uint32_t length = 0;
+
+    if(std::fread(&length, sizeof(length), 1, read_file_) != 1)
+    {
+        return false;
+    }
+
+    pending_.resize(length);
+
+    return std::fread(pending_.data(), 1, length, read_file_) == length;
+}
+
+size_t tracer_spool::replay(const std::function<bool(std::string_view)>& handler)
+{
+    size_t consumed = 0;
+
+    while(true)
+    {
+        if(!has_pending_)
+        {
+            if(!read_file_)
+            {
+                if(segments_.empty())
+                {
+                    if(write_size_ == 0)
+                    {
+                        return consumed;
+                    }
+
+                    // the segment being written is drained as well
+                    close_write_segment();
+                }
+
+                read_seq_ = segments_.front();
+                segments_.pop_front();
+
+                read_file_ = std::fopen(segment_name(read_seq_).c_str(), "rb");
+
+                if(!read_file_)
+                {
+                    LOG_ERROR("could not open tracer spool segment {}", segment_name(read_seq_));
+                    continue;
+                }
+            }
+
+            if(!read_record())
+            {
+                std::fclose(read_file_);
+                read_file_ = nullptr;
+                std::remove(segment_name(read_seq_).c_str());
+                continue;
+            }
+
+            has_pending_ = true;
+        }
+
+        if(!handler(pending_))
+        {
+            return consumed;
+        }
+
+        has_pending_ = false;
+        consumed++;
+    }
+} //tracer_spool::replay
+
+bool tracer_spool::empty() const
+{
+    return !has_pending_ && !read_file_ && segments_.empty() && write_size_ == 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Segmented on-disk queue of length-prefixed records, used by message_tracer while the broker is
+ * slow or down. Segments are replayed oldest first and deleted once consumed; segments left by a previous
+ * run are picked up again, from the start of the segment, so a record may be delivered twice after a restart.
+ * Not thread safe, it is only used by the tracer's background thread.
+ */
+class tracer_spool
+{
+public:
+    tracer_spool(const std::string& spool_path, size_t segment_size);
+    virtual ~tracer_spool();
+
+    tracer_spool(const tracer_spool&) = delete;
+    tracer_spool& operator=(const tracer_spool&) = delete;
+
+    bool append(std::string_view record);
+    void flush();
+
+    /**
+     * @brief replay, passes spooled records to handler in order until it returns false or the spool is empty.
+     * a record refused by handler is offered again on the next call
+     * @return number of records consumed
+     */
+    size_t replay(const std::function<bool(std::string_view)>& handler);
+
+    bool empty() const;
+
+private:
+    std::string segment_name(uint64_t seq) const;
+    void close_write_segment();
+    bool read_record();
+
+    std::string spool_path_;
+    size_t segment_size_;
+    std::deque<uint64_t> segments_; // closed segments, oldest first
+    uint64_t next_seq_ = 1;
+
+    std::FILE* write_file_ = nullptr;
+    uint64_t write_seq_ = 0;
+    size_t write_size_ = 0;
+
+    std::FILE* read_file_ = nullptr;
+    uint64_t read_seq_ = 0;
+    std::string pending_;
+    bool has_pending_ = false;
+};
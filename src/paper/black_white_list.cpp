@@ -0,0 +1,98 @@
+#include "black_white_list.h"
+
+black_white_list::black_white_list(pa::config::manager* config_manager, const std::shared_ptr<pa::config::node>& config)
+    : bits_per_number_{config->at("bits_per_number")->get<uint32_t>()}
+    , config_obs_source_black_list_replace_{config_manager->on_replace(config->at("source_black_list"), std::bind_front(&black_white_list::on_source_black_list_replace, this))}
+    , config_obs_source_white_list_replace_{config_manager->on_replace(config->at("source_white_list"), std::bind_front(&black_white_list::on_source_white_list_replace, this))}
+    , config_obs_destination_black_list_replace_{config_manager->on_replace(config->at("destination_black_list"), std::bind_front(&black_white_list::on_destination_black_list_replace, this))}
+{
+    // a broken list at startup is a config error, so it is not caught here
+    auto initial = std::make_shared<lists>();
+    initial->source_black = open(config->at("source_black_list")->get<std::string>());
+    initial->source_white = open(config->at("source_white_list")->get<std::string>());
+    initial->destination_black = open(config->at("destination_black_list")->get<std::string>());
+
+    lists_.store(std::move(initial), std::memory_order_release);
+}
+
+std::optional<pa::paper::proto::Status> black_white_list::check(const std::string& src_address, const std::string& dst_address) const
+{
+    const auto current = lists_.load(std::memory_order_acquire);
+
+    if(current->source_black || current->source_white)
+    {
+        const auto number = io::number_list::to_number(src_address);
+        if(!number)
+        {
+            return std::nullopt;
+        }
+
+        if(current->source_white && !current->source_white->contains(*number))
+        {
+            return pa::paper::proto::Status::SOURCE_NUMBER_NOT_IN_WHITE_LIST;
+        }
+
+        if(current->source_black && current->source_black->contains(*number))
+        {
+            return pa::paper::proto::Status::SOURCE_NUMBER_IN_BLACK_LIST;
+        }
+    }
+
+    if(current->destination_black)
+    {
+        const auto number = io::number_list::to_number(dst_address);
+        if(!number)
+        {
+            return std::nullopt;
+        }
+
+        if(current->destination_black->contains(*number))
+        {
+            return pa::paper::proto::Status::DESTINATION_NUMBER_IN_BLACK_LIST;
+        }
+    }
+
+    return pa::paper::proto::Status::OK;
+}
+
+std::shared_ptr<const io::number_list> black_white_list::open(const std::string& path) const
+{
+    if(path.empty())
+    {
+        return nullptr;
+    }
+
+    return std::make_shared<const io::number_list>(path, bits_per_number_);
+}
+
+void black_white_list::replace(std::shared_ptr<const io::number_list> lists::*list, const std::shared_ptr<pa::config::node>& config)
+{
+    const auto path = config->get<std::string>();
+
+    try
+    {
+        auto next = std::make_shared<lists>(*lists_.load(std::memory_order_acquire));
+        (*next).*list = open(path);
+
+        lists_.store(std::move(next), std::memory_order_release);
+    }
+    catch(const std::exception& ex)
+    {
+        LOG_ERROR("could not load black/white list {}, the previous list is kept, error: {}", path, ex.what());
+    }
+}
+
+void black_white_list::on_source_black_list_replace(const std::shared_ptr<pa::config::node>& config)
+{
+    replace(&lists::source_black, config);
+}
+
+void black_white_list::on_source_white_list_replace(const std::shared_ptr<pa::config::node>& config)
+{
+    replace(&lists::source_white, config);
+}
+
+void black_white_list::on_destination_black_list_replace(const std::shared_ptr<pa::config::node>& config)
+{
+    replace(&lists::destination_black, config);
+}
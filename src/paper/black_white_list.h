@@ -0,0 +1,57 @@
+#pragma once
+
+#include "paper/command.pb.h"
+#include "src/libs/number_list.hpp"
+
+#include <pa/config.hpp>
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+
+/**
+ * @brief In-process answer to BLACK_WHITE_CHECK from memory-mapped number lists.
+ *
+ * Every list is optional, an empty path disables it. Replacing a path in the config loads the new file on the
+ * config thread and swaps it in as a whole, a file which fails to load keeps the previous list.
+ */
+class black_white_list
+{
+    struct lists
+    {
+        std::shared_ptr<const io::number_list> source_black;
+        std::shared_ptr<const io::number_list> source_white;
+        std::shared_ptr<const io::number_list> destination_black;
+    };
+
+public:
+    black_white_list(pa::config::manager* config_manager, const std::shared_ptr<pa::config::node>& config);
+    virtual ~black_white_list() = default;
+
+    /**
+     * @return verdict of the check, nullopt if a listed address is not a number and paper has to decide
+     */
+    std::optional<pa::paper::proto::Status> check(const std::string& src_address, const std::string& dst_address) const;
+
+private:
+    /**
+     * @return nullptr for an empty path
+     * @throws std::runtime_error if the file is not a valid number list
+     */
+    std::shared_ptr<const io::number_list> open(const std::string& path) const;
+
+    void replace(std::shared_ptr<const io::number_list> lists::*list, const std::shared_ptr<pa::config::node>& config);
+
+    void on_source_black_list_replace(const std::shared_ptr<pa::config::node>& config);
+    void on_source_white_list_replace(const std::shared_ptr<pa::config::node>& config);
+    void on_destination_black_list_replace(const std::shared_ptr<pa::config::node>& config);
+
+    size_t bits_per_number_;
+
+    pa::config::manager::observer config_obs_source_black_list_replace_;
+    pa::config::manager::observer config_obs_source_white_list_replace_;
+    pa::config::manager::observer config_obs_destination_black_list_replace_;
+
+    std::atomic<std::shared_ptr<const lists> > lists_;
+};
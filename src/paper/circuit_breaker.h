@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Health of one paper node over its most recent requests.
+ *
+ * Closed, requests flow and every outcome is kept in a rolling window. Once the window holds enough outcomes
+ * and too many of them failed or were slow, the breaker opens and the node gets no requests for open_duration.
+ * Then it is half open, a single probe request is let through and its outcome closes or opens it again. Outcomes of
+ * requests sent before half_open_since() are not the probe's, the caller drops them.
+ * Not thread safe, it is used from the io_context which owns paper_client.
+ */
+class circuit_breaker
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct settings
+    {
+        size_t window = 0; /**< 0 disables the breaker, it never opens */
+        size_t min_requests = 0;
+        uint32_t max_error_percent = 100;
+        uint32_t max_slow_percent = 100;
+        std::chrono::microseconds slow_latency{0};
+        std::chrono::milliseconds open_duration{0};
+    };
+
+    enum class state
+    {
+        closed,
+        open,
+        half_open
+    };
+
+    explicit circuit_breaker(const settings* config)
+        : config_{config}
+        , outcomes_(config->window)
+    {
+    }
+
+    /**
+     * @return whether a request may be sent to the node now, in half open state only the first caller gets true
+     */
+    bool allow(clock::time_point now)
+    {
+        switch(state_)
+        {
+            case state::closed:
+                return true;
+
+            case state::open:
+                if(now < open_until_)
+                {
+                    return false;
+                }
+
+                state_ = state::half_open;
+                half_open_since_ = now;
+                probing_ = true;
+                return true;
+
+            case state::half_open:
+                if(probing_)
+                {
+                    return false;
+                }
+
+                probing_ = true;
+                return true;
+        }
+
+        return false;
+    }
+
+    void on_outcome(bool failed, std::chrono::microseconds latency, clock::time_point now)
+    {
+        const bool slow = config_->slow_latency.count() && latency >= config_->slow_latency;
+
+        if(state_ == state::half_open)
+        {
+            probing_ = false;
+
+            if(failed || slow)
+            {
+                open(now);
+            }
+            else
+            {
+                reset();
+                state_ = state::closed;
+            }
+
+            return;
+        }
+
+        // outcomes of requests sent before the breaker opened
+        if(state_ == state::open || outcomes_.empty())
+        {
+            return;
+        }
+
+        auto& outcome = outcomes_[next_];
+        if(count_ == outcomes_.size())
+        {
+            errors_ -= outcome.failed;
+            slows_ -= outcome.slow;
+        }
+        else
+        {
+            count_++;
+        }
+
+        outcome = { failed, slow };
+        errors_ += failed;
+        slows_ += slow;
+        next_ = (next_ + 1) % outcomes_.size();
+
+        if(count_ >= std::max<size_t>(config_->min_requests, 1) &&
+           (errors_ * 100 > config_->max_error_percent * count_ || slows_ * 100 > config_->max_slow_percent * count_))
+        {
+            open(now);
+        }
+    }
+
+    state current_state() const
+    {
+        return state_;
+    }
+
+    /**
+     * @return the time passed to the allow() which let the probe through
+     */
+    clock::time_point half_open_since() const
+    {
+        return half_open_since_;
+    }
+
+private:
+    struct outcome
+    {
+        bool failed = false;
+        bool slow = false;
+    };
+
+    void open(clock::time_point now)
+    {
+        state_ = state::open;
+        open_until_ = now + config_->open_duration;
+        reset();
+    }
+
+    void reset()
+    {
+        count_ = 0;
+        errors_ = 0;
+        slows_ = 0;
+        next_ = 0;
+    }
+
+    const settings* config_;
+
+    state state_ = state::closed;
+    clock::time_point open_until_;
+    clock::time_point half_open_since_;
+    bool probing_ = false;
+
+    std::vector<outcome> outcomes_; // ring of the last window outcomes
+    size_t next_ = 0;
+    size_t count_ = 0;
+    size_t errors_ = 0;
+    size_t slows_ = 0;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+/**
+ * @brief Percentile of the most recent response latencies.
+ *
+ * Samples go into a ring, the percentile is recomputed from a copy of it every refresh_interval samples so a
+ * lookup costs nothing. Not thread safe, it is used from the io_context which owns paper_client.
+ */
+class latency_window
+{
+public:
+    latency_window(uint32_t percentile, size_t size = 1024, size_t refresh_interval = 64)
+        : percentile_{std::min<uint32_t>(percentile, 100)}
+        , samples_(size)
+        , refresh_interval_{refresh_interval}
+    {
+    }
+
+    void record(std::chrono::microseconds latency)
+    {
+        samples_[next_] = latency;
+        next_ = (next_ + 1) % samples_.size();
+        count_ = std::min(count_ + 1, samples_.size());
+
+        if(++since_refresh_ >= refresh_interval_)
+        {
+            refresh();
+        }
+    }
+
+    /**
+     * @return zero until the first refresh
+     */
+    std::chrono::microseconds value() const
+    {
+        return value_;
+    }
+
+private:
+    void refresh()
+    {
+        since_refresh_ = 0;
+
+        scratch_.assign(samples_.begin(), samples_.begin() + count_);
+
+        auto nth = scratch_.begin() + std::min(count_ - 1, count_ * percentile_ / 100);
+        std::nth_element(scratch_.begin(), nth, scratch_.end());
+        value_ = *nth;
+    }
+
+    uint32_t percentile_;
+    std::vector<std::chrono::microseconds> samples_;
+    std::vector<std::chrono::microseconds> scratch_;
+    size_t refresh_interval_;
+    size_t next_ = 0;
+    size_t count_ = 0;
+    size_t since_refresh_ = 0;
+    std::chrono::microseconds value_{0};
+};
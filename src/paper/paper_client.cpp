@@ -34,6 +34,57 @@ static std::map<pa::paper::proto::Status, pa::smpp::command_status> paper_status
     { pa::paper::proto::Status::UNSUPPORTED_COMMAND,              pa::smpp::command_status::rsyserr               }
 };
 
+// only checks whose answer depends on nothing but the request fields, never credit control or refund
+static const std::map<std::string, pa::paper::proto::Request_Type> cacheable_commands = {
+    { "source_address_check",      pa::paper::proto::Request::SOURCE_ADDRESS_CHECK      },
+    { "source_ton_npi_check",      pa::paper::proto::Request::SOURCE_TON_NPI_CHECK      },
+    { "destination_address_check", pa::paper::proto::Request::DESTINATION_ADDRESS_CHECK },
+    { "destination_ton_npi_check", pa::paper::proto::Request::DESTINATION_TON_NPI_CHECK },
+    { "dcs_check",                 pa::paper::proto::Request::DCS_CHECK                 },
+    { "black_white_check",         pa::paper::proto::Request::BLACK_WHITE_CHECK         }
+};
+
+static std::shared_ptr<pa::config::node> verdict_cache_config(const std::shared_ptr<pa::config::node>& config)
+{
+    try
+    {
+        return config->at("verdict_cache");
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+}
+
+static size_t verdict_cache_capacity(const std::shared_ptr<pa::config::node>& config)
+{
+    auto cache_config = verdict_cache_config(config);
+    return cache_config ? cache_config->at("capacity")->get<uint32_t>() : 0;
+}
+
+// verdicts which tell something about the request, errors and timeouts are asked again
+static bool is_cacheable_verdict(pa::paper::proto::Status status)
+{
+    switch(status)
+    {
+        case pa::paper::proto::Status::OK:
+        case pa::paper::proto::Status::INVALID_DATA_CODING:
+        case pa::paper::proto::Status::SOURCE_NUMBER_IN_BLACK_LIST:
+        case pa::paper::proto::Status::SOURCE_NUMBER_NOT_IN_WHITE_LIST:
+        case pa::paper::proto::Status::SOURCE_NUMBER_NOT_VALID:
+        case pa::paper::proto::Status::SOURCE_NUMBER_INVALID_TON:
+        case pa::paper::proto::Status::SOURCE_NUMBER_INVALID_NPI:
+        case pa::paper::proto::Status::DESTINATION_NUMBER_NOT_VALID:
+        case pa::paper::proto::Status::DESTINATION_NUMBER_INVALID_TON:
+        case pa::paper::proto::Status::DESTINATION_NUMBER_INVALID_NPI:
+        case pa::paper::proto::Status::DESTINATION_NUMBER_IN_BLACK_LIST:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
 paper_client::paper_client(
     std::shared_ptr<smpp_gateway>            smpp_gateway,
     boost::asio::io_context*                 io_context,
@@ -88,7 +139,95 @@ paper_client::paper_client(
     , submits_rejected_(add_counter(policy_rules_family_counter_, prometheus_config->at("labels"), {
         { "name", "submits_rejected" }, { "system_id", config->at("name")->get<std::string>() }
 }))
+    , verdict_cache_hits_(add_counter(policy_rules_family_counter_, prometheus_config->at("labels"), {
+    { "name", "verdict_cache_hits" }, { "category", "command" }, { "system_id", config->at("name")->get<std::string>()}
+}))
+    , local_black_white_check_(add_counter(policy_rules_family_counter_, prometheus_config->at("labels"), {
+    { "name", "local_black_white_check" }, { "category", "command" }, { "system_id", config->at("name")->get<std::string>()}
+}))
+    , hedged_requests_(add_counter(policy_rules_family_counter_, prometheus_config->at("labels"), {
+    { "name", "hedged_req" }, { "category", "network" }, { "system_id", config->at("name")->get<std::string>()}
+}))
+    , verdict_cache_{verdict_cache_capacity(config)}
+    , batch_timer_{*io_context}
+    , hedge_timer_{*io_context}
 {
+    std::shared_ptr<pa::config::node> black_white_list_config;
+    try
+    {
+        black_white_list_config = config_->at("black_white_list");
+    }
+    catch(...)
+    {
+    }
+
+    if(black_white_list_config)
+    {
+        black_white_list_ = std::make_unique<black_white_list>(config_manager_, black_white_list_config);
+    }
+
+    try
+    {
+        auto batch_config = config_->at("batch");
+        batch_max_requests_ = batch_config->at("max_requests")->get<uint32_t>();
+        batch_window_ = std::chrono::microseconds(batch_config->at("window_us")->get<uint32_t>());
+    }
+    catch(...)
+    {
+        batch_max_requests_ = 0;
+    }
+
+    std::shared_ptr<pa::config::node> breaker_config;
+    try
+    {
+        breaker_config = config_->at("circuit_breaker");
+    }
+    catch(...)
+    {
+    }
+
+    if(breaker_config)
+    {
+        breaker_settings_.window = breaker_config->at("window")->get<uint32_t>();
+        breaker_settings_.min_requests = breaker_config->at("min_requests")->get<uint32_t>();
+        breaker_settings_.max_error_percent = breaker_config->at("max_error_percent")->get<uint32_t>();
+        breaker_settings_.max_slow_percent = breaker_config->at("max_slow_percent")->get<uint32_t>();
+        breaker_settings_.slow_latency = std::chrono::milliseconds(breaker_config->at("slow_latency_ms")->get<uint32_t>());
+        breaker_settings_.open_duration = std::chrono::milliseconds(breaker_config->at("open_duration_ms")->get<uint32_t>());
+    }
+
+    std::shared_ptr<pa::config::node> hedge_config;
+    try
+    {
+        hedge_config = config_->at("hedge");
+    }
+    catch(...)
+    {
+    }
+
+    if(hedge_config)
+    {
+        hedge_latency_.emplace(hedge_config->at("percentile")->get<uint32_t>());
+        hedge_min_delay_ = std::chrono::milliseconds(hedge_config->at("min_delay_ms")->get<uint32_t>());
+    }
+
+    if(auto cache_config = verdict_cache_config(config))
+    {
+        auto ttl_config = cache_config->at("ttl");
+
+        for(const auto& [name, command] : cacheable_commands)
+        {
+            try
+            {
+                if(auto ttl = ttl_config->at(name)->get<uint32_t>())
+                    verdict_ttls_.emplace(command, std::chrono::seconds(ttl));
+            }
+            catch(...)
+            {
+            }
+        }
+    }
+
     LOG_INFO("paper_client configuration applied successfully.");
 
     for(auto& n : config_->at("address")->nodes())
@@ -123,6 +262,11 @@ void paper_client::stop()
         return;
     }
 
+    flush_batch();
+
+    hedge_timer_.cancel();
+    hedge_queue_.clear();
+
     client_list_->stop();
     client_list_ = nullptr;
 }
@@ -139,15 +283,98 @@ void paper_client::session_state_changed(const std::string& name, session_stat s
         case session_stat::bind:
             LOG_INFO("State of connection {} => {} is changed to bind", client_name_, name);
             connected_clients_.Increment();
+            if(std::none_of(nodes_.begin(), nodes_.end(), [&name](const paper_node& node) { return node.id == name; }))
+            {
+                nodes_.push_back(paper_node{ name, circuit_breaker(&breaker_settings_) });
+            }
             break;
 
         case session_stat::close:
             LOG_INFO("State of connection {} => {} is changed to close", client_name_, name);
             connected_clients_.Decrement();
+            std::erase_if(nodes_, [&name](const paper_node& node) { return node.id == name; });
             break;
     } //switch
 }
 
+std::string paper_client::make_verdict_key(const pa::paper::proto::Request& cmd,
+                                           const std::set<pa::paper::proto::Request_Type>& commands,
+                                           std::chrono::seconds& ttl) const
+{
+    if(commands.empty())
+    {
+        return {};
+    }
+
+    bool source = false;
+    bool destination = false;
+    bool dcs = false;
+
+    ttl = std::chrono::seconds::max();
+
+    for(auto command : commands)
+    {
+        auto itr = verdict_ttls_.find(command);
+        if(itr == verdict_ttls_.end())
+        {
+            return {};
+        }
+
+        ttl = std::min(ttl, itr->second);
+
+        switch(command)
+        {
+            case pa::paper::proto::Request::SOURCE_ADDRESS_CHECK:
+            case pa::paper::proto::Request::SOURCE_TON_NPI_CHECK:
+                source = true;
+                break;
+
+            case pa::paper::proto::Request::DESTINATION_ADDRESS_CHECK:
+            case pa::paper::proto::Request::DESTINATION_TON_NPI_CHECK:
+                destination = true;
+                break;
+
+            case pa::paper::proto::Request::DCS_CHECK:
+                dcs = true;
+                break;
+
+            default:
+                // black/white lists are kept for both addresses
+                source = true;
+                destination = true;
+                break;
+        } //switch
+    }
+
+    // the one verdict answers all commands together, so the command set is a part of the key
+    std::string key;
+    for(auto command : commands)
+    {
+        key += std::to_string(static_cast<int>(command));
+        key += ',';
+    }
+
+    key += '\x1f';
+    key += cmd.cp_system_id();
+
+    if(source)
+    {
+        key += fmt::format("\x1f{}\x1f{}\x1f{}", cmd.src_address(), cmd.src_ton(), cmd.src_npi());
+    }
+
+    if(destination)
+    {
+        key += fmt::format("\x1f{}\x1f{}\x1f{}", cmd.dst_address(), cmd.dst_ton(), cmd.dst_npi());
+    }
+
+    if(dcs)
+    {
+        key += fmt::format("\x1f{}", cmd.dcs());
+    }
+
+    return key;
+}
+
 void paper_client::on_timeout_replace(const std::shared_ptr<pa::config::node>& config)
 {
     timeout_ = config->get<int8_t>();
@@ -181,58 +408,114 @@ bool paper_client::check_policies(const std::string&
 
     cmd.set_dcs(static_cast<uint32_t>(user_data->request.data_coding));
 
+    // commands are counted as requested, whether the verdict comes from paper, the local lists or the verdict cache
+    std::set<pa::paper::proto::Request_Type> requested_commands;
+
     for(auto itr : commands)
     {
         switch(itr)
         {
             case pa::paper::proto::Request::SOURCE_ADDRESS_CHECK:
                 source_address_check_.Increment();
-                cmd.add_cmd_type(pa::paper::proto::Request::SOURCE_ADDRESS_CHECK);
                 break;
 
             case pa::paper::proto::Request::SOURCE_TON_NPI_CHECK:
                 source_ton_npi_check_.Increment();
-                cmd.add_cmd_type(pa::paper::proto::Request::SOURCE_TON_NPI_CHECK);
                 break;
 
             case pa::paper::proto::Request::DESTINATION_ADDRESS_CHECK:
                 destination_address_check_.Increment();
-                cmd.add_cmd_type(pa::paper::proto::Request::DESTINATION_ADDRESS_CHECK);
                 break;
 
             case pa::paper::proto::Request::DESTINATION_TON_NPI_CHECK:
                 destination_ton_npi_check_.Increment();
-                cmd.add_cmd_type(pa::paper::proto::Request::DESTINATION_TON_NPI_CHECK);
                 break;
 
             case pa::paper::proto::Request::DCS_CHECK:
                 dcs_check_.Increment();
-                cmd.add_cmd_type(pa::paper::proto::Request::DCS_CHECK);
                 break;
 
             case pa::paper::proto::Request::BLACK_WHITE_CHECK:
                 black_white_check_.Increment();
-                cmd.add_cmd_type(pa::paper::proto::Request::BLACK_WHITE_CHECK);
                 break;
 
             default:
                 LOG_DEBUG("This command ({}) is not supported yet", static_cast<int>(itr));
+                continue;
         } //switch
+
+        requested_commands.insert(itr);
+    }
+
+    // black/white lists are answered in process if they are loaded here, paper is asked for the rest
+    if(black_white_list_ && requested_commands.contains(pa::paper::proto::Request::BLACK_WHITE_CHECK))
+    {
+        if(auto status = black_white_list_->check(cmd.src_address(), cmd.dst_address()))
+        {
+            local_black_white_check_.Increment();
+
+            if(*status != pa::paper::proto::Status::OK)
+            {
+                complete_locally(user_data, *status);
+                return true;
+            }
+
+            requested_commands.erase(pa::paper::proto::Request::BLACK_WHITE_CHECK);
+
+            if(requested_commands.empty())
+            {
+                complete_locally(user_data, pa::paper::proto::Status::OK);
+                return true;
+            }
+        }
+    }
+
+    std::chrono::seconds verdict_ttl{0};
+    auto verdict_key = make_verdict_key(cmd, requested_commands, verdict_ttl);
+
+    if(!verdict_key.empty())
+    {
+        if(auto status = verdict_cache_.find(verdict_key, verdict_cache::clock::now()))
+        {
+            LOG_DEBUG("Use cached verdict {} of paper", static_cast<int>(*status));
+            verdict_cache_hits_.Increment();
+
+            complete_locally(user_data, *status);
+            return true;
+        }
+    }
+
+    for(auto itr : requested_commands)
+    {
+        cmd.add_cmd_type(itr);
     }
 
     log_protobuf_message(cmd);
 
+    pending_check check{ user_data, std::move(verdict_key), verdict_ttl, clock::now() };
+
+    if(batch_max_requests_)
+    {
+        add_to_batch(std::move(cmd), std::move(check));
+        return true;
+    }
+
     //TODO:: check
     std::string message = cmd.SerializeAsString();
 
     try
     {
-        auto [seq_no, id] = client_list_->send_request(message);
+        auto [seq_no, id] = send_to_node(message, check.sent_time);
 
         if(seq_no)
         {
             LOG_DEBUG("Send command to paper");
-            user_data_.insert({ fmt::format("{}@{}", seq_no, id), user_data });
+            user_data_.insert(id, seq_no, std::move(check));
+
+            if(hedge_latency_)
+            {
+                schedule_hedge(id, seq_no, std::move(message));
+            }
 
             req_success_.Increment();
             return true;
@@ -254,7 +537,228 @@ bool paper_client::check_policies(const std::string&
     return false;
 } //paper_client::check_policies
 
-void paper_client::receive_response(const std::string& client_id, uint32_t seq_no, const std::string& msg_body)
+void paper_client::add_to_batch(pa::paper::proto::Request&& cmd, pending_check&& check)
+{
+    *batch_envelope_.add_batch() = std::move(cmd);
+    batch_checks_.push_back(std::move(check));
+
+    if(batch_checks_.size() >= batch_max_requests_)
+    {
+        flush_batch();
+        return;
+    }
+
+    if(batch_checks_.size() == 1)
+    {
+        batch_timer_.expires_after(batch_window_);
+        batch_timer_.async_wait([this](const boost::system::error_code& ec) {
+            if(ec)
+            {
+                return;
+            }
+
+            flush_batch();
+        });
+    }
+}
+
+void paper_client::flush_batch()
+{
+    if(batch_checks_.empty())
+    {
+        return;
+    }
+
+    batch_timer_.cancel();
+
+    auto checks = std::move(batch_checks_);
+    batch_checks_.clear();
+
+    // the batch is as old as its last check, its latency tells how the node is doing
+    checks.back().sent_time = clock::now();
+
+    std::string message = batch_envelope_.SerializeAsString();
+    batch_envelope_.Clear();
+
+    LOG_DEBUG("Send batch of {} commands to paper", checks.size());
+
+    try
+    {
+        auto [seq_no, id] = send_to_node(message, checks.back().sent_time);
+
+        if(seq_no)
+        {
+            batches_.insert(id, seq_no, std::move(checks));
+
+            req_success_.Increment();
+            return;
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        LOG_ERROR("catch an exception on send, {}", ex.what());
+    }
+    catch (...)
+    {
+        std::exception_ptr p = std::current_exception();
+        LOG_ERROR("catch an exception on send, {}", (p ? p.__cxa_exception_type()->name() : "null"));
+    }
+
+    LOG_ERROR("Could not send batch of {} commands to paper", checks.size());
+
+    req_failed_.Increment();
+
+    // the submits were accepted for checking already, so they are rejected the way check_policies' caller would
+    for(auto& check : checks)
+    {
+        check.info->error_ = pa::smpp::command_status::rsyserr;
+        submits_rejected_.Increment();
+        submit_sm::send_resp(check.info);
+    }
+}
+
+/* sent_time is the time the request is recorded with, a half open breaker compares later outcomes with it */
+std::tuple<uint32_t, std::string> paper_client::send_to_node(const std::string& message, clock::time_point sent_time, const std::string& exclude)
+{
+    for(size_t n = 0; n < nodes_.size(); n++)
+    {
+        auto& node = nodes_[(next_node_ + n) % nodes_.size()];
+
+        if(node.id == exclude || !node.breaker.allow(sent_time))
+        {
+            continue;
+        }
+
+        next_node_ = (next_node_ + n + 1) % nodes_.size();
+
+        if(auto seq_no = client_list_->send_request(message, node.id))
+        {
+            return { seq_no, node.id };
+        }
+
+        record_outcome(node.id, true, sent_time);
+    }
+
+    return { 0, "" };
+}
+
+void paper_client::record_outcome(const std::string& node, bool failed, clock::time_point sent_time)
+{
+    const auto now = clock::now();
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(now - sent_time);
+
+    if(hedge_latency_ && !failed)
+    {
+        hedge_latency_->record(latency);
+    }
+
+    auto itr = std::find_if(nodes_.begin(), nodes_.end(), [&node](const paper_node& n) { return n.id == node; });
+    if(itr == nodes_.end())
+    {
+        return;
+    }
+
+    // a late outcome of a request sent before the breaker opened is not the result of the half open probe
+    if(itr->breaker.current_state() == circuit_breaker::state::half_open && sent_time < itr->breaker.half_open_since())
+    {
+        return;
+    }
+
+    const auto before = itr->breaker.current_state();
+    itr->breaker.on_outcome(failed, latency, now);
+    const auto after = itr->breaker.current_state();
+
+    if(before != after && after == circuit_breaker::state::open)
+    {
+        LOG_WARN("circuit breaker of paper node {} is open for {} ms", node, breaker_settings_.open_duration.count());
+    }
+    else if(before != after && after == circuit_breaker::state::closed)
+    {
+        LOG_INFO("circuit breaker of paper node {} is closed", node);
+    }
+}
+
+void paper_client::schedule_hedge(const std::string& node, uint32_t seq_no, std::string&& message)
+{
+    if(nodes_.size() < 2)
+    {
+        return;
+    }
+
+    const auto delay = std::max(hedge_latency_->value(), hedge_min_delay_);
+    hedge_queue_.push_back(hedge_candidate{ clock::now() + delay, node, seq_no, std::move(message) });
+
+    if(hedge_queue_.size() == 1)
+    {
+        hedge_timer_.expires_at(hedge_queue_.front().deadline);
+        hedge_timer_.async_wait([this](const boost::system::error_code& ec) {
+            if(ec)
+            {
+                return;
+            }
+
+            on_hedge_timer();
+        });
+    }
+}
+
+// deadlines follow the send order unless the percentile moves, a later deadline only delays the ones behind it
+void paper_client::on_hedge_timer()
+{
+    const auto now = clock::now();
+
+    while(!hedge_queue_.empty() && hedge_queue_.front().deadline <= now)
+    {
+        auto candidate = std::move(hedge_queue_.front());
+        hedge_queue_.pop_front();
+
+        auto check = user_data_.find(candidate.node, candidate.seq_no);
+        if(!check || check->abandoned || check->hedge_peer)
+        {
+            continue;
+        }
+
+        auto [seq_no, id] = send_to_node(candidate.message, now, candidate.node);
+        if(!seq_no)
+        {
+            continue;
+        }
+
+        LOG_DEBUG("Hedge command {} of paper node {} to node {}", candidate.seq_no, candidate.node, id);
+
+        check->hedge_peer.emplace(id, seq_no);
+
+        // taken before the insert, which may move the entries
+        pending_check hedge{ check->info, check->verdict_key, check->verdict_ttl, now, std::pair{ candidate.node, candidate.seq_no } };
+        user_data_.insert(id, seq_no, std::move(hedge));
+
+        hedged_requests_.Increment();
+    }
+
+    if(!hedge_queue_.empty())
+    {
+        hedge_timer_.expires_at(hedge_queue_.front().deadline);
+        hedge_timer_.async_wait([this](const boost::system::error_code& ec) {
+            if(ec)
+            {
+                return;
+            }
+
+            on_hedge_timer();
+        });
+    }
+}
+
+void paper_client::complete_locally(std::shared_ptr<submit_info> user_data, pa::paper::proto::Status status)
+{
+    user_data->error_ = paper_status_to_smpp.at(status);
+    if(user_data->error_ != pa::smpp::command_status::rok)
+        submits_rejected_.Increment();
+
+    submit_sm::on_check_policies_responce(this->smpp_gateway_, user_data);
+}
+
+void paper_client::receive_response(const std::string& client_id, uint32_t seq_no, std::string_view msg_body)
 {
     LOG_DEBUG("Receive response with sequence: '{}' from paper: '{}'", seq_no, client_id);
 
@@ -263,7 +767,7 @@ void paper_client::receive_response(const std::string& client_id, uint32_t seq_n
 
     pa::paper::proto::Response resp;
 
-    if(!resp.ParseFromString(msg_body))
+    if(!resp.ParseFromArray(msg_body.data(), static_cast<int>(msg_body.size())))
     {
         LOG_ERROR("Unsupported resp format!");
         return;
@@ -274,7 +778,7 @@ void paper_client::receive_response(const std::string& client_id, uint32_t seq_n
     paper_client::process_resp(client_id, seq_no, std::move(resp));
 } //paper_client::receive_response
 
-void paper_client::timeout_request(const std::string& client_id, uint32_t seq_no, const std::string&)
+void paper_client::timeout_request(const std::string& client_id, uint32_t seq_no, std::string_view)
 {
     LOG_DEBUG("timeout request with sequence: {{}} from paper: {{}}", seq_no, client_id);
 
@@ -290,16 +794,77 @@ void paper_client::timeout_request(const std::string& client_id, uint32_t seq_no
 
 void paper_client::process_resp(const std::string& client_id, uint32_t seq_no, pa::paper::proto::Response&& resp)
 {
-    auto it = user_data_.find(fmt::format("{}@{}", seq_no, client_id));
+    const bool failed = resp.status() == pa::paper::proto::Status::TIMEOUT;
 
-    if(it == user_data_.end())
+    if(auto user_data = user_data_.take(client_id, seq_no))
+    {
+        record_outcome(client_id, failed, user_data->sent_time);
+
+        if(user_data->abandoned)
+        {
+            return;
+        }
+
+        if(user_data->hedge_peer)
+        {
+            if(auto peer = user_data_.find(user_data->hedge_peer->first, user_data->hedge_peer->second))
+            {
+                // the other node may still answer in time
+                if(failed)
+                {
+                    peer->hedge_peer.reset();
+                    return;
+                }
+
+                peer->abandoned = true;
+                peer->info.reset();
+            }
+        }
+
+        finish_check(std::move(*user_data), resp.status());
+        return;
+    }
+
+    auto checks = batches_.take(client_id, seq_no);
+
+    if(!checks)
     {
         LOG_ERROR("Could not find user_data for sequence {}", seq_no);
         return;
     }
 
-    auto submit_data = it->second;
-    user_data_.erase(it);
+    record_outcome(client_id, failed, checks->back().sent_time);
+
+    if(resp.batch_size() && static_cast<size_t>(resp.batch_size()) != checks->size())
+    {
+        LOG_ERROR("paper answered {} of {} commands of batch {}", resp.batch_size(), checks->size(), seq_no);
+    }
+
+    for(size_t i = 0; i < checks->size(); i++)
+    {
+        // a timeout, or a paper which does not know batches, answers the envelope alone
+        auto status = resp.status();
+        if(i < static_cast<size_t>(resp.batch_size()))
+        {
+            status = resp.batch(static_cast<int>(i)).status();
+        }
+        else if(status == pa::paper::proto::Status::OK)
+        {
+            status = pa::paper::proto::Status::UNSUPPORTED_COMMAND;
+        }
+
+        finish_check(std::move((*checks)[i]), status);
+    }
+}
+
+void paper_client::finish_check(pending_check&& check, pa::paper::proto::Status status)
+{
+    auto submit_data = std::move(check.info);
+
+    if(!check.verdict_key.empty() && is_cacheable_verdict(status))
+    {
+        verdict_cache_.insert(std::move(check.verdict_key), status, verdict_cache::clock::now() + check.verdict_ttl);
+    }
 
     //todo:majid darvishan => what we can do here?
     //try
@@ -314,11 +879,11 @@ void paper_client::process_resp(const std::string& client_id, uint32_t seq_no, p
 
     try
     {
-        submit_data->error_ = paper_status_to_smpp.at(resp.status());
+        submit_data->error_ = paper_status_to_smpp.at(status);
     }
     catch(std::out_of_range& exp)
     {
-        LOG_DEBUG("Why get error {} from PAPER, exception: {}", static_cast<int>(resp.status()), exp.what());
+        LOG_DEBUG("Why get error {} from PAPER, exception: {}", static_cast<int>(status), exp.what());
         submit_data->error_ = pa::smpp::command_status::rsyserr;
     }
 
@@ -327,4 +892,3 @@ void paper_client::process_resp(const std::string& client_id, uint32_t seq_no, p
 
     submit_sm::on_check_policies_responce(this->smpp_gateway_, submit_data);
 }
-
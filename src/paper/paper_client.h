@@ -1,16 +1,27 @@
 #pragma once
 
 #include "paper/command.pb.h"
+#include "src/paper/black_white_list.h"
+#include "src/paper/circuit_breaker.h"
+#include "src/paper/latency_window.h"
+#include "src/paper/verdict_cache.h"
+#include "src/libs/correlation_table.hpp"
 #include "src/libs/monitoring.hpp"
 
 #include <pinex/p_client_list.hpp>
 #include <smpp/smpp.hpp>
 
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <prometheus/registry.h>
 
+#include <chrono>
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
+#include <optional>
+#include <string_view>
 
 class submit_info;
 class smpp_gateway;
@@ -37,14 +48,76 @@ public:
                         const std::set<pa::paper::proto::Request_Type>& commands);
 
 private:
-    void receive_response(const std::string& client_id, uint32_t seq_no, const std::string& msg_body);
-    void timeout_request(const std::string& client_id, uint32_t seq_no, const std::string& msg_body);
+    using clock = std::chrono::steady_clock;
+
+    struct pending_check
+    {
+        std::shared_ptr<submit_info> info;
+        std::string verdict_key; /**< empty if the verdict is not cached */
+        std::chrono::seconds verdict_ttl;
+        clock::time_point sent_time;
+        std::optional<std::pair<std::string, uint32_t>> hedge_peer; /**< node and sequence of the same check sent to another node */
+        bool abandoned = false;                                      /**< its hedge peer answered first */
+    };
+
+    struct paper_node
+    {
+        std::string id;
+        circuit_breaker breaker;
+    };
+
+    struct hedge_candidate
+    {
+        clock::time_point deadline;
+        std::string node;
+        uint32_t seq_no;
+        std::string message;
+    };
+
+    void receive_response(const std::string& client_id, uint32_t seq_no, std::string_view msg_body);
+    void timeout_request(const std::string& client_id, uint32_t seq_no, std::string_view msg_body);
     void session_state_changed(const std::string& name, session_stat state);
 
     void process_resp(const std::string& client_id, uint32_t seq_no, pa::paper::proto::Response&& resp);
+    void finish_check(pending_check&& check, pa::paper::proto::Status status);
+
+    /**
+     * @brief sends to the next node whose circuit breaker allows it, skipping `exclude`
+     * @return sequence number 0 if no node took the message
+     */
+    std::tuple<uint32_t, std::string> send_to_node(const std::string& message, clock::time_point sent_time, const std::string& exclude = {});
+    void record_outcome(const std::string& node, bool failed, clock::time_point sent_time);
+
+    /**
+     * @brief sends the message again to another node if (node, seq_no) is not answered within the hedge delay
+     */
+    void schedule_hedge(const std::string& node, uint32_t seq_no, std::string&& message);
+    void on_hedge_timer();
 
     void on_timeout_replace(const std::shared_ptr<pa::config::node>& config);
 
+    /**
+     * @brief answers a submit without asking paper, from a local list or a cached verdict
+     */
+    void complete_locally(std::shared_ptr<submit_info> user_data, pa::paper::proto::Status status);
+
+    /**
+     * @brief collects cmd into the current batch, which is sent when it is full or its window ends
+     */
+    void add_to_batch(pa::paper::proto::Request&& cmd, pending_check&& check);
+
+    /**
+     * @brief sends the collected batch as one envelope request
+     */
+    void flush_batch();
+
+    /**
+     * @brief key of the verdict of commands for cmd, empty if one of the commands may not be cached
+     */
+    std::string make_verdict_key(const pa::paper::proto::Request& cmd,
+                                 const std::set<pa::paper::proto::Request_Type>& commands,
+                                 std::chrono::seconds& ttl) const;
+
     std::shared_ptr<smpp_gateway> smpp_gateway_;
 
     boost::asio::io_context* io_context_;
@@ -75,8 +148,35 @@ private:
     prometheus::Counter& destination_ton_npi_check_;
     prometheus::Counter& dcs_check_;
     prometheus::Counter& submits_rejected_;
+    prometheus::Counter& verdict_cache_hits_;
+    prometheus::Counter& local_black_white_check_;
+    prometheus::Counter& hedged_requests_;
 
     std::shared_ptr<pa::pinex::p_client_list> client_list_;
 
-    std::unordered_map<std::string, std::shared_ptr<submit_info> > user_data_;
+    io::correlation_table<pending_check> user_data_;
+    io::correlation_table<std::vector<pending_check>> batches_; /**< checks of a batch, in the order of its requests */
+
+    std::map<pa::paper::proto::Request_Type, std::chrono::seconds> verdict_ttls_; /**< commands whose verdict may be cached */
+    verdict_cache verdict_cache_;
+
+    std::unique_ptr<black_white_list> black_white_list_; /**< nullptr if BLACK_WHITE_CHECK is left to paper */
+
+    // batching is off while batch_max_requests_ is 0
+    size_t batch_max_requests_ = 0;
+    std::chrono::microseconds batch_window_{0};
+    pa::paper::proto::Request batch_envelope_;
+    std::vector<pending_check> batch_checks_;
+    boost::asio::steady_timer batch_timer_;
+
+    // nodes in bind state, every one behind its own circuit breaker
+    circuit_breaker::settings breaker_settings_;
+    std::vector<paper_node> nodes_;
+    size_t next_node_ = 0;
+
+    // hedging is off without hedge_latency_
+    std::optional<latency_window> hedge_latency_;
+    std::chrono::microseconds hedge_min_delay_{0};
+    std::deque<hedge_candidate> hedge_queue_; /**< in send order */
+    boost::asio::steady_timer hedge_timer_;
 };
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "paper/command.pb.h"
+
+#include <chrono>
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * @brief Bounded cache of paper verdicts keyed by the policy inputs of a request.
+ *
+ * Every entry expires at the time it was inserted with; when the cache is full the least recently used entry
+ * is dropped. Not thread safe, it is used from the io_context which owns paper_client.
+ */
+class verdict_cache
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit verdict_cache(size_t capacity)
+        : capacity_{capacity}
+    {
+    }
+
+    std::optional<pa::paper::proto::Status> find(const std::string& key, clock::time_point now)
+    {
+        auto itr = index_.find(key);
+        if(itr == index_.end())
+        {
+            return std::nullopt;
+        }
+
+        if(itr->second->expires <= now)
+        {
+            lru_.erase(itr->second);
+            index_.erase(itr);
+            return std::nullopt;
+        }
+
+        lru_.splice(lru_.begin(), lru_, itr->second);
+        return itr->second->status;
+    }
+
+    void insert(std::string key, pa::paper::proto::Status status, clock::time_point expires)
+    {
+        if(capacity_ == 0)
+        {
+            return;
+        }
+
+        if(auto itr = index_.find(key); itr != index_.end())
+        {
+            itr->second->status = status;
+            itr->second->expires = expires;
+            lru_.splice(lru_.begin(), lru_, itr->second);
+            return;
+        }
+
+        if(lru_.size() >= capacity_)
+        {
+            index_.erase(lru_.back().key);
+            lru_.pop_back();
+        }
+
+        lru_.push_front(entry{ std::move(key), status, expires });
+        index_.emplace(lru_.front().key, lru_.begin());
+    }
+
+    size_t size() const
+    {
+        return lru_.size();
+    }
+
+private:
+    struct entry
+    {
+        std::string key;
+        pa::paper::proto::Status status;
+        clock::time_point expires;
+    };
+
+    size_t capacity_;
+    std::list<entry> lru_; // most recently used first
+    std::unordered_map<std::string_view, std::list<entry>::iterator> index_; // keys point into lru_
+};
@@ -3,16 +3,64 @@
 #include "src/smpp/deliver_sm.h"
 #include "src/smpp/delivery_report.h"
 #include "src/smpp_gateway.h"
+#include "src/libs/protobuf_arena.hpp"
 
 #include <unistd.h>
 
+namespace
+{
+constexpr io::counter_family_spec counter_families[] = {
+    { "pinex_submit", "pinex submit parameters" },
+    { "pinex_submit_resp", "pinex submit resp parameters" },
+    { "pinex_deliver", "pinex deliver parameters" },
+    { "pinex_deliver_resp", "pinex deliver resp parameters" },
+    { "pinex_delivery_report", "pinex delivery report parameters" },
+    { "pinex_delivery_report_resp", "pinex delivery report resp parameters" },
+};
+
+enum family : size_t
+{
+    submit_family,
+    submit_resp_family,
+    deliver_family,
+    deliver_resp_family,
+    delivery_report_family,
+    delivery_report_resp_family,
+};
+
+// same order as pinex::counter
+constexpr io::counter_spec counter_specs[] = {
+    { submit_family, "sending_succeed" },
+    { submit_family, "sending_failed" },
+    { submit_family, "routing_failed" },
+    { submit_resp_family, "received" },
+    { submit_resp_family, "success_status" },
+    { submit_resp_family, "fail_status" },
+    { submit_resp_family, "timeout_status" },
+    { deliver_family, "received" },
+    { deliver_resp_family, "sending_succeed" },
+    { deliver_resp_family, "sending_failed" },
+    { delivery_report_family, "received" },
+    { delivery_report_resp_family, "sending_succeed" },
+    { delivery_report_resp_family, "sending_failed" },
+    { delivery_report_resp_family, "delivered_status" },
+    { delivery_report_resp_family, "expired_status" },
+    { delivery_report_resp_family, "deleted_status" },
+    { delivery_report_resp_family, "undeliverable_status" },
+    { delivery_report_resp_family, "accepted_status" },
+    { delivery_report_resp_family, "unknown_status" },
+    { delivery_report_resp_family, "rejected_status" },
+};
+} // namespace
+
 pinex::pinex(
     std::shared_ptr<smpp_gateway>            smpp_gateway,
     boost::asio::io_context*                 io_context,
     pa::config::manager*                     config_manager,
     const std::shared_ptr<pa::config::node>& config,
     const std::shared_ptr<pa::config::node>& prometheus_config,
-    std::shared_ptr<prometheus::Registry> registry)
+    std::shared_ptr<prometheus::Registry> registry,
+    std::shared_ptr<io::dense_collector> counter_collector)
     : io_context_ { io_context }
     , smpp_gateway_ { smpp_gateway }
     , config_manager_ { config_manager }
@@ -34,12 +82,6 @@ pinex::pinex(
     , client_name_ { config_->at("name")->get<std::string>() }
     , timeout_ { config_->at("timeout")->get<std::uint32_t>() }
     , pinex_connection_family_gauge_{prometheus::BuildGauge().Name("pinex_connection").Help("pinex parameters").Register(*registry)}
-    , submit_family_counter_{prometheus::BuildCounter().Name("pinex_submit").Help("pinex submit parameters").Register(*registry)}
-    , submit_resp_family_counter_{prometheus::BuildCounter().Name("pinex_submit_resp").Help("pinex submit resp parameters").Register(*registry)}
-    , deliver_family_counter_{prometheus::BuildCounter().Name("pinex_deliver").Help("pinex deliver parameters").Register(*registry)}
-    , deliver_resp_family_counter_{prometheus::BuildCounter().Name("pinex_deliver_resp").Help("pinex deliver resp parameters").Register(*registry)}
-    , delivery_report_family_counter_{prometheus::BuildCounter().Name("pinex_delivery_report").Help("pinex delivery report parameters").Register(*registry)}
-    , delivery_report_resp_family_counter_{prometheus::BuildCounter().Name("pinex_delivery_report_resp").Help("pinex delivery report resp parameters").Register(*registry)}
     , container_family_gauge_(prometheus::BuildGauge().Name("pinex_container_size").Help("pinex~ container size").Register(*registry))
     , connected_clients_(add_gauge(pinex_connection_family_gauge_, prometheus_config_->at("labels"), {
     { "name", "connected_clients" }, { "category", "network" }, { "system_id", config->at("name")->get<std::string>() }
@@ -47,68 +89,13 @@ pinex::pinex(
     , wait_for_resp_(add_gauge(container_family_gauge_, prometheus_config->at("labels"), {
     { "name", "wait_for_resp" }, { "interface", "pinex" }
 }))
-    , submit_req_sending_succeed_(add_counter(submit_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_succeed" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , submit_req_sending_failed_(add_counter(submit_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_failed" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , submit_req_routing_failed_(add_counter(submit_family_counter_, prometheus_config->at("labels"), {
-    { "name", "routing_failed" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , submit_resp_received_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "received" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , submit_resp_status_success_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "success_status" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , submit_resp_status_fail_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "fail_status" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , submit_resp_timeout_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "timeout_status" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , deliver_req_received_(add_counter(deliver_family_counter_, prometheus_config->at("labels"), {
-    { "name", "received" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , deliver_resp_sending_succeed_(add_counter(deliver_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_succeed" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , deliver_resp_sending_failed_(add_counter(deliver_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_failed" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , dr_req_received_(add_counter(delivery_report_family_counter_, prometheus_config->at("labels"), {
-    { "name", "received" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , dr_resp_sending_succeed_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_succeed" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , dr_resp_sending_failed_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_failed" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , dr_status_delivered_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "delivered_status" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , dr_status_expired_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "expired_status" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , dr_status_deleted_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "deleted_status" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , dr_status_undeliverable_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "undeliverable_status" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , dr_status_accepted_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "accepted_status" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , dr_status_unknown_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "unknown_status" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-    , dr_status_rejected_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "rejected_status" }, { "system_id", config->at("name")->get<std::string>() }
-}))
-
+    , counter_collector_{ counter_collector }
+    , counters_{ std::make_shared<io::dense_counters>(counter_families, counter_specs, make_labels(prometheus_config->at("labels"), { { "system_id", client_name_ } })) }
 {
+    static_assert(std::size(counter_specs) == static_cast<size_t>(counter::count));
+    counter_collector_->add(counters_);
+
+
     for(auto& n : config_->at("address")->nodes())
         trasnports_.push_back(n->get<std::string>());
 }
@@ -167,22 +154,28 @@ void pinex::session_state_changed(const std::string& name, session_stat state)
     } // switch
 } // pinex::session_state_changed
 
-void pinex::receive_request(const std::string& client_id, uint32_t seq_no, const std::string& msg_body)
+void pinex::receive_request(const std::string& client_id, uint32_t seq_no, std::string_view msg_body)
 {
     LOG_DEBUG("Received request with sequence: {} from client: {}", seq_no, client_id);
 
-    uint32_t msg_type = (*(uint32_t*) msg_body.substr(0, 4).c_str());
+    auto frame = pinex_frame::parse(msg_body);
+
+    if (!frame)
+    {
+        LOG_ERROR("Received request with sequence: {} from client: {} is too short", seq_no, client_id);
+        return;
+    }
 
-    switch (msg_type)
+    switch (frame->type)
     {
         case SMSC::Protobuf::AT_REQ_TYPE:
         {
             LOG_DEBUG("Received request msg_type is AT_REQ_TYPE");
 
-            auto proto_deliver_sm_req = std::make_shared<SMSC::Protobuf::SMPP::Deliver_Sm_Req>();
-            proto_deliver_sm_req->ParseFromString(msg_body.substr(4));
+            auto proto_deliver_sm_req = io::arena_pool::instance().make_message<SMSC::Protobuf::SMPP::Deliver_Sm_Req>();
+            proto_deliver_sm_req->ParseFromArray(frame->message.data(), static_cast<int>(frame->message.size()));
             log_ptr_protobuf_message(proto_deliver_sm_req);
-            deliver_req_received_.Increment();
+            counters_->increment(counter::deliver_req_received);
 
             LOG_HEX(spdlog::level::info, proto_deliver_sm_req->body().short_message());
 
@@ -194,10 +187,10 @@ void pinex::receive_request(const std::string& client_id, uint32_t seq_no, const
         {
             LOG_DEBUG("Received request msg_type is DR_REQ_TYPE");
 
-            auto proto_delivery_report_req = std::make_shared<SMSC::Protobuf::SMPP::DeliveryReport_Req>();
-            proto_delivery_report_req->ParseFromString(msg_body.substr(4));
+            auto proto_delivery_report_req = io::arena_pool::instance().make_message<SMSC::Protobuf::SMPP::DeliveryReport_Req>();
+            proto_delivery_report_req->ParseFromArray(frame->message.data(), static_cast<int>(frame->message.size()));
             log_ptr_protobuf_message(proto_delivery_report_req);
-            dr_req_received_.Increment();
+            counters_->increment(counter::dr_req_received);
             delivery_report::process_req(static_cast<uint64_t>(seq_no), proto_delivery_report_req, client_id, smpp_gateway_);
             std::string dr_status;
             delivery_report::extract_dr_status(proto_delivery_report_req->mutable_body()->short_message(), dr_status);
@@ -219,31 +212,31 @@ void pinex::update_delivery_report_status(std::string status)
 
     if (status.compare("DELIVRD") == 0)
     {
-        dr_status_delivered_.Increment();
+        counters_->increment(counter::dr_status_delivered);
     }
     else if (status.compare("EXPIRED") == 0)
     {
-        dr_status_expired_.Increment();
+        counters_->increment(counter::dr_status_expired);
     }
     else if (status.compare("DELETED") == 0)
     {
-        dr_status_deleted_.Increment();
+        counters_->increment(counter::dr_status_deleted);
     }
     else if (status.compare("UNDELIV") == 0)
     {
-        dr_status_undeliverable_.Increment();
+        counters_->increment(counter::dr_status_undeliverable);
     }
     else if (status.compare("ACCEPTD") == 0)
     {
-        dr_status_accepted_.Increment();
+        counters_->increment(counter::dr_status_accepted);
     }
     else if (status.compare("UNKNOWN") == 0)
     {
-        dr_status_unknown_.Increment();
+        counters_->increment(counter::dr_status_unknown);
     }
     else if (status.compare("REJECTD") == 0)
     {
-        dr_status_rejected_.Increment();
+        counters_->increment(counter::dr_status_rejected);
     }
     else
     {
@@ -253,39 +246,45 @@ void pinex::update_delivery_report_status(std::string status)
 // mohsen
 
 void pinex::receive_response(
-  const std::string& client_id, uint32_t seq_no, const std::string& msg_body
+  const std::string& client_id, uint32_t seq_no, std::string_view msg_body
 )
 {
     LOG_DEBUG("Receive response with sequence: {} from client: {}", seq_no, client_id);
 
-    const auto& it = user_data_.find(fmt::format("{}@{}", seq_no, client_id));
+    auto user_data = user_data_.take(client_id, seq_no);
 
-    if (it == user_data_.end())
+    if (!user_data)
     {
         LOG_ERROR("Could not find user_data for sequence {}", seq_no);
         return;
     }
 
-    auto orig_submit_info = it->second;
-    user_data_.erase(it);
+    auto orig_submit_info = std::move(user_data->info);
     wait_for_resp_.Decrement();
+    router_->on_request_done(client_id, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - user_data->sent_time));
 
-    uint32_t msg_type = (*(uint32_t*) msg_body.substr(0, 4).c_str());
+    auto frame = pinex_frame::parse(msg_body);
 
-    switch (msg_type)
+    if (!frame)
+    {
+        LOG_ERROR("Received response with sequence: {} from client: {} is too short", seq_no, client_id);
+        return;
+    }
+
+    switch (frame->type)
     {
         case SMSC::Protobuf::AO_RESP_TYPE:
         {
             LOG_DEBUG("Receive AO_RESP_TYPE");
 
             SMSC::Protobuf::SMPP::Submit_Sm_Resp resp;
-            resp.ParseFromString(msg_body.substr(4));
+            resp.ParseFromArray(frame->message.data(), static_cast<int>(frame->message.size()));
             log_protobuf_message(resp);
-            submit_resp_received_.Increment();
+            counters_->increment(counter::submit_resp_received);
             if (resp.error_code())
-                submit_resp_status_fail_.Increment();
+                counters_->increment(counter::submit_resp_status_fail);
             else
-                submit_resp_status_success_.Increment();
+                counters_->increment(counter::submit_resp_status_success);
 
             submit_sm::
               process_resp(client_id, orig_submit_info, std::move(resp));
@@ -294,45 +293,41 @@ void pinex::receive_response(
 
         default:
         {
-            LOG_DEBUG("default {}", msg_type);
+            LOG_DEBUG("default {}", frame->type);
             break;
         }
     } // switch
 } // pinex::receive_response
 
-void pinex::timeout_request(const std::string& client_id, uint32_t seq_no, const std::string& msg_body)
+void pinex::timeout_request(const std::string& client_id, uint32_t seq_no, std::string_view)
 {
     LOG_DEBUG("Timeout request with sequence: {} from client: {}", seq_no, client_id);
 
-    const auto& it = user_data_.find(fmt::format("{}@{}", seq_no, client_id));
+    auto user_data = user_data_.take(client_id, seq_no);
 
-    if (it == user_data_.end())
+    if (!user_data)
     {
         LOG_ERROR("Could not find user_data for sequence {}", seq_no);
         return;
     }
 
-    auto orig_submit_info = it->second;
-    user_data_.erase(it);
+    auto orig_submit_info = std::move(user_data->info);
     wait_for_resp_.Decrement();
+    router_->on_request_done(client_id, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - user_data->sent_time));
 
-    uint32_t msg_type = (*(uint32_t*) msg_body.substr(0, 4).c_str());
-
-    switch (msg_type)
+    // the request was written straight into the send buffer and its body is not kept
+    switch (user_data->msg_type)
     {
         case SMSC::Protobuf::AO_REQ_TYPE:
         {
-            SMSC::Protobuf::SMPP::Submit_Sm_Req req;
-            req.ParseFromString(msg_body.substr(4));
-
             SMSC::Protobuf::SMPP::Submit_Sm_Resp resp;
             resp.set_error_code(
               static_cast<uint32_t>(pa::smpp::command_status::rtimeout)
             );
-            resp.set_smsc_unique_id(req.smsc_unique_id());
+            resp.set_smsc_unique_id(orig_submit_info->smsc_unique_id_);
 
             log_protobuf_message(resp);
-            submit_resp_timeout_.Increment();
+            counters_->increment(counter::submit_resp_timeout);
             submit_sm::
               process_resp(client_id, orig_submit_info, std::move(resp));
 
@@ -341,7 +336,7 @@ void pinex::timeout_request(const std::string& client_id, uint32_t seq_no, const
 
         default:
         {
-            LOG_DEBUG("The request message type({}) is default", msg_type);
+            LOG_DEBUG("The request message type({}) is default", user_data->msg_type);
             break;
         }
     } // switch
@@ -1,15 +1,21 @@
 #pragma once
 
+#include "src/pinex/pinex_frame.h"
 #include "src/routing/pinex/router.h"
 #include "src/smpp/submit_sm.h"
 #include "src/sgw_definitions.h"
+#include "src/libs/correlation_table.hpp"
+#include "src/libs/dense_counters.hpp"
 #include "src/libs/monitoring.hpp"
+#include "src/libs/protobuf_arena.hpp"
 
 #include <pinex/net/definitions.hpp>
 #include <pinex/p_client_list.hpp>
 
 #include <prometheus/registry.h>
 
+#include <chrono>
+#include <string_view>
 #include <typeinfo>
 #include <unordered_map>
 
@@ -17,7 +23,10 @@ class smpp_gateway;
 
 class pinex : public std::enable_shared_from_this<pinex>
 {
-    bool encode_to_protobuf(std::shared_ptr<deliver_info> deliver_info, std::string& encoded)
+    /**
+     * @brief Writes the response of a deliver_sm or delivery report straight into the pinex send buffer.
+     */
+    void send_deliver_resp(int msg_type, const std::shared_ptr<deliver_info>& deliver_info)
     {
         if(deliver_info->is_report_)
         {
@@ -25,18 +34,21 @@ class pinex : public std::enable_shared_from_this<pinex>
             deliver_report_resp.set_error_code((uint32_t)deliver_info->error_);
             deliver_report_resp.set_smsc_unique_id(deliver_info->smsc_unique_id_);
             //deliver_report_resp.set_system_id(systemId);
-            deliver_report_resp.SerializeToString(&encoded);
             log_protobuf_message(deliver_report_resp);
-            return true;
+
+            pinex_frame_writer frame(msg_type, deliver_report_resp);
+            client_list_->send_response(frame.size(), frame, deliver_info->originating_sequence_number_, deliver_info->source_connection_);
+            return;
         }
 
         SMSC::Protobuf::SMPP::Deliver_Sm_Resp deliver_sm_resp;
         deliver_sm_resp.set_error_code((uint32_t)deliver_info->error_);
         deliver_sm_resp.set_smsc_unique_id(deliver_info->smsc_unique_id_);
         //deliver_sm_resp.set_system_id(systemId);
-        deliver_sm_resp.SerializeToString(&encoded);
         log_protobuf_message(deliver_sm_resp);
-        return true;
+
+        pinex_frame_writer frame(msg_type, deliver_sm_resp);
+        client_list_->send_response(frame.size(), frame, deliver_info->originating_sequence_number_, deliver_info->source_connection_);
     }
 
 public:
@@ -46,7 +58,8 @@ public:
         pa::config::manager*                     config_manager,
         const std::shared_ptr<pa::config::node>& config,
         const std::shared_ptr<pa::config::node>& prometheus_config,
-        std::shared_ptr<prometheus::Registry> registry);
+        std::shared_ptr<prometheus::Registry> registry,
+        std::shared_ptr<io::dense_collector> counter_collector);
 
     virtual ~pinex();
 
@@ -56,17 +69,14 @@ public:
     template<typename info_type>
     bool send(int msg_type, info_type user_data)
     {
-        std::string send_msg(4, '\0');
-        *((int*)send_msg.c_str()) = msg_type;
-
         using datatype = std::decay_t<decltype(*user_data)>;
 
         if constexpr(std::is_same_v<datatype, submit_info>)
         {
-            std::string encoded_pdu;
-            submit_sm::encode_to_protobuf(user_data, encoded_pdu);
-            send_msg += encoded_pdu;
-            LOG_HEX(spdlog::level::debug, send_msg);
+            // nested messages and strings go to the thread's scratch block instead of the heap
+            io::scratch_arena arena;
+            auto& submit = *arena.make_message<SMSC::Protobuf::SMPP::Submit_Sm_Req>();
+            submit_sm::encode_to_protobuf(user_data, submit);
 
             // switch(msg_type)
             // {
@@ -89,16 +99,18 @@ public:
 
                 try
                 {
-                    auto seq_no = client_list_->send_request(send_msg, destinations[0]);
+                    pinex_frame_writer frame(msg_type, submit);
+                    auto seq_no = client_list_->send_request(frame.size(), frame, destinations[0]);
 
                     if(seq_no)
                     {
-                        user_data_.insert({ fmt::format("{}@{}", seq_no, destinations[0]), user_data });
+                        user_data_.insert(destinations[0], seq_no, pending_submit{ user_data, std::chrono::steady_clock::now(), msg_type });
+                        router_->on_request_sent(destinations[0]);
                         wait_for_resp_.Increment();
                         switch(msg_type)
                         {
                             case SMSC::Protobuf::AO_REQ_TYPE:
-                                submit_req_sending_succeed_.Increment();
+                                counters_->increment(counter::submit_req_sending_succeed);
                                 break;
                             case SMSC::Protobuf::AT_REQ_TYPE:
                             case SMSC::Protobuf::DR_REQ_TYPE:
@@ -123,7 +135,7 @@ public:
                 switch(msg_type)
                 {
                     case SMSC::Protobuf::AO_REQ_TYPE:
-                        submit_req_sending_failed_.Increment();
+                        counters_->increment(counter::submit_req_sending_failed);
                         break;
                     case SMSC::Protobuf::AT_REQ_TYPE:
                     case SMSC::Protobuf::DR_REQ_TYPE:
@@ -139,7 +151,7 @@ public:
             switch(msg_type)
             {
                 case SMSC::Protobuf::AO_REQ_TYPE:
-                    submit_req_routing_failed_.Increment();
+                    counters_->increment(counter::submit_req_routing_failed);
                     break;
                 case SMSC::Protobuf::AT_REQ_TYPE:
                 case SMSC::Protobuf::DR_REQ_TYPE:
@@ -157,19 +169,14 @@ public:
             // else if(msg_type == SMSC::Protobuf::AT_RESP_TYPE)
             //     deliver_resp_sent_.Increment();
 
-            std::string encoded_pdu;
-            encode_to_protobuf(user_data, encoded_pdu);
-            send_msg += encoded_pdu;
-            LOG_HEX(spdlog::level::debug, send_msg);
-
             try
             {
-                client_list_->send_response(send_msg, user_data->originating_sequence_number_, user_data->source_connection_);
+                send_deliver_resp(msg_type, user_data);
 
                 if(msg_type ==  SMSC::Protobuf::DR_RESP_TYPE)
-                    dr_resp_sending_succeed_.Increment();
+                    counters_->increment(counter::dr_resp_sending_succeed);
                 else if(msg_type == SMSC::Protobuf::AT_RESP_TYPE)
-                    deliver_resp_sending_succeed_.Increment();
+                    counters_->increment(counter::deliver_resp_sending_succeed);
 
                 return true;
             }
@@ -184,9 +191,9 @@ public:
             }
 
             if(msg_type ==  SMSC::Protobuf::DR_RESP_TYPE)
-                dr_resp_sending_failed_.Increment();
+                counters_->increment(counter::dr_resp_sending_failed);
             else if(msg_type == SMSC::Protobuf::AT_RESP_TYPE)
-                deliver_resp_sending_failed_.Increment();
+                counters_->increment(counter::deliver_resp_sending_failed);
 
             return false;
         }
@@ -200,9 +207,9 @@ public:
     }
 
 private:
-    void receive_request(const std::string& client_id, uint32_t seq_no, const std::string& msg_body);
-    void receive_response(const std::string& client_id, uint32_t seq_no, const std::string& msg_body);
-    void timeout_request(const std::string& client_id, uint32_t seq_no, const std::string& msg_body);
+    void receive_request(const std::string& client_id, uint32_t seq_no, std::string_view msg_body);
+    void receive_response(const std::string& client_id, uint32_t seq_no, std::string_view msg_body);
+    void timeout_request(const std::string& client_id, uint32_t seq_no, std::string_view msg_body);
     void session_state_changed(const std::string& name, session_stat state);
 
     void update_delivery_report_status(std::string status);
@@ -227,38 +234,60 @@ private:
 
     std::shared_ptr<pa::pinex::p_client_list> client_list_;
 
-    std::unordered_map<std::string, std::shared_ptr<submit_info> > user_data_;
+    struct pending_submit
+    {
+        std::shared_ptr<submit_info> info;
+        std::chrono::steady_clock::time_point sent_time; /**< feeds the latency of the target to router_ */
+        int msg_type; /**< the request body is not kept, a timeout is answered from this and info */
+    };
+
+    io::correlation_table<pending_submit> user_data_;
 
     prometheus::Family<prometheus::Gauge>& pinex_connection_family_gauge_;
-    prometheus::Family<prometheus::Counter>& submit_family_counter_;
-    prometheus::Family<prometheus::Counter>& submit_resp_family_counter_;
-    prometheus::Family<prometheus::Counter>& deliver_family_counter_;
-    prometheus::Family<prometheus::Counter>& deliver_resp_family_counter_;
-    prometheus::Family<prometheus::Counter>& delivery_report_family_counter_;
-    prometheus::Family<prometheus::Counter>& delivery_report_resp_family_counter_;
     prometheus::Family<prometheus::Gauge>& container_family_gauge_;
 
     prometheus::Gauge& connected_clients_;
     prometheus::Gauge& wait_for_resp_;
 
-    prometheus::Counter& submit_req_sending_succeed_;
-    prometheus::Counter& submit_req_sending_failed_;
-    prometheus::Counter& submit_req_routing_failed_;
-    prometheus::Counter& submit_resp_received_;
-    prometheus::Counter& submit_resp_status_success_;
-    prometheus::Counter& submit_resp_status_fail_;
-    prometheus::Counter& submit_resp_timeout_;
-    prometheus::Counter& deliver_req_received_;
-    prometheus::Counter& deliver_resp_sending_succeed_;
-    prometheus::Counter& deliver_resp_sending_failed_;
-    prometheus::Counter& dr_req_received_;
-    prometheus::Counter& dr_resp_sending_succeed_;
-    prometheus::Counter& dr_resp_sending_failed_;
-    prometheus::Counter& dr_status_delivered_;
-    prometheus::Counter& dr_status_expired_;
-    prometheus::Counter& dr_status_deleted_;
-    prometheus::Counter& dr_status_undeliverable_;
-    prometheus::Counter& dr_status_accepted_;
-    prometheus::Counter& dr_status_unknown_;
-    prometheus::Counter& dr_status_rejected_;
+    /** @brief index into counters_, in the order of counter_specs in pinex.cpp */
+    enum class counter : size_t
+    {
+        // submit
+        submit_req_sending_succeed,
+        submit_req_sending_failed,
+        submit_req_routing_failed,
+
+        // submit response
+        submit_resp_received,
+        submit_resp_status_success,
+        submit_resp_status_fail,
+        submit_resp_timeout,
+
+        // deliver
+        deliver_req_received,
+
+        // deliver response
+        deliver_resp_sending_succeed,
+        deliver_resp_sending_failed,
+
+        // delivery report
+        dr_req_received,
+
+        // delivery report response
+        dr_resp_sending_succeed,
+        dr_resp_sending_failed,
+        dr_status_delivered,
+        dr_status_expired,
+        dr_status_deleted,
+        dr_status_undeliverable,
+        dr_status_accepted,
+        dr_status_unknown,
+        dr_status_rejected,
+
+        count
+    };
+
+    std::shared_ptr<io::dense_collector> counter_collector_;
+    std::shared_ptr<io::dense_counters> counters_;
+
 };
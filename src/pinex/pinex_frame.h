@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+
+/**
+ * @brief Body of a pinex stream pdu, the message type in host byte order followed by a protobuf message.
+ */
+struct pinex_frame
+{
+    static constexpr size_t type_length{4};
+
+    uint32_t type;
+    std::string_view message; /**< view into the received body, it does not outlive the receive handler */
+
+    /**
+     * @return nullopt if the body is too short to hold the message type
+     */
+    static std::optional<pinex_frame> parse(std::string_view body)
+    {
+        if(body.size() < type_length)
+        {
+            return std::nullopt;
+        }
+
+        uint32_t type;
+        std::memcpy(&type, body.data(), type_length);
+
+        return pinex_frame{type, body.substr(type_length)};
+    }
+};
+
+/**
+ * @brief Writes a frame straight into the send buffer of a pinex session, see p_client_list::send_request.
+ *
+ * The message size is computed once here and cached in the message, so it must not change before the frame
+ * is written.
+ */
+template<typename Message>
+class pinex_frame_writer
+{
+public:
+    pinex_frame_writer(int32_t type, const Message& message)
+        : type_{type}
+        , message_{message}
+        , message_length_{message.ByteSizeLong()}
+    {
+    }
+
+    size_t size() const
+    {
+        return pinex_frame::type_length + message_length_;
+    }
+
+    void operator()(std::span<uint8_t> out) const
+    {
+        std::memcpy(out.data(), &type_, pinex_frame::type_length);
+        message_.SerializeWithCachedSizesToArray(out.data() + pinex_frame::type_length);
+    }
+
+private:
+    int32_t type_;
+    const Message& message_;
+    size_t message_length_;
+};
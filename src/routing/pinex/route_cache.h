@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Bounded cache of prefix route lookups keyed by (msg_type, destination).
+ *
+ * The table is allocated once and is 4-way set associative, the least recently used way of a set is replaced.
+ * Keys are stored inline, so destinations longer than max_key_length are never cached. Entries are tagged
+ * with the routing generation they were resolved in; bumping the generation invalidates all of them at once.
+ * A cached target points into the route table of that generation. Not thread safe, it is used from the io_context
+ * which owns the router.
+ */
+class route_cache
+{
+public:
+    static constexpr size_t max_key_length = 23;
+
+    explicit route_cache(size_t capacity = 4096)
+        : sets_(std::max<size_t>(std::bit_ceil(capacity) / ways, 1))
+    {
+    }
+
+    /**
+     * @return true on a hit, `target` is then the cached result (nullptr if no route matched)
+     */
+    bool find(uint64_t generation, int msg_type, std::string_view destination, const std::string*& target)
+    {
+        if(destination.size() > max_key_length)
+        {
+            return false;
+        }
+
+        const auto h = hash(msg_type, destination);
+
+        for(auto& e : sets_[h & (sets_.size() - 1)])
+        {
+            if(e.generation == generation && e.hash == h && matches(e, msg_type, destination))
+            {
+                e.last_used = ++tick_;
+                target = e.target;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void insert(uint64_t generation, int msg_type, std::string_view destination, const std::string* target)
+    {
+        if(destination.size() > max_key_length)
+        {
+            return;
+        }
+
+        const auto h = hash(msg_type, destination);
+        auto& set = sets_[h & (sets_.size() - 1)];
+
+        entry* victim = &set[0];
+        for(auto& e : set)
+        {
+            if(e.generation != generation)
+            {
+                victim = &e;
+                break;
+            }
+
+            if(e.last_used < victim->last_used)
+            {
+                victim = &e;
+            }
+        }
+
+        victim->generation = generation;
+        victim->hash = h;
+        victim->msg_type = msg_type;
+        victim->length = static_cast<uint8_t>(destination.size());
+        std::memcpy(victim->key, destination.data(), destination.size());
+        victim->target = target;
+        victim->last_used = ++tick_;
+    }
+
+private:
+    static constexpr size_t ways = 4;
+
+    struct entry
+    {
+        uint64_t generation = 0; // generations start at 1, 0 marks an empty way
+        uint64_t hash = 0;
+        uint64_t last_used = 0;
+        const std::string* target = nullptr;
+        int msg_type = 0;
+        uint8_t length = 0;
+        char key[max_key_length];
+    };
+
+    static uint64_t hash(int msg_type, std::string_view destination)
+    {
+        uint64_t h = 14695981039346656037ull ^ static_cast<uint32_t>(msg_type);
+        for(auto c : destination)
+        {
+            h ^= static_cast<uint8_t>(c);
+            h *= 1099511628211ull;
+        }
+
+        return h;
+    }
+
+    static bool matches(const entry& e, int msg_type, std::string_view destination)
+    {
+        return e.msg_type == msg_type && e.length == destination.size() && std::memcmp(e.key, destination.data(), destination.size()) == 0;
+    }
+
+    std::vector<std::array<entry, ways> > sets_;
+    uint64_t tick_ = 0;
+};
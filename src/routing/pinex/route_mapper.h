@@ -1,8 +1,9 @@
 #ifndef _ROUTEMAPPER_H_
 #define _ROUTEMAPPER_H_
-#include <pthread.h>
+#include <cstdint>
 #include <cstdio>
 #include <string>
+#include <string_view>
 #include <limits.h>
 #include <vector>
 
@@ -25,31 +26,21 @@ namespace peykasa
             }
         };
 
-        template<class T>
-        class char_node
-        {
-        public:
-            char_node(int depth, char_node<T>* parent, unsigned int index);
-            virtual ~char_node();
-
-            void clean_node();
-
-            T destination_;
-            unsigned int index_;
-            unsigned int max_length_;
-            bool has_value_flag_;
-            unsigned int depth_;
-            unsigned int number_of_childs_;
-            char_node<T>* childs_[256];
-            char_node<T>* parent_;
-        };
-
+        /**
+         * @brief longest prefix match over a path compressed radix trie.
+         *
+         * Nodes live in one vector and refer to each other by index; every edge label is a slice of a
+         * shared label buffer. Children of a node are chained in ascending order of their first
+         * character, which for MSISDN prefixes is a scan over at most ten 20-byte nodes per level.
+         * Lookups are iterative and return a pointer into the table, so they never allocate.
+         * The mapper is not thread safe, it is only used from the io_context which owns the router.
+         */
         template<class T>
         class route_mapper
         {
         public:
             route_mapper();
-            virtual ~route_mapper();
+            virtual ~route_mapper() = default;
 
             bool add_route(std::vector<route_data<T> >& routes, bool clear = false);
 
@@ -58,314 +49,417 @@ namespace peykasa
             bool delete_route(const std::string& prefix);
             void clear_all_routes();
 
-            T find_destination(const std::string& prefix, bool reverse = false);
+            /**
+             * @brief find, destination of the longest route matching prefix
+             * @param prefix
+             * @param reverse match prefix from its last character backwards
+             * @return nullptr if no route matches or the matched route's max length is exceeded
+             */
+            const T* find(std::string_view prefix, bool reverse = false) const;
+            T find_destination(const std::string& prefix, bool reverse = false) const;
 
         private:
-            pthread_rwlock_t mutex_;
+            static constexpr uint32_t npos = UINT32_MAX;
 
-            char_node<T>* tree_root_;
-
-            void clean_up(char_node<T>* current);
-
-            char_node<T>* create_sub_tree(const std::string& prefix,
-                                          unsigned int       first,
-                                          unsigned int       last,
-                                          char_node<T>*      current);
+            struct node
+            {
+                uint32_t label_offset_ = 0;
+                uint32_t label_length_ = 0;
+                uint32_t first_child_ = npos;
+                uint32_t next_sibling_ = npos;
+                uint32_t value_ = npos;
+            };
+
+            struct route_value
+            {
+                T destination_;
+                unsigned int max_length_;
+            };
 
-            char_node<T>* find_matching(const std::string& prefix,
-                                        unsigned int       first,
-                                        unsigned int       last,
-                                        char_node<T>*      current,
-                                        char_node<T>*      lastValidValue,
-                                        bool               reverse);
-        };
+            class key
+            {
+            public:
+                key(std::string_view prefix, bool reverse)
+                    : prefix_(prefix)
+                    , reverse_(reverse)
+                {
+                }
 
+                unsigned char operator[](size_t i) const
+                {
+                    return reverse_ ? prefix_[prefix_.length() - 1 - i] : prefix_[i];
+                }
 
-        /** Implementation **/
+                size_t length() const
+                {
+                    return prefix_.length();
+                }
 
-        template<class T> char_node<T>::char_node(int depth, char_node<T>* parent, unsigned int index)
-        {
-            has_value_flag_ = false;
-            parent_ = parent;
-            depth_ = depth;
-            index_ = index;
-            number_of_childs_ = 0;
+            private:
+                std::string_view prefix_;
+                bool reverse_;
+            };
 
-            for(int i = 0; i < 256; i++)
+            unsigned char label_at(const node& n, size_t i) const
             {
-                childs_[i] = NULL;
+                return labels_[n.label_offset_ + i];
             }
-        }
 
-        template<class T> char_node<T>::~char_node()
-        {
-        }
+            uint32_t find_child(uint32_t parent, unsigned char ch) const;
+            uint32_t find_exact(const std::string& prefix) const;
+            uint32_t create_sub_tree(const std::string& prefix);
+            uint32_t new_node(uint32_t labelOffset, uint32_t labelLength);
+            void link_child(uint32_t parent, uint32_t child);
+            void set_value(uint32_t n, T destination, unsigned int maxLength);
+            void clean_up(const std::string& prefix);
+
+            std::vector<node> nodes_;
+            std::vector<route_value> values_;
+            std::string labels_;
+            uint32_t free_node_ = npos;
+            std::vector<uint32_t> free_values_;
+        };
 
-        template<class T>
-        void char_node<T>::clean_node()
-        {
-            for(int i = 0; i < 256; i++)
-            {
-                if(childs_[i] != NULL)
-                {
-                    childs_[i]->clean_node();
-                    delete childs_[i];
-                    childs_[i] = NULL;
-                }
-            }
 
-            number_of_childs_ = 0;
-        } //>::clean_node
+        /** Implementation **/
 
         template<class T> route_mapper<T>::route_mapper()
+            : nodes_(1)
         {
-            tree_root_ = new char_node<T>(0, NULL, -1);
-            pthread_rwlock_init(&mutex_, NULL);
-        }
-
-        template<class T> route_mapper<T>::~route_mapper()
-        {
-            delete tree_root_;
-            pthread_rwlock_destroy(&mutex_);
         }
 
         template<class T>
         bool route_mapper<T>::add_route(const std::string& prefix, T destination, unsigned int maxLength)
         {
-            bool res;
-            pthread_rwlock_wrlock(&mutex_);
-            char_node<T>* n = create_sub_tree(prefix, 0, prefix.length(), tree_root_);
+            uint32_t n = create_sub_tree(prefix);
 
-            if(n != NULL)
+            if(nodes_[n].value_ != npos)
             {
-                n->destination_ = destination;
-                n->max_length_ = maxLength;
-                n->has_value_flag_ = true;
-                res = true;
-            }
-            else
-            {
-                res = false;
+                return false;
             }
 
-            pthread_rwlock_unlock(&mutex_);
-            return res;
+            set_value(n, std::move(destination), maxLength);
+            return true;
         } //>::add_route
 
         template<class T>
         bool route_mapper<T>::add_route(std::vector<route_data<T> >& routes, bool clear)
         {
             bool res = true;
-            pthread_rwlock_wrlock(&mutex_);
 
             if(clear)
             {
-                tree_root_->clean_node();
+                clear_all_routes();
             }
 
-            for(int i = 0; i < routes.size(); i++)
+            for(auto& route : routes)
             {
-                char_node<T>* n = create_sub_tree(routes[i].prefix_, 0, routes[i].prefix_.length(), tree_root_);
-
-                if(n != NULL)
+                if(!add_route(route.prefix_, route.destination_, route.max_length_))
                 {
-                    n->destination_ = routes[i].destination_;
-                    n->max_length_ = routes[i].max_length_;
-                    n->has_value_flag_ = true;
-                }
-                else
-                {
-                    //LOG_ERROR("Add Route Failed! A Route For {} Already Exists!", routes[i].prefix_.c_str());
+                    //LOG_ERROR("Add Route Failed! A Route For {} Already Exists!", route.prefix_.c_str());
                     res = false;
                 }
             }
 
-            pthread_rwlock_unlock(&mutex_);
             return res;
         } //>::add_route
 
         template<class T>
         bool route_mapper<T>::update_route(const std::string& prefix, T destination, unsigned int maxLength)
         {
-            bool res;
-            pthread_rwlock_wrlock(&mutex_);
-            char_node<T>* n = find_matching(prefix, 0, prefix.length(), tree_root_, NULL, false);
+            uint32_t n = find_exact(prefix);
 
-            if((n != NULL) && (n->depth_ == prefix.length()))
-            {
-                n->destination_ = destination;
-                n->max_length_ = maxLength;
-                res = true;
-            }
-            else
+            if((n == npos) || (nodes_[n].value_ == npos))
             {
                 //LOG_ERROR("Update Route Failed! No Route For {} Exists!", (char*) prefix.c_str());
-                res = false;
+                return false;
             }
 
-            pthread_rwlock_unlock(&mutex_);
-            return res;
+            values_[nodes_[n].value_] = route_value{ std::move(destination), maxLength };
+            return true;
         } //>::update_route
 
         template<class T>
         bool route_mapper<T>::delete_route(const std::string& prefix)
         {
-            bool res;
-            pthread_rwlock_wrlock(&mutex_);
-            char_node<T>* n = find_matching(prefix, 0, prefix.length(), tree_root_, NULL, false);
+            uint32_t n = find_exact(prefix);
 
-            if((n != NULL) && (n->depth_ == prefix.length()))
-            {
-                n->has_value_flag_ = false;
-                clean_up(n);
-                res = true;
-            }
-            else
+            if((n == npos) || (nodes_[n].value_ == npos))
             {
                 //LOG_ERROR("Delete Route Failed! No Route For {} Exists!", (char*) prefix.c_str());
-                res = false;
+                return false;
             }
 
-            pthread_rwlock_unlock(&mutex_);
-            return res;
+            values_[nodes_[n].value_].destination_ = T();
+            free_values_.push_back(nodes_[n].value_);
+            nodes_[n].value_ = npos;
+
+            clean_up(prefix);
+            return true;
         } //>::delete_route
 
         template<class T>
         void route_mapper<T>::clear_all_routes()
         {
-            pthread_rwlock_wrlock(&mutex_);
-            tree_root_->clean_node();
-            pthread_rwlock_unlock(&mutex_);
+            nodes_.assign(1, node());
+            values_.clear();
+            labels_.clear();
+            free_node_ = npos;
+            free_values_.clear();
         }
 
         template<class T>
-        T route_mapper<T>::find_destination(const std::string& prefix, bool reverse)
+        const T* route_mapper<T>::find(std::string_view prefix, bool reverse) const
         {
-            T res;
-            pthread_rwlock_rdlock(&mutex_);
-            char_node<T>* n = find_matching(prefix, 0, prefix.length(), tree_root_, NULL, reverse);
+            const key k(prefix, reverse);
+            uint32_t best = nodes_[0].value_;
+            uint32_t n = 0;
+            size_t pos = 0;
 
-            if((n != NULL))
+            while(pos < k.length())
             {
-                if(n->max_length_ < prefix.length())
+                n = find_child(n, k[pos]);
+
+                if(n == npos)
                 {
-                    //LOG_DEBUG("No Route Found For {} According To Max Length Constraint!", prefix.c_str());
-                    res = "";
+                    break;
                 }
-                else
+
+                const node& child = nodes_[n];
+
+                if(child.label_length_ > k.length() - pos)
+                {
+                    break;
+                }
+
+                size_t i = 1;
+
+                while((i < child.label_length_) && (label_at(child, i) == k[pos + i]))
                 {
-                    res = n->destination_;
+                    i++;
+                }
+
+                if(i < child.label_length_)
+                {
+                    break;
+                }
+
+                pos += child.label_length_;
+
+                if(child.value_ != npos)
+                {
+                    best = child.value_;
                 }
             }
-            else
+
+            if(best == npos)
             {
-                //LOG_DEBUG("No Route For {} Found!", prefix.c_str());
-                res = "";
+                //LOG_DEBUG("No Route For {} Found!", prefix);
+                return nullptr;
             }
 
-            pthread_rwlock_unlock(&mutex_);
-            return res;
+            if(values_[best].max_length_ < prefix.length())
+            {
+                //LOG_DEBUG("No Route Found For {} According To Max Length Constraint!", prefix);
+                return nullptr;
+            }
+
+            return &values_[best].destination_;
+        } //>::find
+
+        template<class T>
+        T route_mapper<T>::find_destination(const std::string& prefix, bool reverse) const
+        {
+            const T* res = find(prefix, reverse);
+            return res ? *res : T();
         } //>::find_destination
 
         template<class T>
-        char_node<T>* route_mapper<T>::find_matching(const std::string& prefix,
-                                                     unsigned int       first,
-                                                     unsigned int       last,
-                                                     char_node<T>*      current,
-                                                     char_node<T>*      lastValidValue,
-                                                     bool               reverse)
+        uint32_t route_mapper<T>::find_child(uint32_t parent, unsigned char ch) const
         {
-            unsigned char index;
+            uint32_t child = nodes_[parent].first_child_;
 
-            if(current->has_value_flag_)
+            while((child != npos) && (label_at(nodes_[child], 0) < ch))
             {
-                lastValidValue = current;
+                child = nodes_[child].next_sibling_;
             }
 
-            //currently last point to end of string
-            if(reverse && last)
+            if((child != npos) && (label_at(nodes_[child], 0) == ch))
             {
-                last--;
+                return child;
+            }
+
+            return npos;
+        } //>::find_child
+
+        template<class T>
+        uint32_t route_mapper<T>::find_exact(const std::string& prefix) const
+        {
+            uint32_t n = 0;
+            size_t pos = 0;
+
+            while(pos < prefix.length())
+            {
+                n = find_child(n, prefix[pos]);
+
+                if((n == npos) || (nodes_[n].label_length_ > prefix.length() - pos) ||
+                   (labels_.compare(nodes_[n].label_offset_, nodes_[n].label_length_, prefix, pos, nodes_[n].label_length_) != 0))
+                {
+                    return npos;
+                }
+
+                pos += nodes_[n].label_length_;
             }
 
-            if(first < last)
+            return n;
+        } //>::find_exact
+
+        template<class T>
+        uint32_t route_mapper<T>::create_sub_tree(const std::string& prefix)
+        {
+            uint32_t n = 0;
+            size_t pos = 0;
+
+            while(pos < prefix.length())
             {
-                if(reverse)
+                uint32_t child = find_child(n, prefix[pos]);
+
+                if(child == npos)
                 {
-                    index = prefix[last];
+                    auto offset = static_cast<uint32_t>(labels_.size());
+                    labels_.append(prefix, pos, std::string::npos);
+
+                    child = new_node(offset, static_cast<uint32_t>(prefix.length() - pos));
+                    link_child(n, child);
+                    return child;
                 }
-                else
+
+                uint32_t common = 1;
+
+                while((common < nodes_[child].label_length_) && (pos + common < prefix.length()) &&
+                      (labels_[nodes_[child].label_offset_ + common] == prefix[pos + common]))
                 {
-                    index = prefix[first];
+                    common++;
                 }
 
-                if(current->childs_[index] != NULL)
+                if(common < nodes_[child].label_length_)
                 {
-                    if(reverse)
-                    {
-                        return (find_matching(prefix, first, last, current->childs_[index], lastValidValue, reverse));
-                    }
-                    else
+                    // split the edge; both halves keep pointing into the same label bytes
+                    uint32_t mid = new_node(nodes_[child].label_offset_, common);
+                    nodes_[child].label_offset_ += common;
+                    nodes_[child].label_length_ -= common;
+
+                    uint32_t* link = &nodes_[n].first_child_;
+
+                    while(*link != child)
                     {
-                        return (find_matching(prefix, first + 1, last, current->childs_[index], lastValidValue, reverse));
+                        link = &nodes_[*link].next_sibling_;
                     }
+
+                    *link = mid;
+                    nodes_[mid].next_sibling_ = nodes_[child].next_sibling_;
+                    nodes_[mid].first_child_ = child;
+                    nodes_[child].next_sibling_ = npos;
+
+                    child = mid;
                 }
-                else
-                {
-                    return lastValidValue;
-                }
+
+                n = child;
+                pos += common;
+            }
+
+            return n;
+        } //>::create_sub_tree
+
+        template<class T>
+        uint32_t route_mapper<T>::new_node(uint32_t labelOffset, uint32_t labelLength)
+        {
+            uint32_t n;
+
+            if(free_node_ != npos)
+            {
+                n = free_node_;
+                free_node_ = nodes_[n].next_sibling_;
+                nodes_[n] = node();
             }
             else
             {
-                return lastValidValue;
+                n = static_cast<uint32_t>(nodes_.size());
+                nodes_.emplace_back();
             }
-        } //>::find_matching
+
+            nodes_[n].label_offset_ = labelOffset;
+            nodes_[n].label_length_ = labelLength;
+            return n;
+        } //>::new_node
 
         template<class T>
-        char_node<T>* route_mapper<T>::create_sub_tree(const std::string& prefix,
-                                                       unsigned int       first,
-                                                       unsigned int       last,
-                                                       char_node<T>*      current)
+        void route_mapper<T>::link_child(uint32_t parent, uint32_t child)
         {
-            if(first < last)
+            const unsigned char ch = label_at(nodes_[child], 0);
+            uint32_t* link = &nodes_[parent].first_child_;
+
+            while((*link != npos) && (label_at(nodes_[*link], 0) < ch))
             {
-                unsigned char index = prefix[first];
+                link = &nodes_[*link].next_sibling_;
+            }
 
-                if(current->childs_[index] == NULL)
-                {
-                    current->childs_[index] = new char_node<T>(current->depth_ + 1, current, index);
-                    current->number_of_childs_++;
-                }
+            nodes_[child].next_sibling_ = *link;
+            *link = child;
+        } //>::link_child
 
-                return (create_sub_tree(prefix, first + 1, last, current->childs_[index]));
+        template<class T>
+        void route_mapper<T>::set_value(uint32_t n, T destination, unsigned int maxLength)
+        {
+            if(!free_values_.empty())
+            {
+                nodes_[n].value_ = free_values_.back();
+                free_values_.pop_back();
+                values_[nodes_[n].value_] = route_value{ std::move(destination), maxLength };
             }
             else
             {
-                if(current->has_value_flag_)
-                {
-                    return NULL;
-                }
-                else
-                {
-                    return current;
-                }
+                nodes_[n].value_ = static_cast<uint32_t>(values_.size());
+                values_.push_back(route_value{ std::move(destination), maxLength });
             }
-        } //>::create_sub_tree
+        } //>::set_value
 
+        /**
+         * @brief clean_up, removes the nodes of prefix which have neither a value nor a child.
+         * pass-through nodes left by a delete are not merged back, matching stays correct
+         */
         template<class T>
-        void route_mapper<T>::clean_up(char_node<T>* current)
+        void route_mapper<T>::clean_up(const std::string& prefix)
         {
-            if((!current->has_value_flag_) && (!current->number_of_childs_))
+            std::vector<uint32_t> path{ 0 };
+            size_t pos = 0;
+
+            while(pos < prefix.length())
+            {
+                path.push_back(find_child(path.back(), prefix[pos]));
+                pos += nodes_[path.back()].label_length_;
+            }
+
+            for(size_t i = path.size() - 1; i > 0; i--)
             {
-                char_node<T>* parent = current->parent_;
+                uint32_t n = path[i];
+
+                if((nodes_[n].value_ != npos) || (nodes_[n].first_child_ != npos))
+                {
+                    break;
+                }
+
+                uint32_t* link = &nodes_[path[i - 1]].first_child_;
 
-                if(parent != NULL)
+                while(*link != n)
                 {
-                    parent->number_of_childs_--;
-                    parent->childs_[current->index_] = NULL;
-                    delete current;
-                    clean_up(parent);
+                    link = &nodes_[*link].next_sibling_;
                 }
+
+                *link = nodes_[n].next_sibling_;
+
+                nodes_[n].next_sibling_ = free_node_;
+                free_node_ = n;
             }
         } //>::clean_up
     }
@@ -4,6 +4,32 @@
 
 #include <algorithm>
 
+namespace
+{
+uint64_t hash_key(std::string_view key)
+{
+    uint64_t h = 14695981039346656037ull;
+    for(auto c : key)
+    {
+        h ^= static_cast<uint8_t>(c);
+        h *= 1099511628211ull;
+    }
+
+    return h;
+}
+
+// splitmix64 finalizer, spreads the combined key and target hash over all bits
+uint64_t mix(uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+}
+} // namespace
+
 router::router(pa::config::manager* config_manager,
                const std::shared_ptr<pa::config::node>& config,
                msg_type_convert_handler_t handler)
@@ -22,17 +48,20 @@ router::~router()
 void router::on_reverse_replace(const std::shared_ptr<pa::config::node>& config)
 {
     reverse_ = config->get<bool>();
+    reverse_generation_.fetch_add(1, std::memory_order_release);
 }
 
 void router::add_target(const std::string& target)
 {
-    if(std::none_of(targets_list_.begin(), targets_list_.end(), [&target](std::string& name) {
-        return target == name;
-    }))
+    auto itr = std::lower_bound(targets_list_.begin(), targets_list_.end(), target);
+
+    if(itr == targets_list_.end() || *itr != target)
     {
-        targets_list_.push_back(target);
+        const auto index = itr - targets_list_.begin();
 
-        std::sort(targets_list_.begin(), targets_list_.end());
+        targets_list_.insert(itr, target);
+        target_hashes_.insert(target_hashes_.begin() + index, hash_key(target));
+        target_loads_.insert(target_loads_.begin() + index, target_load{});
     }
     else
     {
@@ -47,12 +76,62 @@ void router::remove_target(const std::string& target)
         if(targets_list_[i] == target)
         {
             targets_list_.erase(targets_list_.begin() + i);
+            target_hashes_.erase(target_hashes_.begin() + i);
+            target_loads_.erase(target_loads_.begin() + i);
         }
     }
 
     last_index_ = 0;
+    least_outstanding_start_ = 0;
 } //router::remove_connection
 
+router::target_load* router::find_load(const std::string& target)
+{
+    auto itr = std::lower_bound(targets_list_.begin(), targets_list_.end(), target);
+
+    if(itr == targets_list_.end() || *itr != target)
+    {
+        return nullptr;
+    }
+
+    return &target_loads_[itr - targets_list_.begin()];
+}
+
+void router::on_request_sent(const std::string& target)
+{
+    if(auto load = find_load(target))
+    {
+        load->in_flight++;
+    }
+}
+
+void router::on_request_done(const std::string& target, std::chrono::microseconds latency)
+{
+    // the target may have been removed and added again since the request was sent
+    auto load = find_load(target);
+    if(!load)
+    {
+        return;
+    }
+
+    if(load->in_flight)
+    {
+        load->in_flight--;
+    }
+
+    const auto sample = std::max<uint64_t>(latency.count(), 1);
+
+    // alpha = 1/8, a timeout counts as a sample of the whole timeout
+    if(load->latency_us)
+    {
+        load->latency_us = load->latency_us - load->latency_us / 8 + sample / 8;
+    }
+    else
+    {
+        load->latency_us = sample;
+    }
+}
+
 void router::find(int msg_type, const std::string& id, std::vector<std::string>& targets_list)
 {
     auto method = routingList_->find_routing_method(msg_type);
@@ -79,6 +158,14 @@ void router::find(int msg_type, const std::string& id, std::vector<std::string>&
             route_by_client_id(id, targets_list);
             break;
 
+        case routing_method::RM_LEAST_OUTSTANDING:
+            route_by_least_outstanding(targets_list, false);
+            break;
+
+        case routing_method::RM_WEIGHTED_LEAST_OUTSTANDING:
+            route_by_least_outstanding(targets_list, true);
+            break;
+
         default:
             break;
     } //switch
@@ -102,11 +189,20 @@ void router::route_by_client_id(const std::string& clientId, std::vector<std::st
 
 void router::route_by_prefix(const std::string& prefix, int msg_type, std::vector<std::string>& targets_list, bool reverse)
 {
-    auto r = routingList_->find_target(prefix, msg_type, reverse);
+    // read before the lookup, so a result is never cached under a newer generation than it was found in
+    const auto generation = routingList_->generation() + reverse_generation_.load(std::memory_order_acquire);
+
+    const std::string* r = nullptr;
+
+    if(!route_cache_.find(generation, msg_type, prefix, r))
+    {
+        r = routingList_->find_target(prefix, msg_type, reverse);
+        route_cache_.insert(generation, msg_type, prefix, r);
+    }
 
-    if(r.size())
+    if(r && r->size())
     {
-        targets_list.push_back(r);
+        targets_list.push_back(*r);
     }
 }
 
@@ -119,20 +215,98 @@ void router::route_by_round_robin(std::vector<std::string>& targets_list)
     }
 }
 
-struct MyHash
+/*
+ * rendezvous (highest random weight) hashing: every target scores the key and the highest score wins.
+ * The score of a (key, target) pair does not depend on the other targets, so adding a target only moves
+ * the keys it wins and removing one only moves its own keys; all other keys keep their target.
+ */
+void router::route_by_load_balance(const std::string& prefix, std::vector<std::string>& targets_list)
 {
-    int operator()(const std::string& str) const noexcept
+    if(targets_list_.empty())
     {
-        return std::stoi(str.substr(str.length() - 5));
+        return;
     }
-};
 
-void router::route_by_load_balance(const std::string& prefix, std::vector<std::string>& targets_list)
+    const auto key_hash = hash_key(prefix);
+
+    size_t best = 0;
+    uint64_t best_score = 0;
+
+    for(size_t i = 0; i < target_hashes_.size(); i++)
+    {
+        const auto score = mix(key_hash ^ target_hashes_[i]);
+        if(i == 0 || score > best_score)
+        {
+            best = i;
+            best_score = score;
+        }
+    }
+
+    targets_list.push_back(targets_list_[best]);
+}
+
+/*
+ * picks the target with the fewest requests waiting for a response. Weighted, a target costs
+ * (in_flight + 1) * latency, so a node whose responses slow down gets less traffic before its queue grows.
+ * Targets without a latency sample yet are assumed as fast as the fastest known one.
+ */
+void router::route_by_least_outstanding(std::vector<std::string>& targets_list, bool weighted)
 {
-    if(targets_list_.size() > 0)
+    if(targets_list_.empty())
+    {
+        return;
+    }
+
+    uint64_t default_latency = 0;
+    if(weighted)
     {
-        int h = MyHash{}(prefix);
-        int index = h % targets_list_.size();
-        targets_list.push_back(targets_list_[index]);
+        for(const auto& load : target_loads_)
+        {
+            if(load.latency_us && (!default_latency || load.latency_us < default_latency))
+            {
+                default_latency = load.latency_us;
+            }
+        }
+    }
+
+    const auto count = targets_list_.size();
+    const auto start = least_outstanding_start_ % count;
+
+    size_t best = start;
+    uint64_t best_cost = UINT64_MAX;
+
+    for(size_t n = 0; n < count; n++)
+    {
+        const auto i = (start + n) % count;
+        const auto& load = target_loads_[i];
+
+        uint64_t cost = load.in_flight;
+        if(weighted)
+        {
+            cost = (cost + 1) * std::max<uint64_t>(load.latency_us ? load.latency_us : default_latency, 1);
+        }
+
+        if(cost < best_cost)
+        {
+            best = i;
+            best_cost = cost;
+        }
+    }
+
+    // an idle target gets no new samples, so its latency fades toward the fastest one until it is probed again
+    if(weighted)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            auto& load = target_loads_[i];
+            if(i != best && !load.in_flight && load.latency_us > default_latency)
+            {
+                load.latency_us -= (load.latency_us - default_latency) / 8;
+            }
+        }
     }
+
+    least_outstanding_start_ = start + 1;
+
+    targets_list.push_back(targets_list_[best]);
 }
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "routing_list.h"
+#include "route_cache.h"
 
 #include <pa/config.hpp>
 
+#include <chrono>
+
 class router
 {
 public:
@@ -18,6 +21,16 @@ public:
 
     void find(int msg_type, const std::string& id, std::vector<std::string>& targets_list);
 
+    /**
+     * @brief a request was sent to target and waits for its response
+     */
+    void on_request_sent(const std::string& target);
+
+    /**
+     * @brief a request of target got its response or timed out after latency
+     */
+    void on_request_done(const std::string& target, std::chrono::microseconds latency);
+
     void on_reverse_replace(const std::shared_ptr<pa::config::node>& config);
 
 protected:
@@ -26,11 +39,26 @@ protected:
     void route_by_prefix(const std::string& prefix, int msg_type, std::vector<std::string>& destinationAddresses, bool reverse);
     void route_by_round_robin(std::vector<std::string>& destinationAddresses);
     void route_by_load_balance(const std::string& prefix, std::vector<std::string>& destinationAddresses);
+    void route_by_least_outstanding(std::vector<std::string>& destinationAddresses, bool weighted);
+
+    struct target_load
+    {
+        uint32_t in_flight = 0;
+        uint64_t latency_us = 0; /**< EWMA of response latency, 0 until the first response */
+    };
+
+    target_load* find_load(const std::string& target);
 
     int last_index_;
     bool reverse_;
     std::shared_ptr<routing_list> routingList_;
     std::vector<std::string> targets_list_;
+    std::vector<uint64_t> target_hashes_; /**< hash of every name in targets_list_, same order */
+    std::vector<target_load> target_loads_; /**< load of every target in targets_list_, same order */
+    size_t least_outstanding_start_ = 0;   /**< rotates, so equally loaded targets share the traffic */
+
+    route_cache route_cache_;                       /**< prefix lookups, tagged with routingList_ generation + reverse_generation_ */
+    std::atomic<uint64_t> reverse_generation_{ 0 }; /**< bumped when reverse_ changes, so cached lookups of the other direction are dropped */
 
     pa::config::manager::observer config_obs_reverse_replace_;
 };
@@ -32,6 +32,16 @@ static routing_method create_method_by_string(const std::string& methodStr)
         return routing_method::RM_ROUTE_BY_CLIENT_ID;
     }
 
+    if(methodStr == "least_outstanding")
+    {
+        return routing_method::RM_LEAST_OUTSTANDING;
+    }
+
+    if(methodStr == "weighted_least_outstanding")
+    {
+        return routing_method::RM_WEIGHTED_LEAST_OUTSTANDING;
+    }
+
     LOG_ERROR("invalid routing method!");
     throw std::runtime_error("invalid routing method!");
 }
@@ -105,6 +115,8 @@ void routing_list::on_routes_insert(const std::shared_ptr<pa::config::node>& con
         throw std::runtime_error("route " + config->at("msg_type")->get<std::string>() + " is duplicated!");
     }
 
+    generation_.fetch_add(1, std::memory_order_release);
+
     // for(auto& p : routes->prefixes_)
     // {
     //     destinations_.add_route(p, routes->target_);
@@ -116,6 +128,8 @@ void routing_list::on_routes_remove(const std::shared_ptr<pa::config::node>& con
     std::shared_ptr<route> routes = std::make_shared<route>(config, msg_type_convert_handler_);
     msg_type_to_route_map_.erase(routes->msg_type_);
 
+    generation_.fetch_add(1, std::memory_order_release);
+
     // for(auto& p : routes->prefixes_)
     // {
     //     destinations_.delete_route(p);
@@ -135,14 +149,14 @@ routing_method routing_list::find_routing_method(int msgType)
     return method;
 }
 
-std::string routing_list::find_target(std::string prefix, int msgType, bool reverse)
+const std::string* routing_list::find_target(const std::string& prefix, int msgType, bool reverse) const
 {
     auto itr = msg_type_to_route_map_.find(msgType);
 
     if(itr != msg_type_to_route_map_.end())
     {
-        return itr->second->destinations_.find_destination(prefix, reverse);
+        return itr->second->destinations_.find(prefix, reverse);
     }
 
-    return "";
+    return nullptr;
 }
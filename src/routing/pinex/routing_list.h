@@ -4,16 +4,19 @@
 
 #include <pa/config.hpp>
 
+#include <atomic>
 #include <map>
 #include <memory>
 
 enum class routing_method
 {
-    RM_ROUND_ROBIN        = 0,
-    RM_LOAD_BALANCE       = 1,
-    RM_BROAD_CAST         = 2,
-    RM_ROUTE_BY_CLIENT_ID = 3,
-    RM_ROUTE_BY_PREFIX    = 4
+    RM_ROUND_ROBIN                = 0,
+    RM_LOAD_BALANCE               = 1,
+    RM_BROAD_CAST                 = 2,
+    RM_ROUTE_BY_CLIENT_ID         = 3,
+    RM_ROUTE_BY_PREFIX            = 4,
+    RM_LEAST_OUTSTANDING          = 5,
+    RM_WEIGHTED_LEAST_OUTSTANDING = 6
 };
 
 using msg_type_convert_handler_t = std::function<int(const std::string&)>;
@@ -46,7 +49,18 @@ public:
 
     routing_method find_routing_method(int msgType);
 
-    std::string find_target(std::string prefix, int msgType, bool reverse = false);
+    /**
+     * @return nullptr if no route matches
+     */
+    const std::string* find_target(const std::string& prefix, int msgType, bool reverse = false) const;
+
+    /**
+     * @brief changes whenever a route is inserted or removed, targets found in an older generation may be dangling
+     */
+    uint64_t generation() const
+    {
+        return generation_.load(std::memory_order_acquire);
+    }
 
     msg_type_convert_handler_t msg_type_convert_handler_;
 
@@ -55,4 +69,7 @@ public:
 
 public:
     std::map<int, std::shared_ptr<route> > msg_type_to_route_map_;
+
+private:
+    std::atomic<uint64_t> generation_{ 1 };
 };
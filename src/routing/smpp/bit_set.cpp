@@ -1,9 +1,35 @@
 #include "bit_set.h"
 
+#include <algorithm>
 #include <cassert>
-#include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <new>
+
+namespace
+{
+constexpr size_t words_per_line = 8; // 64 bytes
+
+size_t words_for(size_t t_size)
+{
+    size_t words = (t_size + 63) / 64;
+    return std::max<size_t>(words_per_line, (words + words_per_line - 1) / words_per_line * words_per_line);
+}
+
+uint64_t* allocate_words(size_t t_words)
+{
+    auto* storage = static_cast<uint64_t*>(std::aligned_alloc(words_per_line * sizeof(uint64_t), t_words * sizeof(uint64_t)));
+
+    if(!storage)
+    {
+        throw std::bad_alloc();
+    }
+
+    std::memset(storage, 0, t_words * sizeof(uint64_t));
+    return storage;
+}
+} // namespace
 
 const std::array<uint64_t, 64> bit_set::ind_set_ = {
     0b0000000000000000000000000000000000000000000000000000000000000001ull, 0b0000000000000000000000000000000000000000000000000000000000000010ull,
@@ -77,23 +103,23 @@ const std::array<uint64_t, 64> bit_set::ind_unset_ = {
 
 bit_set::~bit_set()
 {
-    delete[] storage_;
+    std::free(storage_);
     storage_ = nullptr;
 }
 
 bit_set::bit_set(size_t t_size)
-    : word_size_(static_cast<size_t>(std::ceil(static_cast<double>(t_size) / 64)))
+    : word_size_(words_for(t_size))
     , size_(t_size)
 {
-    storage_ = new uint64_t[word_size_]{ 0 }; //new initialized it to zero
+    storage_ = allocate_words(word_size_);
 }
 
 bit_set::bit_set(const bit_set& otherbit_set)
     : word_size_(otherbit_set.word_size_)
     , size_(otherbit_set.size_)
 {
-    storage_ = new uint64_t[word_size_]{ 0 };
-    std::memcpy(storage_, otherbit_set.storage_, word_size_ * 64);
+    storage_ = allocate_words(word_size_);
+    std::memcpy(storage_, otherbit_set.storage_, word_size_ * sizeof(uint64_t));
 }
 
 bit_set::bit_set(bit_set&& otherbit_set) noexcept
@@ -199,6 +225,23 @@ void bit_set::set(const size_t ind, bool value)
     }
 }
 
+void bit_set::reset()
+{
+    std::memset(storage_, 0, word_size_ * sizeof(uint64_t));
+}
+
+bool bit_set::none() const
+{
+    uint64_t any = 0;
+
+    for(size_t i = 0; i < word_size_; i++)
+    {
+        any |= storage_[i];
+    }
+
+    return any == 0;
+}
+
 bool bit_set::get(size_t ind) const
 {
     assert(ind < size_);
@@ -228,35 +271,8 @@ std::vector<size_t> bit_set::get_set_bits_indices() const
 {
     std::vector<size_t> ret;
     ret.reserve(64);
-#ifdef __GNUG__
-    uint64_t tmp;
-    size_t pos;
-
-    for(size_t i = 0; i < word_size_; i++)
-    {
-        tmp = storage_[i];
-
-        while(tmp)
-        {
-            pos = static_cast<size_t>(__builtin_ctzll(tmp));
-            ret.push_back((i * 64) + pos);
-            tmp ^= (1ull << pos);
-        }
-    }
 
-#else //ifdef __GNUG__
-    std::div_t res;
-
-    for(size_t i = 0; i < size_; i++)
-    {
-        res = std::div(i, 64);
-
-        if((storage_[res.quot] & ind_set_[res.rem]))
-        {
-            ret.push_back(i);
-        }
-    }
+    for_each_set_bit([&ret](size_t ind) { ret.push_back(ind); });
 
-#endif //ifdef __GNUG__
     return ret;
 } //bit_set::get_set_bits_indices
@@ -6,6 +6,7 @@
 
 /**
  * @brief simple bit_set that uses uint64_t as underlaying data type
+ * storage is 64-byte aligned and padded to whole cache lines so word loops vectorize without a tail
  */
 class bit_set
 {
@@ -40,6 +41,14 @@ public:
      */
     void shift_right();
     void set(const size_t ind, bool value = true);
+    /**
+     * @brief clears all bits, keeps the storage
+     */
+    void reset();
+    /**
+     * @return true, if no bit is set
+     */
+    bool none() const;
     bool get(size_t ind) const;
     std::string to_string() const;
 
@@ -49,6 +58,24 @@ public:
      */
     std::vector<size_t> get_set_bits_indices() const;
 
+    /**
+     * @brief calls t_handler(index) for every set bit in ascending order, without allocating
+     */
+    template<typename F>
+    void for_each_set_bit(F&& t_handler) const
+    {
+        for(size_t i = 0; i < word_size_; i++)
+        {
+            uint64_t tmp = storage_[i];
+
+            while(tmp)
+            {
+                t_handler((i * 64) + static_cast<size_t>(__builtin_ctzll(tmp)));
+                tmp &= tmp - 1;
+            }
+        }
+    }
+
 private:
     uint64_t* storage_ = nullptr;
     size_t word_size_;
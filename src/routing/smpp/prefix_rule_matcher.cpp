@@ -8,6 +8,8 @@ prefix_rule_matcher::prefix_rule_matcher(size_t t_rulesCount, size_t t_ruleParam
     , rules_count_(t_rulesCount)
     , trie_(t_rulesCount * t_ruleParameterCount)
     , match_mask_(t_rulesCount * t_ruleParameterCount)
+    , result_(t_rulesCount * t_ruleParameterCount)
+    , scratch_(t_rulesCount * t_ruleParameterCount)
 {
     for(size_t i = 0; i < t_rulesCount; i++)
     {
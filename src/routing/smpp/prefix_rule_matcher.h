@@ -2,6 +2,9 @@
 
 #include "trie_matcher.h"
 
+#include <cassert>
+#include <span>
+
 class prefix_rule_matcher
 {
 public:
@@ -22,10 +25,53 @@ public:
      */
     bit_set match_get_bitset(const std::vector<std::string>& t_record) const;
 
+    /**
+     * @brief set_reversed_parameter, the record value of parameter t_index is matched from its last character
+     * to its first by the allocation free match, e.g. for suffix routing on addresses
+     * @param t_index
+     */
+    void set_reversed_parameter(size_t t_index)
+    {
+        reversed_parameter_ = t_index;
+    }
+
+    /**
+     * @brief match, calls t_handler(ruleId) for every matched rule in ascending order.
+     * uses the preallocated scratch bit_sets of this matcher, so it does not allocate;
+     * not reentrant, a matcher must be used from one thread at a time
+     * @param t_record
+     * @param t_handler
+     */
+    template<typename F>
+    void match(std::span<const std::string_view> t_record, F&& t_handler) const
+    {
+        assert(t_record.size() == rule_parameter_count_);
+
+        result_.reset();
+        trie_.match(t_record[0], result_, reversed_parameter_ == 0);
+
+        for(size_t i = 1; i < rule_parameter_count_ && !result_.none(); i++)
+        {
+            result_.shift_right();
+            scratch_.reset();
+            trie_.match(t_record[i], scratch_, reversed_parameter_ == i);
+            result_ &= scratch_;
+        }
+
+        result_ &= match_mask_;
+
+        result_.for_each_set_bit([this, &t_handler](size_t item) {
+            t_handler(static_cast<ruleId_t>(((item + 1) / rule_parameter_count_) - 1));
+        });
+    }
+
 private:
     size_t rule_parameter_count_;
     size_t rules_count_;
     size_t count_of_set_rules_ = 0;
+    size_t reversed_parameter_ = SIZE_MAX;
     trie_matcher trie_;
     bit_set match_mask_;
+    mutable bit_set result_;
+    mutable bit_set scratch_;
 };
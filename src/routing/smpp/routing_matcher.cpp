@@ -1,8 +1,11 @@
 #include "routing_matcher.h"
 
+#include <algorithm>
+#include <array>
 #include <memory>
 
 constexpr static size_t ROUTING_FIELD_NUMBER = 4;
+constexpr static size_t DESTINATION_FIELD_INDEX = 2;
 constexpr static size_t MAXIMUM_RULE_NUMBER = 1000;
 
 routing_matcher::routing_matcher(pa::config::manager* config_manager, const std::shared_ptr<pa::config::node>& config)
@@ -12,8 +15,6 @@ routing_matcher::routing_matcher(pa::config::manager* config_manager, const std:
     , config_obs_routes_insert_{config_manager->on_insert(config->at("routes"), std::bind_front(&routing_matcher::on_routes_insert, this))}
     , config_obs_routes_remove_{config_manager->on_remove(config->at("routes"), std::bind_front(&routing_matcher::on_routes_remove, this))}
 {
-    prefix_rule_matcher_ = std::make_unique<prefix_rule_matcher>(MAXIMUM_RULE_NUMBER, ROUTING_FIELD_NUMBER);
-
     init();
 }
 
@@ -24,8 +25,28 @@ void routing_matcher::init()
     for(const auto& route_config : config_->at("routes")->nodes())
     {
         routing_info route = routing_info(route_config);
-        add_rule(route);
+
+        if(std::any_of(routes_.begin(), routes_.end(), [&](const auto& r) { return r.id() == route.id(); }))
+        {
+            LOG_ERROR("duplicate route id {}, the route is ignored", route.id());
+            continue;
+        }
+
+        if(routes_.size() == MAXIMUM_RULE_NUMBER)
+        {
+            LOG_ERROR("only {} routes are supported, route {} is ignored", MAXIMUM_RULE_NUMBER, route.id());
+            continue;
+        }
+
+        if(!is_valid(route))
+        {
+            continue;
+        }
+
+        routes_.push_back(route);
     }
+
+    compile();
 }
 
 std::string routing_matcher::find_target(
@@ -35,122 +56,101 @@ std::string routing_matcher::find_target(
     const std::string&                      pdu_type,
     std::function<bool(const std::string&)> is_available)
 {
-    auto dest = dest_address;
+    const auto table = table_.load(std::memory_order_acquire);
 
-    if(reverse_routing_)
-    {
-        std::reverse(dest.begin(), dest.end());
-    }
-
-    auto f = from;
-    transform(f.begin(), f.end(), f.begin(), ::tolower);
-
-    auto data = { f, src_address, dest, pdu_type };
-
-    std::vector<std::pair<std::string, uint16_t> > targetMatchList;
-    const std::vector<uint32_t> matchList = prefix_rule_matcher_->match(data);
-
-    for(const auto& matchId : matchList)
-    {
-        const auto& prmRuleIdIter = prm_id_to_rule_id_.find(matchId);
-
-        if(prmRuleIdIter != prm_id_to_rule_id_.end())
-        {
-            const auto& ruleIdIter = rule_id_mapping_.find(prmRuleIdIter->second);
+    // trie_matcher lowercases while matching and walks the destination backwards for reverse routing, nothing is copied
+    const std::array<std::string_view, ROUTING_FIELD_NUMBER> data = { from, src_address, dest_address, pdu_type };
 
-            if(ruleIdIter != rule_id_mapping_.end())
-            {
-                targetMatchList.push_back(ruleIdIter->second);
-            }
-        }
-    }
+    // the highest priority wins, the earliest route among equals
+    const routing_table::rule* matched = nullptr;
 
-    std::string matched;
-    int priority = -1;
+    table->matcher->match(data, [&](ruleId_t matchId) {
+        const auto& rule = table->rules[matchId];
 
-    for(auto& itr : targetMatchList)
-    {
-        if(itr.second > priority)
+        if(!matched || rule.priority > matched->priority)
         {
-            matched = itr.first;
+            matched = &rule;
         }
-    }
+    });
 
-    return matched;
+    return matched ? matched->target : std::string();
 } //routing_matcher::find_target
 
-bool routing_matcher::add_rule(const routing_info& inputRule)
+bool routing_matcher::is_valid(const routing_info& route)
 {
-    if(rule_id_mapping_.find(inputRule.id()) != rule_id_mapping_.end())
-    {
-        return false;
-    }
-
     try
     {
-        const size_t pRMId = prefix_rule_matcher_->set_rule(inputRule.get_list());
-        prm_id_to_rule_id_[pRMId] = inputRule.id();
-        rule_id_mapping_.emplace(inputRule.id(), std::make_pair(inputRule.target(), inputRule.priority()));
+        prefix_rule_matcher(1, ROUTING_FIELD_NUMBER).set_rule(route.get_list());
     }
     catch(const std::exception& e)
     {
-        LOG_ERROR("%s", e.what());
+        LOG_ERROR("route {} is invalid, {}", route.id(), e.what());
         return false;
     }
 
     return true;
-} //routing_matcher::add_rule
+}
 
-bool routing_matcher::remove_rule(uint64_t ruleId)
+void routing_matcher::compile()
 {
-    const auto iter = rule_id_mapping_.find(ruleId);
+    auto table = std::make_shared<routing_table>();
+    table->matcher = std::make_unique<prefix_rule_matcher>(MAXIMUM_RULE_NUMBER, ROUTING_FIELD_NUMBER);
+    table->rules.reserve(routes_.size());
 
-    if(iter != rule_id_mapping_.end())
+    if(reverse_routing_)
     {
-        rule_id_mapping_.erase(iter);
-
-        auto it = prm_id_to_rule_id_.begin();
-
-        while(it != prm_id_to_rule_id_.end())
-        {
-            if(it->second == ruleId)
-            {
-                it = prm_id_to_rule_id_.erase(it);
-                break;
-            }
-            else
-            {
-                it++;
-            }
-        }
+        table->matcher->set_reversed_parameter(DESTINATION_FIELD_INDEX);
+    }
 
-        return true;
+    for(const auto& route : routes_)
+    {
+        // rule ids of prefix_rule_matcher are consecutive from 0, so they index rules directly
+        table->matcher->set_rule(route.get_list());
+        table->rules.push_back({ route.target(), route.priority() });
     }
 
-    return false;
-} //routing_matcher::remove_rule
+    table_.store(std::move(table), std::memory_order_release);
+} //routing_matcher::compile
 
 void routing_matcher::on_reverse_routing_replace(const std::shared_ptr<pa::config::node>& config)
 {
     reverse_routing_ = config->get<bool>();
+
+    compile();
 }
 
 void routing_matcher::on_routes_insert(const std::shared_ptr<pa::config::node>& config)
 {
     routing_info route = routing_info(config);
 
-    if(!add_rule(route))
+    if(std::any_of(routes_.begin(), routes_.end(), [&](const auto& r) { return r.id() == route.id(); }))
+    {
+        throw std::runtime_error("could not add route");
+    }
+
+    if(routes_.size() >= MAXIMUM_RULE_NUMBER)
+    {
+        throw std::runtime_error("could not add route");
+    }
+
+    if(!is_valid(route))
     {
         throw std::runtime_error("could not add route");
     }
+
+    routes_.push_back(route);
+
+    compile();
 }
 
 void routing_matcher::on_routes_remove(const std::shared_ptr<pa::config::node>& config)
 {
     auto id = config->at("id")->get<uint32_t>();
 
-    if(!remove_rule(id))
+    if(std::erase_if(routes_, [id](const auto& r) { return r.id() == id; }) == 0)
     {
         throw std::runtime_error("could not remove route");
     }
+
+    compile();
 }
@@ -5,6 +5,10 @@
 #include "src/sgw_definitions.h"
 #include "src/libs/logging.hpp"
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 class routing_matcher
 {
     class routing_info
@@ -107,6 +111,23 @@ class routing_matcher
         std::string pdu_type_ = "*";
     };
 
+    /**
+     * @brief Immutable match structure compiled from routes_; replaced as a whole whenever the routing config changes.
+     * Rule i of `matcher` is `rules[i]`, and with reverse routing the destination is matched back to front.
+     * `matcher` uses scratch bit_sets, so a table is matched from one thread at a time (the smpp_gateway io_context).
+     */
+    struct routing_table
+    {
+        struct rule
+        {
+            std::string target;
+            uint16_t priority;
+        };
+
+        std::unique_ptr<prefix_rule_matcher> matcher;
+        std::vector<rule> rules;
+    };
+
 public:
     routing_matcher(pa::config::manager* config_manager, const std::shared_ptr<pa::config::node>& config);
     virtual ~routing_matcher() = default;
@@ -121,8 +142,15 @@ public:
 private:
     void init();
 
-    bool add_rule(const routing_info& inputRule);
-    bool remove_rule(uint64_t ruleId);
+    /**
+     * @brief whether the trie accepts every field of the route, only valid routes are kept in routes_
+     */
+    static bool is_valid(const routing_info& route);
+
+    /**
+     * @brief builds a routing_table from routes_ and reverse_routing_ and publishes it for find_target
+     */
+    void compile();
 
     void on_reverse_routing_replace(const std::shared_ptr<pa::config::node>& config);
     void on_routes_insert(const std::shared_ptr<pa::config::node>& config);
@@ -135,9 +163,9 @@ private:
     pa::config::manager::observer config_obs_routes_insert_;
     pa::config::manager::observer config_obs_routes_remove_;
 
+    // source of the compiled table, only touched by the config observers
     bool reverse_routing_ = false;
+    std::vector<routing_info> routes_;
 
-    std::unique_ptr<prefix_rule_matcher> prefix_rule_matcher_;
-    std::map<uint64_t, std::pair<std::string, uint16_t> > rule_id_mapping_;
-    std::map<size_t, uint64_t> prm_id_to_rule_id_;
+    std::atomic<std::shared_ptr<const routing_table> > table_;
 };
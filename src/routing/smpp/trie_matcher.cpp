@@ -54,34 +54,58 @@ void trie_matcher::add_entry(const std::string& t_prefixe, catId_t t_ruleTag)
 
 bit_set trie_matcher::match(const std::string& t_query) const
 {
-    std::string query(t_query);
-
-    for(char& ch : query)
-    {
-        if(isupper(ch))
-        {
-            ch = tolower(ch);
-        }
-    }
-
     bit_set ret(category_count_);
+    match(std::string_view(t_query), ret);
+    return ret;
+}
 
-    if(query == "*")
+void trie_matcher::match(std::string_view t_query, bit_set& t_result, bool t_reversed) const
+{
+    if(t_query == "*")
     {
-        ret |= root_->mark_prefix;
+        t_result |= root_->mark_prefix;
+        return;
     }
-    else if(query.length() == 0)
+
+    if(t_query.empty())
     {
         //empty parameter just match with complete empty (not prefix empty)
-        ret |= root_->mark_Complete;
+        t_result |= root_->mark_Complete;
+        return;
     }
-    else
+
+    const node* n = root_;
+
+    for(size_t i = 0; i < t_query.size(); i++)
     {
-        trace_nodes(root_, query, 0, ret);
+        t_result |= n->mark_prefix;
+
+        char ch = t_query[t_reversed ? t_query.size() - 1 - i : i];
+        ch = static_cast<char>(tolower(static_cast<unsigned char>(ch)));
+        auto alphabetIndex = alphabets_map_[static_cast<unsigned char>(ch)];
+
+        if(alphabetIndex > -1)
+        {
+            n = n->childrenAlphabet ? n->childrenAlphabet[alphabetIndex] : nullptr;
+        }
+        else if(isdigit(static_cast<unsigned char>(ch)))
+        {
+            n = n->children[ch - '0'];
+        }
+        else
+        {
+            throw std::runtime_error("Invalid character in query word: " + std::string(t_query));
+        }
+
+        if(!n)
+        {
+            return;
+        }
     }
 
-    return ret;
-} //trie_matcher::Match
+    t_result |= n->mark_prefix;
+    t_result |= n->mark_Complete;
+} //trie_matcher::match
 
 void trie_matcher::remove_trie(node* n)
 {
@@ -172,39 +196,3 @@ void trie_matcher::insert_node(trie_matcher::node* n, const std::string& word, s
         throw std::runtime_error("Invalid character in query word: " + word);
     }
 } //trie_matcher::insert_node
-
-void trie_matcher::trace_nodes(node* n, const std::string& word, size_t index, bit_set& result) const
-{
-    if(!n)
-    {
-        return;
-    }
-
-    result |= n->mark_prefix;
-
-    if(index == word.length())
-    {
-        result |= n->mark_Complete;
-        return;
-    }
-
-    auto alphabetIndex = alphabets_map_.at(static_cast<size_t>(word[index]));
-
-    if(alphabetIndex > -1)
-    {
-        if(n->childrenAlphabet == nullptr)
-        {
-            return;
-        }
-
-        return trace_nodes(n->childrenAlphabet[alphabetIndex], word, index + 1, result);
-    }
-    else if(isdigit(word[index]))
-    {
-        return trace_nodes(n->children[word[index] - '0'], word, index + 1, result);
-    }
-    else
-    {
-        throw std::runtime_error("Invalid character in query word: " + word);
-    }
-} //trie_matcher::trace_nodes
@@ -3,6 +3,7 @@
 #include "bit_set.h"
 
 #include <iostream>
+#include <string_view>
 
 #define INTEGERS 10
 #define ALPHABETS 59 //all printable characters except uppercase letters and digits
@@ -45,6 +46,13 @@ public:
     void add_entry(const std::string& t_prefixe, catId_t t_ruleTag);
 
     bit_set match(const std::string& t_query) const;
+    /**
+     * @brief match, ORs the tags of t_query into t_result; case insensitive, does not allocate
+     * @param t_query
+     * @param t_result should have been constructed with the category count of this trie
+     * @param t_reversed walks t_query from its last character to its first
+     */
+    void match(std::string_view t_query, bit_set& t_result, bool t_reversed = false) const;
     size_t get_trie_size() const
     {
         return byte_counts_;
@@ -53,7 +61,6 @@ public:
 private:
     void remove_trie(node* node);
     void insert_node(node* node, const std::string& word, size_t index, ruleId_t t_ruleTag, entry_type t_entryType);
-    void trace_nodes(node* node, const std::string& word, size_t index, bit_set& result) const;
     node* get_root();
 
 private:
@@ -131,6 +131,147 @@ constexpr auto schema = std::string_view{ R"(
             "timeout": {
               "type": "integer",
               "minimum": 0
+            },
+            "verdict_cache": {
+              "type": "object",
+              "properties": {
+                "capacity": {
+                  "type": "integer",
+                  "minimum": 0
+                },
+                "ttl": {
+                  "type": "object",
+                  "properties": {
+                    "source_address_check": {
+                      "type": "integer",
+                      "minimum": 0
+                    },
+                    "source_ton_npi_check": {
+                      "type": "integer",
+                      "minimum": 0
+                    },
+                    "destination_address_check": {
+                      "type": "integer",
+                      "minimum": 0
+                    },
+                    "destination_ton_npi_check": {
+                      "type": "integer",
+                      "minimum": 0
+                    },
+                    "dcs_check": {
+                      "type": "integer",
+                      "minimum": 0
+                    },
+                    "black_white_check": {
+                      "type": "integer",
+                      "minimum": 0
+                    }
+                  }
+                }
+              },
+              "required": [
+                "capacity",
+                "ttl"
+              ]
+            },
+            "black_white_list": {
+              "type": "object",
+              "properties": {
+                "source_black_list": {
+                  "type": "string"
+                },
+                "source_white_list": {
+                  "type": "string"
+                },
+                "destination_black_list": {
+                  "type": "string"
+                },
+                "bits_per_number": {
+                  "type": "integer",
+                  "minimum": 4,
+                  "maximum": 24
+                }
+              },
+              "required": [
+                "source_black_list",
+                "source_white_list",
+                "destination_black_list",
+                "bits_per_number"
+              ]
+            },
+            "batch": {
+              "type": "object",
+              "properties": {
+                "max_requests": {
+                  "type": "integer",
+                  "minimum": 0
+                },
+                "window_us": {
+                  "type": "integer",
+                  "minimum": 0
+                }
+              },
+              "required": [
+                "max_requests",
+                "window_us"
+              ]
+            },
+            "circuit_breaker": {
+              "type": "object",
+              "properties": {
+                "window": {
+                  "type": "integer",
+                  "minimum": 0
+                },
+                "min_requests": {
+                  "type": "integer",
+                  "minimum": 0
+                },
+                "max_error_percent": {
+                  "type": "integer",
+                  "minimum": 0,
+                  "maximum": 100
+                },
+                "max_slow_percent": {
+                  "type": "integer",
+                  "minimum": 0,
+                  "maximum": 100
+                },
+                "slow_latency_ms": {
+                  "type": "integer",
+                  "minimum": 0
+                },
+                "open_duration_ms": {
+                  "type": "integer",
+                  "minimum": 0
+                }
+              },
+              "required": [
+                "window",
+                "min_requests",
+                "max_error_percent",
+                "max_slow_percent",
+                "slow_latency_ms",
+                "open_duration_ms"
+              ]
+            },
+            "hedge": {
+              "type": "object",
+              "properties": {
+                "percentile": {
+                  "type": "integer",
+                  "minimum": 0,
+                  "maximum": 100
+                },
+                "min_delay_ms": {
+                  "type": "integer",
+                  "minimum": 0
+                }
+              },
+              "required": [
+                "percentile",
+                "min_delay_ms"
+              ]
             }
           },
           "required": [
@@ -325,6 +466,34 @@ constexpr auto schema = std::string_view{ R"(
                 },
                 "topic": {
                   "type": "string"
+                },
+                "mode": {
+                  "type": "string",
+                  "enum": [
+                    "sync",
+                    "async"
+                  ]
+                },
+                "sink": {
+                  "type": "string",
+                  "enum": [
+                    "kafka",
+                    "file"
+                  ]
+                },
+                "file_path": {
+                  "type": "string"
+                },
+                "queue_size": {
+                  "type": "integer",
+                  "minimum": 2
+                },
+                "spool_path": {
+                  "type": "string"
+                },
+                "spool_segment_size": {
+                  "type": "integer",
+                  "minimum": 1
                 }
               },
               "required": [
@@ -365,6 +534,10 @@ constexpr auto schema = std::string_view{ R"(
             "inactivity_timeout": {
               "type": "integer"
             },
+            "worker_threads": {
+              "type": "integer",
+              "minimum": 0
+            },
             "external_client": {
               "type": "array",
               "items": {
@@ -475,6 +648,41 @@ constexpr auto schema = std::string_view{ R"(
                     "minimum":0,
                     "maximum":50
                   },
+                  "window_size": {
+                    "type": "integer",
+                    "minimum":1
+                  },
+                  "deliver_store": {
+                    "type": "object",
+                    "properties": {
+                      "enabled": {
+                        "type": "boolean"
+                      },
+                      "path": {
+                        "type": "string"
+                      },
+                      "segment_size": {
+                        "type": "integer",
+                        "minimum": 4096,
+                        "maximum": 1073741824
+                      },
+                      "max_segments": {
+                        "type": "integer",
+                        "minimum": 1
+                      },
+                      "queue_threshold": {
+                        "type": "integer",
+                        "minimum": 1
+                      }
+                    },
+                    "required": [
+                      "enabled",
+                      "path",
+                      "segment_size",
+                      "max_segments",
+                      "queue_threshold"
+                    ]
+                  },
                   "receive_flow_control":{
                     "type":"object",
                     "properties":{
@@ -486,7 +694,8 @@ constexpr auto schema = std::string_view{ R"(
                           "normal",
                           "adaptive",
                           "credit",
-                          "limit_credit"
+                          "limit_credit",
+                          "token_bucket"
                         ]
                       },
                       "max_packets_per_second":{
@@ -500,6 +709,10 @@ constexpr auto schema = std::string_view{ R"(
                       },
                       "max_slippage":{
                         "type":"integer"
+                      },
+                      "burst_size":{
+                        "type":"integer",
+                        "minimum":1
                       }
                     }
                   },
@@ -514,7 +727,8 @@ constexpr auto schema = std::string_view{ R"(
                           "normal",
                           "adaptive",
                           "credit",
-                          "limit_credit"
+                          "limit_credit",
+                          "token_bucket"
                         ]
                       },
                       "max_packets_per_second":{
@@ -525,6 +739,10 @@ constexpr auto schema = std::string_view{ R"(
                       },
                       "max_slippage":{
                         "type":"integer"
+                      },
+                      "burst_size":{
+                        "type":"integer",
+                        "minimum":1
                       }
                     }
                   }
@@ -665,7 +883,9 @@ constexpr auto schema = std::string_view{ R"(
                           "client_id",
                           "rond_robin",
                           "load_balance",
-                          "broadcast"
+                          "broadcast",
+                          "least_outstanding",
+                          "weighted_least_outstanding"
                         ]
                       },
                       "routes": {
@@ -157,6 +157,8 @@ struct deliver_info
 
     std::string smsc_unique_id_;                                            /**< Unique identifier assigned by the SMSC to the delivery request. */
 
+    uint64_t store_record_ = 0;                                             /**< Id of the record in the client's deliver store when the packet is replayed from it, 0 otherwise. */
+
     bool is_report_ = false;                                                /**< Flag indicating if this struct holds information from a delivery report (true) or a delivery request as default(false). */
     std::shared_ptr<SMSC::Protobuf::SMPP::Deliver_Sm_Req> request; /**< Shared pointer to the original deliver request details. */          //todo
     std::shared_ptr<SMSC::Protobuf::SMPP::DeliveryReport_Req> dr_request; /**< Shared pointer to the corresponding delivery report request details. only populated if `is_report_` is true. */   //todo
@@ -4,30 +4,221 @@
 #include "src/smpp/delivery_report.h"
 
 #include "src/logging/sgw_logger.h"
+#include "src/libs/protobuf_arena.hpp"
 
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/uuid/random_generator.hpp>
 
+#include <cstring>
+
+namespace
+{
+constexpr io::counter_family_spec counter_families[] = {
+    { "smpp_server_bind_failed", "smpp server bind failed" },
+    { "smpp_server_submit", "smpp server submit parameters" },
+    { "smpp_server_submit_resp", "smpp server submit_resp parameters" },
+    { "smpp_server_deliver", "smpp server deliver parameters" },
+    { "smpp_server_deliver_resp", "smpp server deliver_resp parameters" },
+    { "smpp_server_delivery_report", "smpp server delivery_report parameters" },
+    { "smpp_server_delivery_report_resp", "smpp server delivery_report_resp parameters" },
+};
+
+enum family : size_t
+{
+    bind_family,
+    submit_family,
+    submit_resp_family,
+    deliver_family,
+    deliver_resp_family,
+    delivery_report_family,
+    delivery_report_resp_family,
+};
+
+// same order as sgw_external_client::counter
+constexpr io::counter_spec counter_specs[] = {
+    { bind_family, "connection_reqs_failed" },
+    { submit_family, "received" },
+    { submit_family, "submits_require_srr" },
+    { submit_family, "submits_default_encoding", "data_encoding" },
+    { submit_family, "submits_8bit_ascii_encoding", "data_encoding" },
+    { submit_family, "submits_8bit_data_encoding", "data_encoding" },
+    { submit_family, "submits_16bit_data_encoding", "data_encoding" },
+    { submit_family, "submits_invalid_data_encoding", "data_encoding" },
+    { submit_family, "submits_rejected" },
+    { submit_family, "submits_rejected_by_flow_control" },
+    { submit_family, "submits_rejected_by_policy" },
+    { submit_resp_family, "ok_status" },
+    { submit_resp_family, "timeout_status" },
+    { submit_resp_family, "invalid_data_encoding_status" },
+    { submit_resp_family, "invalid_src_status" },
+    { submit_resp_family, "invalid_src_ton_status" },
+    { submit_resp_family, "invalid_src_npi_status" },
+    { submit_resp_family, "invalid_dst_status" },
+    { submit_resp_family, "invalid_dst_ton_status" },
+    { submit_resp_family, "invalid_dst_npi_status" },
+    { submit_resp_family, "other_error_status" },
+    { submit_resp_family, "sending_succeed" },
+    { submit_resp_family, "sending_failed" },
+    { deliver_family, "sending_succeed" },
+    { deliver_family, "sending_failed" },
+    { deliver_resp_family, "received" },
+    { deliver_resp_family, "rejected" },
+    { deliver_resp_family, "timeout_status" },
+    { deliver_resp_family, "success_status" },
+    { deliver_resp_family, "fail_status" },
+    { deliver_resp_family, "sending_succeed" },
+    { deliver_resp_family, "sending_failed" },
+    { delivery_report_family, "received" },
+    { delivery_report_family, "delivered_status" },
+    { delivery_report_family, "expired_status" },
+    { delivery_report_family, "deleted_status" },
+    { delivery_report_family, "undeliverable_status" },
+    { delivery_report_family, "accepted_status" },
+    { delivery_report_family, "unknown_status" },
+    { delivery_report_family, "rejected_status" },
+    { delivery_report_family, "sending_succeed" },
+    { delivery_report_family, "sending_failed" },
+    { delivery_report_resp_family, "received_resp" },
+    { delivery_report_resp_family, "rejected_resp" },
+    { delivery_report_resp_family, "resp_timeout_status" },
+    { delivery_report_resp_family, "resp_success_status" },
+    { delivery_report_resp_family, "resp_fail_status" },
+    { delivery_report_resp_family, "resp_sending_succeed" },
+    { delivery_report_resp_family, "resp_sending_failed" },
+};
+
+/** @brief record of a deliver_info in the deliver store: flags, numbers and strings, then the serialized PDU */
+std::string encode_parked(const deliver_info& info)
+{
+    std::string record;
+
+    auto put_u32 = [&](uint32_t value) { record.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+    auto put_u64 = [&](uint64_t value) { record.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+    auto put_str = [&](std::string_view value) {
+        put_u32(static_cast<uint32_t>(value.size()));
+        record.append(value);
+    };
+
+    record.push_back(info.is_report_ ? 1 : 0);
+    put_u32(info.originating_sequence_number_);
+    put_u64(info.deliver_req_received_time_);
+    put_str(info.source_connection_);
+    put_str(info.dest_connection_);
+    put_str(info.source_ip_);
+    put_str(info.system_type_);
+    put_str(info.dr_status_);
+    put_str(info.smsc_unique_id_);
+    put_str(info.is_report_ ? info.dr_request->SerializeAsString() : info.request->SerializeAsString());
+
+    return record;
+}
+
+/** @brief nullptr if the record is malformed */
+std::shared_ptr<deliver_info> decode_parked(std::string_view record)
+{
+    auto info = std::make_shared<deliver_info>();
+
+    auto get = [&](void* value, size_t size) {
+        if(record.size() < size)
+        {
+            return false;
+        }
+
+        std::memcpy(value, record.data(), size);
+        record.remove_prefix(size);
+        return true;
+    };
+    auto get_str = [&](std::string& value) {
+        uint32_t size;
+        if(!get(&size, sizeof(size)) || record.size() < size)
+        {
+            return false;
+        }
+
+        value.assign(record.substr(0, size));
+        record.remove_prefix(size);
+        return true;
+    };
+
+    uint8_t is_report;
+    std::string pdu;
+    if(!get(&is_report, sizeof(is_report)) ||
+       !get(&info->originating_sequence_number_, sizeof(info->originating_sequence_number_)) ||
+       !get(&info->deliver_req_received_time_, sizeof(info->deliver_req_received_time_)) ||
+       !get_str(info->source_connection_) ||
+       !get_str(info->dest_connection_) ||
+       !get_str(info->source_ip_) ||
+       !get_str(info->system_type_) ||
+       !get_str(info->dr_status_) ||
+       !get_str(info->smsc_unique_id_) ||
+       !get_str(pdu))
+    {
+        return nullptr;
+    }
+
+    info->is_report_ = is_report != 0;
+
+    if(info->is_report_)
+    {
+        info->dr_request = io::arena_pool::instance().make_message<SMSC::Protobuf::SMPP::DeliveryReport_Req>();
+        if(!info->dr_request->ParseFromString(pdu))
+        {
+            return nullptr;
+        }
+    }
+    else
+    {
+        info->request = io::arena_pool::instance().make_message<SMSC::Protobuf::SMPP::Deliver_Sm_Req>();
+        if(!info->request->ParseFromString(pdu))
+        {
+            return nullptr;
+        }
+    }
+
+    return info;
+}
+
+/** @return the message id base named by config, or fallback if the name is not valid */
+SMSC::Protobuf::SMPP_MESSAGE_ID_TYPE parse_msg_id_base(const std::shared_ptr<pa::config::node>& config, SMSC::Protobuf::SMPP_MESSAGE_ID_TYPE fallback)
+{
+    const auto value = config->get<std::string>();
+
+    if(("DEC" == value) || ("dec" == value))
+    {
+        return SMSC::Protobuf::DEC;
+    }
+
+    if(("HEX" == value) || ("hex" == value))
+    {
+        return SMSC::Protobuf::HEX;
+    }
+
+    LOG_ERROR("This base type({}) is not valid", value);
+    return fallback;
+}
+
+/** @brief packet_expirator_ key, sequence numbers are only unique within one session */
+uint64_t make_packet_key(uint32_t window_id, uint32_t sequence_number)
+{
+    return static_cast<uint64_t>(window_id) << 32 | sequence_number;
+}
+} // namespace
+
 sgw_external_client::sgw_external_client(
     std::shared_ptr<smpp_gateway>            smpp_gateway,
     boost::asio::io_context*                 io_context,
     pa::config::manager*                     config_manager,
     const std::shared_ptr<pa::config::node>& config,
     const std::shared_ptr<pa::config::node>& prometheus_config,
-    std::shared_ptr<prometheus::Registry> registry)
+    std::shared_ptr<prometheus::Registry> registry,
+    std::shared_ptr<io::dense_collector> counter_collector)
     : smpp_gateway_ { smpp_gateway }
+    , io_context_ { io_context }
     , config_manager_ { config_manager }
     , system_id_ { config->at("system_id")->get<std::string>() }
-    , max_session_ { config->at("max_session")->get<int>() }
-    , srr_state_generator_{config->at("status_report_state_generator")->get<bool>()}
-    , srr_state_{config->at("status_report_state")->get<std::string>()}
-    , system_type_ { config->at("system_type")->get<std::string>() }
     , password_ { config->at("password")->get<std::string>() }
-    , require_password_checking_ { config->at("require_password_checking")->get<bool>() }
-    , ignore_user_validity_period_ { config->at("ignore_user_validity_period")->get<bool>() }
-    , max_submit_validity_period_ { config->at("submit_validity_period")->get<int>() }
-    , max_delivery_report_validity_period_ { config->at("delivery_report_validity_period")->get<int>() }
+    , settings_ { load_settings(config) }
     , timeout_sec_{ std::chrono::seconds(config->at("dialog_timeout")->get<uint64_t>()) }
 
     , config_obs_submit_resp_msg_id_base_{config_manager->on_replace(config->at("submit_resp_msg_id_base"), std::bind_front(&sgw_external_client::set_submit_resp_msg_id_base, this))}
@@ -49,171 +240,20 @@ sgw_external_client::sgw_external_client(
     , config_obs_srr_state_generator_{config_manager->on_replace(config->at("status_report_state_generator"), std::bind_front(&sgw_external_client::set_srr_state_generator, this))}
     , config_obs_srr_state_{config_manager->on_replace(config->at("status_report_state"), std::bind_front(&sgw_external_client::set_srr_state, this))}
     , bind_family_gauge_(prometheus::BuildGauge().Name("smpp_server_bind_status").Help("smpp server bind status parameters").Register(*registry))
-    , bind_family_counter_(prometheus::BuildCounter().Name("smpp_server_bind_failed").Help("smpp server bind failed").Register(*registry))
-    , submit_family_counter_(prometheus::BuildCounter().Name("smpp_server_submit").Help("smpp server submit parameters").Register(*registry))
-    , submit_resp_family_counter_(prometheus::BuildCounter().Name("smpp_server_submit_resp").Help("smpp server submit_resp parameters").Register(*registry))
-    , deliver_family_counter_(prometheus::BuildCounter().Name("smpp_server_deliver").Help("smpp server deliver parameters").Register(*registry))
-    , deliver_resp_family_counter_(prometheus::BuildCounter().Name("smpp_server_deliver_resp").Help("smpp server deliver_resp parameters").Register(*registry))
-    , delivery_report_family_counter_(prometheus::BuildCounter().Name("smpp_server_delivery_report").Help("smpp server delivery_report parameters").Register(*registry))
     , container_family_gauge_(prometheus::BuildGauge().Name("smpp_server_container_size").Help("smpp server container size").Register(*registry))
-
-    , delivery_report_resp_family_counter_(prometheus::BuildCounter().Name("smpp_server_delivery_report_resp").Help("smpp server delivery_report_resp parameters").Register(*registry))
     , connected_connections_(add_gauge(bind_family_gauge_, prometheus_config->at("labels"), {
     { "name", "connected_connections" }, { "system_id", system_id_ }
-}))
-    , connection_reqs_failed_(add_counter(bind_family_counter_, prometheus_config->at("labels"), {
-    { "name", "connection_reqs_failed" }, { "system_id", system_id_ }
 }))
     , wait_for_resp_(add_gauge(container_family_gauge_, prometheus_config->at("labels"), {
     { "name", "wait_for_resp" }, { "system_id", system_id_ }, { "interface", "smpp" }
 }))
-    , submits_received_(add_counter(submit_family_counter_, prometheus_config->at("labels"), {
-    { "name", "received" }, { "system_id", system_id_ }
-}))
-    , submits_required_dr_(add_counter(submit_family_counter_, prometheus_config->at("labels"), {
-    { "name", "submits_require_srr" }, { "system_id", system_id_ }
-}))
-    , submits_encoding_default_alphabet_(add_counter(submit_family_counter_, prometheus_config->at("labels"), {
-    { "name", "submits_default_encoding" }, { "category", "data_encoding" }, { "system_id", system_id_ }
-}))
-    , submits_encoding_8_bit_ascii_(add_counter(submit_family_counter_, prometheus_config->at("labels"), {
-    { "name", "submits_8bit_ascii_encoding" }, { "category", "data_encoding" }, { "system_id", system_id_ }
-}))
-    , submits_encoding_8_bit_data_(add_counter(submit_family_counter_, prometheus_config->at("labels"), {
-    { "name", "submits_8bit_data_encoding" }, { "category", "data_encoding" }, { "system_id", system_id_ }
-}))
-    , submits_encoding_16_bit_data_(add_counter(submit_family_counter_, prometheus_config->at("labels"), {
-    { "name", "submits_16bit_data_encoding" }, { "category", "data_encoding" }, { "system_id", system_id_ }
-}))
-    , submits_invalid_data_encoding_(add_counter(submit_family_counter_, prometheus_config->at("labels"), {
-    { "name", "submits_invalid_data_encoding" }, { "category", "data_encoding" }, { "system_id", system_id_ }
-}))
-    , submits_rejected_(add_counter(submit_family_counter_, prometheus_config->at("labels"), {
-    { "name", "submits_rejected" }, { "system_id", system_id_ }
-}))
-    , submits_rejected_by_flow_control_(add_counter(submit_family_counter_, prometheus_config->at("labels"), {
-        { "name", "submits_rejected_by_flow_control" }, { "system_id", system_id_ }
-}))
-    , submits_rejected_by_policy_(add_counter(submit_family_counter_, prometheus_config->at("labels"), {
-        { "name", "submits_rejected_by_policy" }, { "system_id", system_id_ }
-}))
-    , submit_resp_status_ok_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "ok_status" }, { "system_id", system_id_ }
-}))
-    , submit_resp_status_timeout_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "timeout_status" }, { "system_id", system_id_ }
-}))
-    , submit_resp_status_invalid_data_encoding_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "invalid_data_encoding_status" }, { "system_id", system_id_ }
-}))
-    , submit_resp_status_invalid_source_address_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "invalid_src_status" }, { "system_id", system_id_ }
-}))
-    , submit_resp_status_invalid_source_address_ton_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "invalid_src_ton_status" }, { "system_id", system_id_ }
-}))
-    , submit_resp_status_invalid_source_address_npi_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "invalid_src_npi_status" }, { "system_id", system_id_ }
-}))
-    , submit_resp_status_invalid_destination_address_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "invalid_dst_status" }, { "system_id", system_id_ }
-}))
-    , submit_resp_status_invalid_destination_address_ton_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "invalid_dst_ton_status" }, { "system_id", system_id_ }
-}))
-    , submit_resp_status_invalid_destination_address_npi_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "invalid_dst_npi_status" }, { "system_id", system_id_ }
-}))
-    , submit_resp_status_others_error_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "other_error_status" }, { "system_id", system_id_ }
-}))
-    , send_submit_resp_successful_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_succeed" }, { "system_id", system_id_ }
-}))
-    , send_submit_resp_failed_(add_counter(submit_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_failed" }, { "system_id", system_id_ }
-}))
-    , send_deliver_successful_(add_counter(deliver_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_succeed" }, { "system_id", system_id_ }
-}))
-    , send_deliver_failed_(add_counter(deliver_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_failed" }, { "system_id", system_id_ }
-}))
-    , received_deliver_resp_(add_counter(deliver_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "received" }, { "system_id", system_id_ }
-}))
-    , rejected_deliver_resp_(add_counter(deliver_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "rejected" }, { "system_id", system_id_ }
-}))
-    , deliver_resp_status_timeout_(add_counter(deliver_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "timeout_status" }, { "system_id", system_id_ }
-}))
-    , deliver_resp_status_success_(add_counter(deliver_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "success_status" }, { "system_id", system_id_ }
-}))
-    , deliver_resp_status_fail_(add_counter(deliver_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "fail_status" }, { "system_id", system_id_ }
-}))
-    , send_deliver_resp_successful_(add_counter(deliver_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_succeed" }, { "system_id", system_id_ }
-}))
-    , send_deliver_resp_failed_(add_counter(deliver_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_failed" }, { "system_id", system_id_ }
-}))
-    , received_dr_(add_counter(delivery_report_family_counter_, prometheus_config->at("labels"), {
-    { "name", "received" }, { "system_id", system_id_ }
-}))
-    , dr_status_delivered_(add_counter(delivery_report_family_counter_, prometheus_config->at("labels"), {
-    { "name", "delivered_status" }, { "system_id", system_id_ }
-}))
-    , dr_status_expired_(add_counter(delivery_report_family_counter_, prometheus_config->at("labels"), {
-    { "name", "expired_status" }, { "system_id", system_id_ }
-}))
-    , dr_status_deleted_(add_counter(delivery_report_family_counter_, prometheus_config->at("labels"), {
-    { "name", "deleted_status" }, { "system_id", system_id_ }
-}))
-    , dr_status_undeliverable_(add_counter(delivery_report_family_counter_, prometheus_config->at("labels"), {
-    { "name", "undeliverable_status" }, { "system_id", system_id_ }
-}))
-    , dr_status_accepted_(add_counter(delivery_report_family_counter_, prometheus_config->at("labels"), {
-    { "name", "accepted_status" }, { "system_id", system_id_ }
-}))
-    , dr_status_unknown_(add_counter(delivery_report_family_counter_, prometheus_config->at("labels"), {
-    { "name", "unknown_status" }, { "system_id", system_id_ }
-}))
-    , dr_status_rejected_(add_counter(delivery_report_family_counter_, prometheus_config->at("labels"), {
-    { "name", "rejected_status" }, { "system_id", system_id_ }
-}))
-    , send_dr_successful_(add_counter(delivery_report_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_succeed" }, { "system_id", system_id_ }
-}))
-    , send_dr_failed_(add_counter(delivery_report_family_counter_, prometheus_config->at("labels"), {
-    { "name", "sending_failed" }, { "system_id", system_id_ }
-}))
-    , received_dr_resp_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "received_resp" }, { "system_id", system_id_ }
-}))
-    , rejected_dr_resp_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "rejected_resp" }, { "system_id", system_id_ }
-}))
-    , dr_resp_status_timeout_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "resp_timeout_status" }, { "system_id", system_id_ }
-}))
-    , dr_resp_status_successful_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "resp_success_status" }, { "system_id", system_id_ }
-}))
-    , dr_resp_status_failed_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "resp_fail_status" }, { "system_id", system_id_ }
-}))
-    , send_dr_resp_successful_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "resp_sending_succeed" }, { "system_id", system_id_ }
-}))
-    , send_dr_resp_failed_(add_counter(delivery_report_resp_family_counter_, prometheus_config->at("labels"), {
-    { "name", "resp_sending_failed" }, { "system_id", system_id_ }
-}))
+    , counter_collector_{ counter_collector }
+    , counters_{ std::make_shared<io::dense_counters>(counter_families, counter_specs, make_labels(prometheus_config->at("labels"), { { "system_id", system_id_ } })) }
 {
+    static_assert(std::size(counter_specs) == static_cast<size_t>(counter::count));
+    counter_collector_->add(counters_);
+
     uptime_.store(0);
-    srand(time(0));
 
     for (const auto& value : config->at("permitted_bind_types")->nodes()) {
 
@@ -232,20 +272,37 @@ sgw_external_client::sgw_external_client(
 
     try
     {
-        ip_mask_ = config->at("ip_mask")->get<std::string>();
+        window_size_ = config->at("window_size")->get<uint32_t>();
     }
     catch(...)
     {
-        ip_mask_ = "";
+        window_size_ = 100;
+    }
+
+    // with no window no deliver_sm could ever be sent to a bound esme
+    if(window_size_ == 0)
+    {
+        LOG_ERROR("window_size of client {} must be at least 1, 1 is used", system_id_);
+        window_size_ = 1;
     }
 
+    std::shared_ptr<pa::config::node> deliver_store_config;
     try
     {
-        require_ip_checking_ = config->at("require_ip_checking")->get<bool>();
+        deliver_store_config = config->at("deliver_store");
     }
     catch(...)
     {
-        require_ip_checking_ = false;
+    }
+
+    if(deliver_store_config && deliver_store_config->at("enabled")->get<bool>())
+    {
+        deliver_store_ = std::make_unique<io::mmap_queue>(
+            deliver_store_config->at("path")->get<std::string>() + "/" + system_id_,
+            deliver_store_config->at("segment_size")->get<uint32_t>(),
+            deliver_store_config->at("max_segments")->get<uint32_t>());
+
+        deliver_store_queue_threshold_ = deliver_store_config->at("queue_threshold")->get<uint32_t>();
     }
 
     try
@@ -257,9 +314,6 @@ sgw_external_client::sgw_external_client(
     {
     }
 
-    set_submit_resp_msg_id_base(config->at("submit_resp_msg_id_base"));
-    set_delivery_report_msg_id_base(config->at("delivery_report_msg_id_base"));
-
     packet_expirator_ = std::make_shared<io::expirator<uint64_t, std::shared_ptr<deliver_info>>>(
         io_context,
         std::chrono::milliseconds{ 1 },
@@ -268,44 +322,64 @@ sgw_external_client::sgw_external_client(
     packet_expirator_->start();
 
     receive_flow_control_ = std::make_shared<io::flow_control>(io_context, config_manager, config->at("receive_flow_control"), [this]() {
-        for(auto session:binded_sessions_)
+        for(auto& [session, window] : binded_sessions_)
             session->resume_receiving();
     });
 
     send_flow_control_ = std::make_shared<io::flow_control>(io_context, config_manager, config->at("send_flow_control"), [this]() { send_process(); });
-    send_flow_control_->wait(std::chrono::steady_clock::now() + std::chrono::microseconds{ 1 });
+}
 
-    policy_commands_.clear();
+std::shared_ptr<const sgw_external_client::settings> sgw_external_client::load_settings(const std::shared_ptr<pa::config::node>& config)
+{
+    auto loaded = std::make_shared<settings>();
 
-    if(config->at("source_address_check")->get<bool>())
-    {
-        policy_commands_.insert(pa::paper::proto::Request::SOURCE_ADDRESS_CHECK);
-    }
+    loaded->max_session = config->at("max_session")->get<int>();
+    loaded->srr_state_generator = config->at("status_report_state_generator")->get<bool>();
+    loaded->srr_state = config->at("status_report_state")->get<std::string>();
+    loaded->system_type = config->at("system_type")->get<std::string>();
+    loaded->require_password_checking = config->at("require_password_checking")->get<bool>();
+    loaded->ignore_user_validity_period = config->at("ignore_user_validity_period")->get<bool>();
+    loaded->max_submit_validity_period = config->at("submit_validity_period")->get<int>();
+    loaded->max_delivery_report_validity_period = config->at("delivery_report_validity_period")->get<int>();
 
-    if(config->at("source_ton_npi_check")->get<bool>())
+    try
     {
-        policy_commands_.insert(pa::paper::proto::Request::SOURCE_TON_NPI_CHECK);
+        loaded->require_ip_checking = config->at("require_ip_checking")->get<bool>();
     }
-
-    if(config->at("destination_address_check")->get<bool>())
+    catch(...)
     {
-        policy_commands_.insert(pa::paper::proto::Request::DESTINATION_ADDRESS_CHECK);
+        loaded->require_ip_checking = false;
     }
 
-    if(config->at("destination_ton_npi_check")->get<bool>())
+    try
     {
-        policy_commands_.insert(pa::paper::proto::Request::DESTINATION_TON_NPI_CHECK);
+        loaded->ip_mask = config->at("ip_mask")->get<std::string>();
     }
-
-    if(config->at("dcs_check")->get<bool>())
+    catch(...)
     {
-        policy_commands_.insert(pa::paper::proto::Request::DCS_CHECK);
     }
 
-    if(config->at("black_white_check")->get<bool>())
+    loaded->submit_resp_msg_id_base = parse_msg_id_base(config->at("submit_resp_msg_id_base"), loaded->submit_resp_msg_id_base);
+    loaded->delivery_report_msg_id_base = parse_msg_id_base(config->at("delivery_report_msg_id_base"), loaded->delivery_report_msg_id_base);
+
+    const std::pair<const char*, pa::paper::proto::Request_Type> checks[] = {
+        { "source_address_check", pa::paper::proto::Request::SOURCE_ADDRESS_CHECK },
+        { "source_ton_npi_check", pa::paper::proto::Request::SOURCE_TON_NPI_CHECK },
+        { "destination_address_check", pa::paper::proto::Request::DESTINATION_ADDRESS_CHECK },
+        { "destination_ton_npi_check", pa::paper::proto::Request::DESTINATION_TON_NPI_CHECK },
+        { "dcs_check", pa::paper::proto::Request::DCS_CHECK },
+        { "black_white_check", pa::paper::proto::Request::BLACK_WHITE_CHECK },
+    };
+
+    for(const auto& [key, command] : checks)
     {
-        policy_commands_.insert(pa::paper::proto::Request::BLACK_WHITE_CHECK);
+        if(config->at(key)->get<bool>())
+        {
+            loaded->policy_commands.insert(command);
+        }
     }
+
+    return loaded;
 }
 
 sgw_external_client::~sgw_external_client()
@@ -314,79 +388,52 @@ sgw_external_client::~sgw_external_client()
 
 void sgw_external_client::stop()
 {
-    for(auto& session : binded_sessions_)
+    for(auto& [session, window] : binded_sessions_)
         session->unbind(true /*force*/);
 
     remove_gauge(bind_family_gauge_, &connected_connections_);
-
-    remove_counter(bind_family_counter_, &connection_reqs_failed_);
-
-    remove_counter(submit_family_counter_, &submits_received_);
-    remove_counter(submit_family_counter_, &submits_required_dr_);
-    remove_counter(submit_family_counter_, &submits_encoding_default_alphabet_);
-    remove_counter(submit_family_counter_, &submits_encoding_8_bit_ascii_);
-    remove_counter(submit_family_counter_, &submits_encoding_8_bit_data_);
-    remove_counter(submit_family_counter_, &submits_encoding_16_bit_data_);
-    remove_counter(submit_family_counter_, &submits_invalid_data_encoding_);
-    remove_counter(submit_family_counter_, &submits_rejected_);
-    remove_counter(submit_family_counter_, &submits_rejected_by_flow_control_);
-    remove_counter(submit_family_counter_, &submits_rejected_by_policy_);
-
-    remove_counter(submit_resp_family_counter_, &submit_resp_status_ok_);
-    remove_counter(submit_resp_family_counter_, &submit_resp_status_timeout_);
-    remove_counter(submit_resp_family_counter_, &submit_resp_status_invalid_data_encoding_);
-    remove_counter(submit_resp_family_counter_, &submit_resp_status_invalid_source_address_);
-    remove_counter(submit_resp_family_counter_, &submit_resp_status_invalid_source_address_ton_);
-    remove_counter(submit_resp_family_counter_, &submit_resp_status_invalid_source_address_npi_);
-    remove_counter(submit_resp_family_counter_, &submit_resp_status_invalid_destination_address_);
-    remove_counter(submit_resp_family_counter_, &submit_resp_status_invalid_destination_address_ton_);
-    remove_counter(submit_resp_family_counter_, &submit_resp_status_invalid_destination_address_npi_);
-    remove_counter(submit_resp_family_counter_, &submit_resp_status_others_error_);
-    remove_counter(submit_resp_family_counter_, &send_submit_resp_successful_);
-    remove_counter(submit_resp_family_counter_, &send_submit_resp_failed_);
-
-    remove_counter(deliver_family_counter_, &send_deliver_successful_);
-    remove_counter(deliver_family_counter_, &send_deliver_failed_);
-
-    remove_counter(deliver_resp_family_counter_, &received_deliver_resp_);
-    remove_counter(deliver_resp_family_counter_, &rejected_deliver_resp_);
-    remove_counter(deliver_resp_family_counter_, &deliver_resp_status_timeout_);
-    remove_counter(deliver_resp_family_counter_, &deliver_resp_status_success_);
-    remove_counter(deliver_resp_family_counter_, &deliver_resp_status_fail_);
-    remove_counter(deliver_resp_family_counter_, &send_deliver_resp_successful_);
-    remove_counter(deliver_resp_family_counter_, &send_deliver_resp_failed_);
-
-    remove_counter(delivery_report_family_counter_, &received_dr_);
-    remove_counter(delivery_report_family_counter_, &dr_status_delivered_);
-    remove_counter(delivery_report_family_counter_, &dr_status_expired_);
-    remove_counter(delivery_report_family_counter_, &dr_status_deleted_);
-    remove_counter(delivery_report_family_counter_, &dr_status_undeliverable_);
-    remove_counter(delivery_report_family_counter_, &dr_status_accepted_);
-    remove_counter(delivery_report_family_counter_, &dr_status_unknown_);
-    remove_counter(delivery_report_family_counter_, &dr_status_rejected_);
-    remove_counter(delivery_report_family_counter_, &send_dr_successful_);
-    remove_counter(delivery_report_family_counter_, &send_dr_failed_);
-
     remove_gauge(container_family_gauge_, &wait_for_resp_);
 
-    remove_counter(delivery_report_resp_family_counter_, &received_dr_resp_);
-    remove_counter(delivery_report_resp_family_counter_, &rejected_dr_resp_);
-    remove_counter(delivery_report_resp_family_counter_, &dr_resp_status_timeout_);
-    remove_counter(delivery_report_resp_family_counter_, &dr_resp_status_successful_);
-    remove_counter(delivery_report_resp_family_counter_, &dr_resp_status_failed_);
-    remove_counter(delivery_report_resp_family_counter_, &send_dr_resp_successful_);
-    remove_counter(delivery_report_resp_family_counter_, &send_dr_resp_failed_);
+    counter_collector_->remove(counters_.get());
+}
+
+void sgw_external_client::release_session_slot()
+{
+    binded_sessions_count_.fetch_sub(1);
+    connected_connections_.Decrement();
 }
 
 void sgw_external_client::set_session(std::shared_ptr<pa::smpp::session> session)
 {
-    binded_sessions_.insert(session);
+    binded_sessions_.emplace(session, session_window{ .id = next_window_id_++ });
+
+    if(deliver_store_)
+    {
+        deliver_store_->release_deferred();
+    }
+
+    schedule_send_process();
 }
 
-void sgw_external_client::on_packet_expire(uint64_t, std::shared_ptr<deliver_info> user_data)
+void sgw_external_client::on_packet_expire(uint64_t key, std::shared_ptr<deliver_info> user_data)
 {
     LOG_INFO("packet is timeout on connection {}", system_id_);
 
+    release_window(static_cast<uint32_t>(key >> 32));
+
+    /* boninet has been answered when the packet was parked, it is offered to the ESME again */
+    if(user_data->store_record_)
+    {
+        deliver_store_->retry(user_data->store_record_);
+        schedule_send_process();
+        return;
+    }
+
+    if(park_deliver(user_data))
+    {
+        return;
+    }
+
     // if (user_data->is_report_)
     //     delivery_report_timeout_counter_.Increment();
     // else
@@ -396,47 +443,69 @@ void sgw_external_client::on_packet_expire(uint64_t, std::shared_ptr<deliver_inf
     process_deliver_resp(user_data);
 }
 
+void sgw_external_client::release_window(uint32_t window_id)
+{
+    for(auto& [session, window] : binded_sessions_)
+    {
+        if(window.id == window_id)
+        {
+            if(window.in_flight > 0)
+            {
+                window.in_flight--;
+            }
+
+            schedule_send_process();
+            return;
+        }
+    }
+}
+
 // mshadowQ: if multiple bind_type supported why "bind_type" input parameter is single value?
 pa::smpp::command_status sgw_external_client::check_permision(const std::string&  system_type,
                                                               const std::string&  password,
                                                               const std::string&  ip,
                                                               pa::smpp::bind_type bind_type)
 {
-    if(max_session_ == binded_sessions_.size())
+    const auto config = current_settings();
+
+    // authentication runs on the smpp_gateway io_context
+    auto reject = [this](pa::smpp::command_status status) {
+        binded_sessions_count_.fetch_sub(1);
+        counters_->increment(counter::connection_reqs_failed, io::counter_lane::control);
+        return status;
+    };
+
+    /* the slot is reserved before the session reaches its shard, so concurrent binds cannot pass the limit */
+    if(binded_sessions_count_.fetch_add(1) >= static_cast<size_t>(std::max(config->max_session, 0)))
     {
         LOG_ERROR("max session limit exceed '{}'.", system_id_);
-        connection_reqs_failed_.Increment();
-        return pa::smpp::command_status::rbindfail;
+        return reject(pa::smpp::command_status::rbindfail);
     }
 
-    if(system_type_ != system_type)
+    if(config->system_type != system_type)
     {
         LOG_ERROR("Invalid system_type '{}'.", system_type);
-        connection_reqs_failed_.Increment();
-        return pa::smpp::command_status::rinvsystyp;
+        return reject(pa::smpp::command_status::rinvsystyp);
     }
 
-    if(require_password_checking_ && (password_ != password))
+    if(config->require_password_checking && (password_ != password))
     {
         LOG_ERROR("Invalid Password '{}'.", password);
-        connection_reqs_failed_.Increment();
-        return pa::smpp::command_status::rinvpaswd;
+        return reject(pa::smpp::command_status::rinvpaswd);
     }
 
     auto itr1 = std::find(permitted_bind_types_.begin(), permitted_bind_types_.end(), bind_type);
     if(itr1 == permitted_bind_types_.end())
     {
         LOG_ERROR("Illegal Bind Type '{}'.", static_cast<int>(bind_type));
-        connection_reqs_failed_.Increment();
-        return pa::smpp::command_status::rinvbndsts;
+        return reject(pa::smpp::command_status::rinvbndsts);
     }
 
     auto itr2 = std::find(ip_addresses_.begin(), ip_addresses_.end(), ip);
-    if(require_ip_checking_ && (itr2 == ip_addresses_.end()))
+    if(config->require_ip_checking && (itr2 == ip_addresses_.end()))
     {
         LOG_ERROR("Invalid IP address '{}'.", ip);
-        connection_reqs_failed_.Increment();
-        return pa::smpp::command_status::rinvip;
+        return reject(pa::smpp::command_status::rinvip);
     }
 
     if(itr2 != ip_addresses_.end())
@@ -460,14 +529,13 @@ void sgw_external_client::on_session_close(std::shared_ptr<pa::smpp::session> se
     }
 
     binded_sessions_.erase(it);
+    release_session_slot();
 
     if(error)
         LOG_WARN("session {} has been closed on error {}", system_id_, error.value().c_str());
     else
         LOG_INFO("session {} has been closed gracefully", system_id_);
 
-    connected_connections_.Decrement();
-
     // binded_session_.reset();
     if(binded_sessions_.empty())
     {
@@ -475,6 +543,9 @@ void sgw_external_client::on_session_close(std::shared_ptr<pa::smpp::session> se
     }
 
     packet_expirator_->expire_all();
+
+    /* without any bound session the queued packets are rejected */
+    schedule_send_process();
 }
 
 void sgw_external_client::on_session_request(std::shared_ptr<pa::smpp::session> session, pa::smpp::request&& request, uint32_t sequence_number)
@@ -483,11 +554,7 @@ void sgw_external_client::on_session_request(std::shared_ptr<pa::smpp::session>
         [&](auto&& req) {
         using request_type = std::decay_t<decltype(req)>;
 
-        if constexpr(std::is_same_v<request_type, pa::smpp::submit_sm>)
-        {
-            process_submit_req(smpp_gateway_, shared_from_this(), std::move(req), sequence_number, session);
-        }
-        else if constexpr(std::is_same_v<request_type, pa::smpp::query_sm>)
+        if constexpr(std::is_same_v<request_type, pa::smpp::query_sm>)
         {
             LOG_ERROR("receive query_sm");
         }
@@ -507,6 +574,11 @@ void sgw_external_client::on_session_request(std::shared_ptr<pa::smpp::session>
         request);
 }
 
+void sgw_external_client::on_session_submit_sm(std::shared_ptr<pa::smpp::session> session, const pa::smpp::submit_sm_view& request, uint32_t sequence_number)
+{
+    process_submit_req(smpp_gateway_, shared_from_this(), request, sequence_number, session);
+}
+
 void sgw_external_client::on_session_response(std::shared_ptr<pa::smpp::session> session,
                                               pa::smpp::response&&     response_packet,
                                               uint32_t                 sequence_number,
@@ -518,7 +590,16 @@ void sgw_external_client::on_session_response(std::shared_ptr<pa::smpp::session>
 
         if constexpr(std::is_same_v<resonse_type, pa::smpp::deliver_sm_resp>)
         {
-            auto u = packet_expirator_->get_info(sequence_number);
+            auto it = binded_sessions_.find(session);
+            if(it == binded_sessions_.end())
+            {
+                LOG_ERROR("receive deliver_sm_resp on unknown session of client {}", system_id_);
+                return;
+            }
+
+            const auto key = make_packet_key(it->second.id, sequence_number);
+
+            auto u = packet_expirator_->get_info(key);
             if (u == std::nullopt)
             {
                 LOG_ERROR("could not find user_data for sequence {} to send back response", sequence_number);
@@ -532,9 +613,36 @@ void sgw_external_client::on_session_response(std::shared_ptr<pa::smpp::session>
             }
 
             auto orig_deliver_info = u.value();
-            packet_expirator_->remove(sequence_number);
+            packet_expirator_->remove(key);
             wait_for_resp_.Decrement();
 
+            if(it->second.in_flight > 0)
+            {
+                it->second.in_flight--;
+            }
+
+            /* the ESME answers again, parked packets whose replay failed get another chance */
+            if(deliver_store_)
+            {
+                deliver_store_->release_deferred();
+            }
+
+            schedule_send_process();
+
+            if(orig_deliver_info->store_record_)
+            {
+                if(command_status == pa::smpp::command_status::rthrottled)
+                {
+                    deliver_store_->retry(orig_deliver_info->store_record_);
+                }
+                else
+                {
+                    deliver_store_->complete(orig_deliver_info->store_record_);
+                }
+
+                return;
+            }
+
             orig_deliver_info->error_ = command_status;
 
             process_deliver_resp(orig_deliver_info);
@@ -551,66 +659,145 @@ void sgw_external_client::process_deliver_resp(std::shared_ptr<deliver_info> ori
 {
     if(orig_deliver_info->is_report_)
     {
-        received_dr_resp_.Increment();
+        counters_->increment(counter::received_dr_resp);
 
         if(orig_deliver_info->error_ == pa::smpp::command_status::rtimeout)
         {
-            dr_resp_status_timeout_.Increment();
+            counters_->increment(counter::dr_resp_status_timeout);
         }
         else
         {
             if(orig_deliver_info->error_ == pa::smpp::command_status::rok)
             {
-                dr_resp_status_successful_.Increment();
+                counters_->increment(counter::dr_resp_status_successful);
             }
             else
             {
-                dr_resp_status_failed_.Increment();
+                counters_->increment(counter::dr_resp_status_failed);
             }
         }
 
-        bool result = delivery_report::process_resp(smpp_gateway_, orig_deliver_info, orig_deliver_info->error_);
-        if(true == result)
-        {
-            send_dr_resp_successful_.Increment();
-        }
-        else
-        {
-            send_dr_resp_failed_.Increment();
-        }
+        boost::asio::dispatch(*smpp_gateway_->get_io_context(), [this, self = shared_from_this(), orig_deliver_info]() {
+            bool result = delivery_report::process_resp(smpp_gateway_, orig_deliver_info, orig_deliver_info->error_);
+            if(true == result)
+            {
+                counters_->increment(counter::send_dr_resp_successful, io::counter_lane::control);
+            }
+            else
+            {
+                counters_->increment(counter::send_dr_resp_failed, io::counter_lane::control);
+            }
+        });
     }
     else
     {
-        received_deliver_resp_.Increment();
+        counters_->increment(counter::received_deliver_resp);
 
         if(orig_deliver_info->error_ == pa::smpp::command_status::rtimeout)
         {
-            deliver_resp_status_timeout_.Increment();
+            counters_->increment(counter::deliver_resp_status_timeout);
         }
         else
         {
-            received_deliver_resp_.Increment();
+            counters_->increment(counter::received_deliver_resp);
 
             if(orig_deliver_info->error_ == pa::smpp::command_status::rok)
             {
-                deliver_resp_status_success_.Increment();
+                counters_->increment(counter::deliver_resp_status_success);
             }
             else
             {
-                deliver_resp_status_fail_.Increment();
+                counters_->increment(counter::deliver_resp_status_fail);
             }
         }
 
-        bool result = deliver_sm::process_resp(smpp_gateway_, orig_deliver_info, orig_deliver_info->error_);
-        if(true == result)
+        boost::asio::dispatch(*smpp_gateway_->get_io_context(), [this, self = shared_from_this(), orig_deliver_info]() {
+            bool result = deliver_sm::process_resp(smpp_gateway_, orig_deliver_info, orig_deliver_info->error_);
+            if(true == result)
+            {
+                counters_->increment(counter::send_deliver_resp_successful, io::counter_lane::control);
+            }
+            else
+            {
+                counters_->increment(counter::send_deliver_resp_failed, io::counter_lane::control);
+            }
+        });
+    }
+}
+
+void sgw_external_client::reject_deliver(std::shared_ptr<deliver_info> deliver_info, pa::smpp::command_status error)
+{
+    /* boninet was answered when the packet was parked, so it stays in the store; replaying it at once could
+       fail the same way again, it waits for the next bind or deliver_sm_resp */
+    if(deliver_info->store_record_)
+    {
+        LOG_WARN("could not replay parked packet {} of client {}, error: {}", deliver_info->smsc_unique_id_, system_id_, static_cast<int>(error));
+        deliver_store_->defer(deliver_info->store_record_);
+        return;
+    }
+
+    deliver_info->error_ = error;
+
+    boost::asio::dispatch(*smpp_gateway_->get_io_context(), [smpp_gateway = smpp_gateway_, deliver_info, error]() {
+        deliver_sm::process_resp(smpp_gateway, deliver_info, error);
+    });
+}
+
+bool sgw_external_client::park_deliver(std::shared_ptr<deliver_info> deliver_info)
+{
+    if(!deliver_store_)
+    {
+        return false;
+    }
+
+    // append returns once the record is synced to disk, only then may the smsc be told it is delivered
+    if(!deliver_store_->append(encode_parked(*deliver_info)))
+    {
+        LOG_WARN("deliver store of client {} is full or could not be synced", system_id_);
+        return false;
+    }
+
+    LOG_DEBUG("park packet {} of client {}", deliver_info->smsc_unique_id_, system_id_);
+
+    deliver_info->error_ = pa::smpp::command_status::rok;
+
+    boost::asio::dispatch(*smpp_gateway_->get_io_context(), [smpp_gateway = smpp_gateway_, deliver_info]() {
+        if(deliver_info->is_report_)
         {
-            send_deliver_resp_successful_.Increment();
+            delivery_report::process_resp(smpp_gateway, deliver_info, pa::smpp::command_status::rok);
         }
         else
         {
-            send_deliver_resp_failed_.Increment();
+            deliver_sm::process_resp(smpp_gateway, deliver_info, pa::smpp::command_status::rok);
+        }
+    });
+
+    return true;
+}
+
+bool sgw_external_client::replay_parked()
+{
+    if(!deliver_store_ || binded_sessions_.empty())
+    {
+        return false;
+    }
+
+    while(auto record = deliver_store_->next())
+    {
+        auto deliver_info = decode_parked(record->second);
+        if(!deliver_info)
+        {
+            LOG_ERROR("drop malformed record of the deliver store of client {}", system_id_);
+            deliver_store_->complete(record->first);
+            continue;
         }
+
+        deliver_info->store_record_ = record->first;
+        send_queue_.push_back(deliver_info);
+        return true;
     }
+
+    return false;
 }
 
 void sgw_external_client::on_session_deserialization_error(std::shared_ptr<pa::smpp::session> session, const std::string& error, pa::smpp::command_id command_id, std::span<const uint8_t> body)
@@ -632,7 +819,7 @@ void sgw_external_client::on_session_send_buf_available(std::shared_ptr<pa::smpp
 void sgw_external_client::process_submit_req(
     std::shared_ptr<smpp_gateway>        smpp_gateway,
     std::shared_ptr<sgw_external_client> ext_client,
-    pa::smpp::submit_sm&&                request,
+    const pa::smpp::submit_sm_view&      request,
     uint32_t                             sequence_number,
     std::shared_ptr<pa::smpp::session>   session)
 {
@@ -657,23 +844,23 @@ void sgw_external_client::process_submit_req(
         0, //error
         "success");
 
-    ext_client->submits_received_.Increment();
+    ext_client->counters_->increment(counter::submits_received);
 
     const auto wait_time = receive_flow_control_->check();
     if (wait_time)
     {
         if (receive_flow_control_->drop_packet())
         {
-            submits_rejected_by_flow_control_.Increment();
-            submits_rejected_.Increment();
+            counters_->increment(counter::submits_rejected_by_flow_control);
+            counters_->increment(counter::submits_rejected);
 
             user_data_info->error_ = pa::smpp::command_status::rthrottled;
 
-            submit_sm::send_resp(user_data_info);
+            boost::asio::dispatch(*smpp_gateway->get_io_context(), [user_data_info]() { submit_sm::send_resp(user_data_info); });
             return;
         }
 
-        for(auto& session : binded_sessions_)
+        for(auto& [session, window] : binded_sessions_)
             session->pause_receiving();
 
         receive_flow_control_->wait(std::chrono::steady_clock::now() + std::chrono::microseconds{ wait_time });
@@ -689,36 +876,36 @@ void sgw_external_client::process_submit_req(
             case pa::smpp::data_coding_unicode::ascii_7_bit:
             {
                 user_data_info->body = pa::smpp::convert_gsm_to_ucs2(body);
-                ext_client->submits_encoding_default_alphabet_.Increment();
+                ext_client->counters_->increment(counter::submits_encoding_default_alphabet);
                 break;
             }
 
             case pa::smpp::data_coding_unicode::ascii_8_bit:
             {
                 user_data_info->body = pa::smpp::convert_ascii_to_ucs2(body);
-                ext_client->submits_encoding_8_bit_ascii_.Increment();
+                ext_client->counters_->increment(counter::submits_encoding_8_bit_ascii);
                 break;
             }
 
             case pa::smpp::data_coding_unicode::binary:
             {
                 user_data_info->body = body;
-                ext_client->submits_encoding_8_bit_data_.Increment();
+                ext_client->counters_->increment(counter::submits_encoding_8_bit_data);
                 break;
             }
 
             case pa::smpp::data_coding_unicode::ucs2:
             {
                 user_data_info->body = body;
-                ext_client->submits_encoding_16_bit_data_.Increment();
+                ext_client->counters_->increment(counter::submits_encoding_16_bit_data);
                 break;
             }
 
             default:
                 LOG_ERROR("invalid data_encoding('{}')", static_cast<int>(user_data_info->data_coding_type_));
-                ext_client->submits_invalid_data_encoding_.Increment();
+                ext_client->counters_->increment(counter::submits_invalid_data_encoding);
                 LOG_DEBUG("The submission was rejected and could not be sent.");
-                ext_client->submits_rejected_.Increment();
+                ext_client->counters_->increment(counter::submits_rejected);
                 return;
         }
 
@@ -731,19 +918,7 @@ void sgw_external_client::process_submit_req(
 
         if(request.registered_delivery.smsc_delivery_receipt != pa::smpp::smsc_delivery_receipt::no)
         {
-            ext_client->submits_required_dr_.Increment();
-        }
-
-        if (srr_state_generator_)
-        {
-            if (srr_state_ == "never")
-                request.registered_delivery.smsc_delivery_receipt = pa::smpp::smsc_delivery_receipt::no;
-            else if (srr_state_ == "always")
-                request.registered_delivery.smsc_delivery_receipt = pa::smpp::smsc_delivery_receipt::both;
-            else if (srr_state_ == "on_failed")
-                request.registered_delivery.smsc_delivery_receipt = pa::smpp::smsc_delivery_receipt::failed;
-            else if (srr_state_ == "on_succeed")
-                request.registered_delivery.smsc_delivery_receipt = pa::smpp::smsc_delivery_receipt::succeed;
+            ext_client->counters_->increment(counter::submits_required_dr);
         }
 
         auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
@@ -755,35 +930,13 @@ void sgw_external_client::process_submit_req(
         user_data_info->is_multi_part_ = header.get_multi_part_data().number_of_parts_ > 1 ? true : false;
         user_data_info->system_type_ = ext_client->get_system_type();
         user_data_info->source_ip_ = ip_address;
-        user_data_info->request = request;
+        user_data_info->request = request.to_submit_sm();
         user_data_info->header = header.serialize();
 
-        if(policy_commands_.size())
-        {
-            sgw_logger::getInstance()->trace_message(
-                SMSC::Protobuf::AO_REQ_TYPE,
-                user_data_info->smsc_unique_id_,
-                "",    //msg_id
-                SMSC::Trace::Protobuf::PolicyRequest,
-                ext_client->get_system_id(),
-                "",    //destination_clinet_id
-                user_data_info->international_source_address_,
-                user_data_info->international_dest_address_,
-                0, //error
-                "success");
-
-            if(false == smpp_gateway->check_policies(ext_client->get_system_id(), user_data_info, policy_commands_))
-            {
-                user_data_info->error_ = pa::smpp::command_status::rsyserr;
-                ext_client->submits_rejected_.Increment();
-                submit_sm::send_resp(user_data_info);
-            }
-
-            return;
-        }
-
-        user_data_info->error_ = pa::smpp::command_status::rok;
-        submit_sm::on_check_policies_responce(smpp_gateway, user_data_info, false);
+        // pinex and paper_client live on smpp_gateway's io_context
+        boost::asio::dispatch(*smpp_gateway->get_io_context(), [ext_client, user_data_info]() {
+            ext_client->forward_submit_req(user_data_info);
+        });
         return;
     }
     catch (const std::exception& ex)
@@ -811,7 +964,53 @@ void sgw_external_client::process_submit_req(
             "");
 
     //todo:Majid Darvishan: check parameters of user_data is already filled
-    submit_sm::send_resp(user_data_info);
+    boost::asio::dispatch(*smpp_gateway->get_io_context(), [user_data_info]() { submit_sm::send_resp(user_data_info); });
+}
+
+void sgw_external_client::forward_submit_req(std::shared_ptr<submit_info> user_data_info)
+{
+    const auto config = current_settings();
+
+    if (config->srr_state_generator)
+    {
+        auto& registered_delivery = user_data_info->request.registered_delivery;
+
+        if (config->srr_state == "never")
+            registered_delivery.smsc_delivery_receipt = pa::smpp::smsc_delivery_receipt::no;
+        else if (config->srr_state == "always")
+            registered_delivery.smsc_delivery_receipt = pa::smpp::smsc_delivery_receipt::both;
+        else if (config->srr_state == "on_failed")
+            registered_delivery.smsc_delivery_receipt = pa::smpp::smsc_delivery_receipt::failed;
+        else if (config->srr_state == "on_succeed")
+            registered_delivery.smsc_delivery_receipt = pa::smpp::smsc_delivery_receipt::succeed;
+    }
+
+    if(config->policy_commands.size())
+    {
+        sgw_logger::getInstance()->trace_message(
+            SMSC::Protobuf::AO_REQ_TYPE,
+            user_data_info->smsc_unique_id_,
+            "",    //msg_id
+            SMSC::Trace::Protobuf::PolicyRequest,
+            system_id_,
+            "",    //destination_clinet_id
+            user_data_info->international_source_address_,
+            user_data_info->international_dest_address_,
+            0, //error
+            "success");
+
+        if(false == smpp_gateway_->check_policies(system_id_, user_data_info, config->policy_commands))
+        {
+            user_data_info->error_ = pa::smpp::command_status::rsyserr;
+            counters_->increment(counter::submits_rejected, io::counter_lane::control);
+            submit_sm::send_resp(user_data_info);
+        }
+
+        return;
+    }
+
+    user_data_info->error_ = pa::smpp::command_status::rok;
+    submit_sm::on_check_policies_responce(smpp_gateway_, user_data_info, false);
 }
 
 bool sgw_external_client::send_submit_resp(std::shared_ptr<submit_info> user_data)
@@ -821,7 +1020,7 @@ bool sgw_external_client::send_submit_resp(std::shared_ptr<submit_info> user_dat
     if(binded_sessions_.empty())
     {
         LOG_ERROR("send packet on closed connection");
-        send_submit_resp_failed_.Increment();
+        counters_->increment(counter::send_submit_resp_failed);
         return false;
     }
 
@@ -829,76 +1028,76 @@ bool sgw_external_client::send_submit_resp(std::shared_ptr<submit_info> user_dat
     {
         case pa::smpp::command_status::rok:
         {
-            submit_resp_status_ok_.Increment();
+            counters_->increment(counter::submit_resp_status_ok);
             break;
         }
 
         case pa::smpp::command_status::rtimeout:
         {
-            submit_resp_status_timeout_.Increment();
+            counters_->increment(counter::submit_resp_status_timeout);
             break;
         }
 
         case pa::smpp::command_status::rinvdcs:
         {
-            submit_resp_status_invalid_data_encoding_.Increment();
-            submits_rejected_by_policy_.Increment();
-            submits_rejected_.Increment();
+            counters_->increment(counter::submit_resp_status_invalid_data_encoding);
+            counters_->increment(counter::submits_rejected_by_policy);
+            counters_->increment(counter::submits_rejected);
             break;
         }
 
         case pa::smpp::command_status::rinvsrcadr:
         {
-            submit_resp_status_invalid_source_address_.Increment();
-            submits_rejected_by_policy_.Increment();
-            submits_rejected_.Increment();
+            counters_->increment(counter::submit_resp_status_invalid_source_address);
+            counters_->increment(counter::submits_rejected_by_policy);
+            counters_->increment(counter::submits_rejected);
             break;
         }
 
         case pa::smpp::command_status::rinvsrcton:
         {
-            submit_resp_status_invalid_source_address_ton_.Increment();
-            submits_rejected_by_policy_.Increment();
-            submits_rejected_.Increment();
+            counters_->increment(counter::submit_resp_status_invalid_source_address_ton);
+            counters_->increment(counter::submits_rejected_by_policy);
+            counters_->increment(counter::submits_rejected);
             break;
         }
 
         case pa::smpp::command_status::rinvsrcnpi:
         {
-            submit_resp_status_invalid_source_address_npi_.Increment();
-            submits_rejected_by_policy_.Increment();
-            submits_rejected_.Increment();
+            counters_->increment(counter::submit_resp_status_invalid_source_address_npi);
+            counters_->increment(counter::submits_rejected_by_policy);
+            counters_->increment(counter::submits_rejected);
             break;
         }
 
         case pa::smpp::command_status::rinvdstadr:
         {
-            submit_resp_status_invalid_destination_address_.Increment();
-            submits_rejected_by_policy_.Increment();
-            submits_rejected_.Increment();
+            counters_->increment(counter::submit_resp_status_invalid_destination_address);
+            counters_->increment(counter::submits_rejected_by_policy);
+            counters_->increment(counter::submits_rejected);
 
             break;
         }
 
         case pa::smpp::command_status::rinvdstton:
         {
-            submit_resp_status_invalid_destination_address_ton_.Increment();
-            submits_rejected_by_policy_.Increment();
-            submits_rejected_.Increment();
+            counters_->increment(counter::submit_resp_status_invalid_destination_address_ton);
+            counters_->increment(counter::submits_rejected_by_policy);
+            counters_->increment(counter::submits_rejected);
             break;
         }
 
         case pa::smpp::command_status::rinvdstnpi:
         {
-            submit_resp_status_invalid_destination_address_npi_.Increment();
-            submits_rejected_by_policy_.Increment();
-            submits_rejected_.Increment();
+            counters_->increment(counter::submit_resp_status_invalid_destination_address_npi);
+            counters_->increment(counter::submits_rejected_by_policy);
+            counters_->increment(counter::submits_rejected);
             break;
         }
 
         default:
         {
-            submit_resp_status_others_error_.Increment();
+            counters_->increment(counter::submit_resp_status_others_error);
         }
     }
 
@@ -908,7 +1107,7 @@ bool sgw_external_client::send_submit_resp(std::shared_ptr<submit_info> user_dat
     {
         user_data->originating_session_->send(pa::smpp::submit_sm_resp{.message_id = user_data->message_id_ }, user_data->originating_sequence_number_, user_data->error_);
 
-        send_submit_resp_successful_.Increment();
+        counters_->increment(counter::send_submit_resp_successful);
         return true;
     }
     catch (const std::exception& ex)
@@ -923,23 +1122,52 @@ bool sgw_external_client::send_submit_resp(std::shared_ptr<submit_info> user_dat
 
     LOG_ERROR("Could not send submit_resp to client {}", system_id_);
 
-    send_submit_resp_failed_.Increment();
+    counters_->increment(counter::send_submit_resp_failed);
 
     return false;
 }
 
 void sgw_external_client::flow_controlled_send_deliver(std::shared_ptr<deliver_info> deliver_info)
 {
+    if((binded_sessions_.empty() || send_queue_.size() >= deliver_store_queue_threshold_) && park_deliver(deliver_info))
+    {
+        return;
+    }
+
     send_queue_.push_back(deliver_info);
+
+    schedule_send_process();
+}
+
+void sgw_external_client::schedule_send_process()
+{
+    const bool has_parked = deliver_store_ && !binded_sessions_.empty() && deliver_store_->has_next();
+    if(send_process_scheduled_ || (send_queue_.empty() && !has_parked))
+    {
+        return;
+    }
+
+    send_process_scheduled_ = true;
+
+    boost::asio::post(*io_context_, [this, wptr = weak_from_this()]() {
+        if(auto self = wptr.lock())
+        {
+            send_process();
+        }
+    });
 }
 
 void sgw_external_client::send_process()
 {
-    while (!send_queue_.empty())
+    send_process_scheduled_ = false;
+
+    /* a full window is reopened by the response or the expiry which frees a slot */
+    while(can_send_deliver() && (!send_queue_.empty() || replay_parked()))
     {
         auto wait_time = send_flow_control_->check();
         if (wait_time)
         {
+            send_process_scheduled_ = true;
             send_flow_control_->wait(std::chrono::steady_clock::now() + std::chrono::microseconds{ wait_time });
             return;
         }
@@ -949,8 +1177,16 @@ void sgw_external_client::send_process()
 
         send_deliver_sm(user_data);
     }
+}
+
+bool sgw_external_client::can_send_deliver() const
+{
+    if(binded_sessions_.empty())
+    {
+        return true;
+    }
 
-    send_flow_control_->wait(std::chrono::steady_clock::now() + std::chrono::milliseconds{ 1 });
+    return std::any_of(binded_sessions_.begin(), binded_sessions_.end(), [this](const auto& entry) { return entry.second.in_flight < window_size_; });
 }
 
 void sgw_external_client::send_deliver_sm(std::shared_ptr<deliver_info> deliver_info)
@@ -959,22 +1195,56 @@ void sgw_external_client::send_deliver_sm(std::shared_ptr<deliver_info> deliver_
 
     if(binded_sessions_.empty())
     {
+        /* replayed packets wait in the store for the next bind */
+        if(deliver_info->store_record_)
+        {
+            deliver_store_->retry(deliver_info->store_record_);
+            return;
+        }
+
+        if(park_deliver(deliver_info))
+        {
+            return;
+        }
+
         LOG_ERROR("send packet on closed connection {}", system_id_);
 
         if(deliver_info->is_report_)
-            send_dr_failed_.Increment();
+            counters_->increment(counter::send_dr_failed);
         else
-            send_deliver_failed_.Increment();
+            counters_->increment(counter::send_deliver_failed);
+
+        reject_deliver(deliver_info, pa::smpp::command_status::dst_esme_not_bound);
+        return;
+    }
+
+    /* the bind with the most free window slots takes the PDU, so faster ESMEs get more of the load */
+    auto selected = binded_sessions_.end();
+    size_t most_free = 0;
+    for(auto it = binded_sessions_.begin(); it != binded_sessions_.end(); ++it)
+    {
+        const auto free = window_size_ - std::min(it->second.in_flight, window_size_);
+        if(free > most_free)
+        {
+            selected = it;
+            most_free = free;
+        }
+    }
+
+    if(selected == binded_sessions_.end())
+    {
+        LOG_DEBUG("windows of all sessions of client {} are full, queue the packet", system_id_);
+
+        if(deliver_info->store_record_ || send_queue_.size() < deliver_store_queue_threshold_ || !park_deliver(deliver_info))
+        {
+            send_queue_.push_back(deliver_info);
+        }
 
-        deliver_info->error_ = pa::smpp::command_status::dst_esme_not_bound;
-        deliver_sm::process_resp(smpp_gateway_, deliver_info, pa::smpp::command_status::dst_esme_not_bound);
         return;
     }
 
-    auto r = rand() % binded_sessions_.size();
-    auto it = std::begin(binded_sessions_);
-    std::advance(it, r);
-    auto selected_session = *it;
+    auto selected_session = selected->first;
+    auto& window = selected->second;
 
     try
     {
@@ -984,16 +1254,14 @@ void sgw_external_client::send_deliver_sm(std::shared_ptr<deliver_info> deliver_
     catch (const std::exception& ex)
     {
         LOG_ERROR("catch an exception on send_deliver_sm, {}", ex.what());
-        deliver_info->error_ = pa::smpp::command_status::rsyserr;
-        deliver_sm::process_resp(smpp_gateway_, deliver_info, pa::smpp::command_status::rsyserr);
+        reject_deliver(deliver_info, pa::smpp::command_status::rsyserr);
         return;
     }
     catch (...)
     {
         std::exception_ptr p = std::current_exception();
         LOG_ERROR("catch an exception on send_deliver_sm, {}", (p ? p.__cxa_exception_type()->name() : "null"));
-        deliver_info->error_ = pa::smpp::command_status::rsyserr;
-        deliver_sm::process_resp(smpp_gateway_, deliver_info, pa::smpp::command_status::rsyserr);
+        reject_deliver(deliver_info, pa::smpp::command_status::rsyserr);
         return;
     }
 
@@ -1017,38 +1285,38 @@ void sgw_external_client::send_deliver_sm(std::shared_ptr<deliver_info> deliver_
             "success");
 
         //todo: is this corret?
-        received_dr_.Increment();
+        counters_->increment(counter::received_dr);
 
         std::string dr_status { deliver_info->dr_status_ };
         std::transform(dr_status.begin(), dr_status.end(), dr_status.begin(), ::toupper);
 
         if(dr_status.compare("DELIVRD") == 0)
         {
-            dr_status_delivered_.Increment();
+            counters_->increment(counter::dr_status_delivered);
         }
         else if(dr_status.compare("EXPIRED") == 0)
         {
-            dr_status_expired_.Increment();
+            counters_->increment(counter::dr_status_expired);
         }
         else if(dr_status.compare("DELETED") == 0)
         {
-            dr_status_deleted_.Increment();
+            counters_->increment(counter::dr_status_deleted);
         }
         else if(dr_status.compare("UNDELIV") == 0)
         {
-            dr_status_undeliverable_.Increment();
+            counters_->increment(counter::dr_status_undeliverable);
         }
         else if(dr_status.compare("ACCEPTD") == 0)
         {
-            dr_status_accepted_.Increment();
+            counters_->increment(counter::dr_status_accepted);
         }
         else if(dr_status.compare("UNKNOWN") == 0)
         {
-            dr_status_unknown_.Increment();
+            counters_->increment(counter::dr_status_unknown);
         }
         else if(dr_status.compare("REJECTD") == 0)
         {
-            dr_status_rejected_.Increment();
+            counters_->increment(counter::dr_status_rejected);
         }
         else
         {
@@ -1079,8 +1347,9 @@ void sgw_external_client::send_deliver_sm(std::shared_ptr<deliver_info> deliver_
 
             if(seq_no)
             {
-                send_dr_successful_.Increment();
-                packet_expirator_->add(seq_no, timeout_sec_, deliver_info);
+                counters_->increment(counter::send_dr_successful);
+                packet_expirator_->add(make_packet_key(window.id, seq_no), timeout_sec_, deliver_info);
+                window.in_flight++;
                 wait_for_resp_.Increment();
                 return;
             }
@@ -1097,7 +1366,7 @@ void sgw_external_client::send_deliver_sm(std::shared_ptr<deliver_info> deliver_
 
         LOG_ERROR("Could not send dr to client {}", system_id_);
 
-        send_dr_failed_.Increment();
+        counters_->increment(counter::send_dr_failed);
         deliver_info->error_ = pa::smpp::command_status::rsyserr;
 
         sgw_logger::getInstance()->trace_message(
@@ -1112,7 +1381,7 @@ void sgw_external_client::send_deliver_sm(std::shared_ptr<deliver_info> deliver_
             (int)pa::smpp::command_status::rsyserr,
             "");
 
-        deliver_sm::process_resp(smpp_gateway_, deliver_info, pa::smpp::command_status::rsyserr);
+        reject_deliver(deliver_info, pa::smpp::command_status::rsyserr);
 
         return;
     }
@@ -1194,8 +1463,9 @@ void sgw_external_client::send_deliver_sm(std::shared_ptr<deliver_info> deliver_
 
         if(seq_no)
         {
-            send_deliver_successful_.Increment();
-            packet_expirator_->add(seq_no, timeout_sec_, deliver_info);
+            counters_->increment(counter::send_deliver_successful);
+            packet_expirator_->add(make_packet_key(window.id, seq_no), timeout_sec_, deliver_info);
+            window.in_flight++;
             wait_for_resp_.Increment();
             return;
         }
@@ -1212,7 +1482,7 @@ void sgw_external_client::send_deliver_sm(std::shared_ptr<deliver_info> deliver_
 
     LOG_ERROR("Could not send deliver_sm to client {}", system_id_);
 
-    send_deliver_failed_.Increment();
+    counters_->increment(counter::send_deliver_failed);
     deliver_info->error_ = pa::smpp::command_status::rsyserr;
 
     sgw_logger::getInstance()->trace_message(
@@ -1227,34 +1497,34 @@ void sgw_external_client::send_deliver_sm(std::shared_ptr<deliver_info> deliver_
             (int)pa::smpp::command_status::rsyserr,
             "");
 
-        deliver_sm::process_resp(smpp_gateway_, deliver_info, pa::smpp::command_status::rsyserr);
+    reject_deliver(deliver_info, pa::smpp::command_status::rsyserr);
 
     return;
 }
 
 SMSC::Protobuf::SMPP_MESSAGE_ID_TYPE sgw_external_client::get_submit_resp_msg_id_base() const
 {
-    return submit_resp_msg_id_base_;
+    return current_settings()->submit_resp_msg_id_base;
 }
 
 SMSC::Protobuf::SMPP_MESSAGE_ID_TYPE sgw_external_client::get_delivery_report_msg_id_base() const
 {
-    return delivery_report_msg_id_base_;
+    return current_settings()->delivery_report_msg_id_base;
 }
 
 bool sgw_external_client::get_ignore_user_validity_period() const
 {
-    return ignore_user_validity_period_;
+    return current_settings()->ignore_user_validity_period;
 }
 
 int sgw_external_client::get_max_submit_validity_period() const
 {
-    return max_submit_validity_period_;
+    return current_settings()->max_submit_validity_period;
 }
 
 int sgw_external_client::get_max_delivery_report_validity_period() const
 {
-    return max_delivery_report_validity_period_;
+    return current_settings()->max_delivery_report_validity_period;
 }
 
 std::string sgw_external_client::get_system_id()
@@ -1264,139 +1534,110 @@ std::string sgw_external_client::get_system_id()
 
 std::string sgw_external_client::get_system_type()
 {
-    return system_type_;
+    return current_settings()->system_type;
 }
 
-void sgw_external_client::set_submit_resp_msg_id_base(const std::shared_ptr<pa::config::node>& config)
+boost::asio::io_context* sgw_external_client::get_io_context() const
 {
-    std::string submit_resp_msg_id_base_value = config->get<std::string>();
+    return io_context_;
+}
 
-    if(("DEC" == submit_resp_msg_id_base_value) || ("dec" == submit_resp_msg_id_base_value))
-    {
-        submit_resp_msg_id_base_ = SMSC::Protobuf::DEC;
-    }
-    else if(("HEX" == submit_resp_msg_id_base_value) || ("hex" == submit_resp_msg_id_base_value))
-    {
-        submit_resp_msg_id_base_ = SMSC::Protobuf::HEX;
-    }
-    else
-    {
-        LOG_ERROR("This base type({}) is not valid", submit_resp_msg_id_base_value);
-    }
+void sgw_external_client::set_submit_resp_msg_id_base(const std::shared_ptr<pa::config::node>& config)
+{
+    update_settings([&](settings& next) { next.submit_resp_msg_id_base = parse_msg_id_base(config, next.submit_resp_msg_id_base); });
 }
 
 void sgw_external_client::set_delivery_report_msg_id_base(const std::shared_ptr<pa::config::node>& config)
 {
-    std::string delivery_report_msg_id_base_value = config->get<std::string>();
-
-    if(("DEC" == delivery_report_msg_id_base_value) || ("dec" == delivery_report_msg_id_base_value))
-    {
-        delivery_report_msg_id_base_ = SMSC::Protobuf::DEC;
-    }
-    else if(("HEX" == delivery_report_msg_id_base_value) || ("hex" == delivery_report_msg_id_base_value))
-    {
-        delivery_report_msg_id_base_ = SMSC::Protobuf::HEX;
-    }
-    else
-    {
-        LOG_ERROR("This base type({}) is not valid", delivery_report_msg_id_base_value);
-    }
+    update_settings([&](settings& next) { next.delivery_report_msg_id_base = parse_msg_id_base(config, next.delivery_report_msg_id_base); });
 }
 
 void sgw_external_client::set_system_type(const std::shared_ptr<pa::config::node>& config)
 {
-    system_type_ =  config->get<std::string>();
+    update_settings([&](settings& next) { next.system_type = config->get<std::string>(); });
 }
 
 void sgw_external_client::set_require_password_checking(const std::shared_ptr<pa::config::node>& config)
 {
-    require_password_checking_ =  config->get<bool>();
+    update_settings([&](settings& next) { next.require_password_checking = config->get<bool>(); });
 }
 
 void sgw_external_client::set_require_ip_checking(const std::shared_ptr<pa::config::node>& config)
 {
-    require_ip_checking_ =  config->get<bool>();
+    update_settings([&](settings& next) { next.require_ip_checking = config->get<bool>(); });
 }
 
 void sgw_external_client::set_ip_mask(const std::shared_ptr<pa::config::node>& config)
 {
-    ip_mask_ =  config->get<std::string>();
+    update_settings([&](settings& next) { next.ip_mask = config->get<std::string>(); });
 }
 
 void sgw_external_client::set_ignore_user_validity_period(const std::shared_ptr<pa::config::node>& config)
 {
-    ignore_user_validity_period_ =  config->get<bool>();
+    update_settings([&](settings& next) { next.ignore_user_validity_period = config->get<bool>(); });
 }
 
 void sgw_external_client::set_submit_validity_period(const std::shared_ptr<pa::config::node>& config)
 {
-    max_submit_validity_period_ =  config->get<int>();
+    update_settings([&](settings& next) { next.max_submit_validity_period = config->get<int>(); });
 }
 
 void sgw_external_client::set_delivery_report_validity_period(const std::shared_ptr<pa::config::node>& config)
 {
-    max_delivery_report_validity_period_ =  config->get<int>();
+    update_settings([&](settings& next) { next.max_delivery_report_validity_period = config->get<int>(); });
+}
+
+void sgw_external_client::set_policy_command(pa::paper::proto::Request_Type command, const std::shared_ptr<pa::config::node>& config)
+{
+    update_settings([&](settings& next) {
+        if(config->get<bool>())
+            next.policy_commands.insert(command);
+        else
+            next.policy_commands.erase(command);
+    });
 }
 
 void sgw_external_client::set_source_address_check(const std::shared_ptr<pa::config::node>& config)
 {
-    if(config->get<bool>())
-        policy_commands_.insert(pa::paper::proto::Request::SOURCE_ADDRESS_CHECK);
-    else
-        policy_commands_.erase(pa::paper::proto::Request::SOURCE_ADDRESS_CHECK);
+    set_policy_command(pa::paper::proto::Request::SOURCE_ADDRESS_CHECK, config);
 }
 
 void sgw_external_client::set_source_ton_npi_check(const std::shared_ptr<pa::config::node>& config)
 {
-    if(config->get<bool>())
-        policy_commands_.insert(pa::paper::proto::Request::SOURCE_TON_NPI_CHECK);
-    else
-        policy_commands_.erase(pa::paper::proto::Request::SOURCE_TON_NPI_CHECK);
+    set_policy_command(pa::paper::proto::Request::SOURCE_TON_NPI_CHECK, config);
 }
 
 void sgw_external_client::set_destination_address_check(const std::shared_ptr<pa::config::node>& config)
 {
-    if(config->get<bool>())
-        policy_commands_.insert(pa::paper::proto::Request::DESTINATION_ADDRESS_CHECK);
-    else
-        policy_commands_.erase(pa::paper::proto::Request::DESTINATION_ADDRESS_CHECK);
+    set_policy_command(pa::paper::proto::Request::DESTINATION_ADDRESS_CHECK, config);
 }
 
 void sgw_external_client::set_destination_ton_npi_check(const std::shared_ptr<pa::config::node>& config)
 {
-    if(config->get<bool>())
-        policy_commands_.insert(pa::paper::proto::Request::DESTINATION_TON_NPI_CHECK);
-    else
-        policy_commands_.erase(pa::paper::proto::Request::DESTINATION_TON_NPI_CHECK);
+    set_policy_command(pa::paper::proto::Request::DESTINATION_TON_NPI_CHECK, config);
 }
 
 void sgw_external_client::set_dcs_check(const std::shared_ptr<pa::config::node>& config)
 {
-    if(config->get<bool>())
-        policy_commands_.insert(pa::paper::proto::Request::DCS_CHECK);
-    else
-        policy_commands_.erase(pa::paper::proto::Request::DCS_CHECK);
+    set_policy_command(pa::paper::proto::Request::DCS_CHECK, config);
 }
 
 void sgw_external_client::set_black_white_check(const std::shared_ptr<pa::config::node>& config)
 {
-    if(config->get<bool>())
-        policy_commands_.insert(pa::paper::proto::Request::BLACK_WHITE_CHECK);
-    else
-        policy_commands_.erase(pa::paper::proto::Request::BLACK_WHITE_CHECK);
+    set_policy_command(pa::paper::proto::Request::BLACK_WHITE_CHECK, config);
 }
 
 void sgw_external_client::set_max_session(const std::shared_ptr<pa::config::node>& config)
 {
-    max_session_ =  config->get<int>();
+    update_settings([&](settings& next) { next.max_session = config->get<int>(); });
 }
 
 void sgw_external_client::set_srr_state_generator(const std::shared_ptr<pa::config::node>& config)
 {
-    srr_state_generator_ = config->get<bool>();
+    update_settings([&](settings& next) { next.srr_state_generator = config->get<bool>(); });
 }
 
 void sgw_external_client::set_srr_state(const std::shared_ptr<pa::config::node>& config)
 {
-    srr_state_ = config->get<std::string>();
+    update_settings([&](settings& next) { next.srr_state = config->get<std::string>(); });
 }
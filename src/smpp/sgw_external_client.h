@@ -3,8 +3,14 @@
 #include "src/smpp_gateway.h"
 #include "src/libs/flow_control.hpp"
 #include "src/libs/expirator.hpp"
+#include "src/libs/dense_counters.hpp"
+#include "src/libs/mmap_queue.hpp"
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <optional>
+#include <set>
 
 class sgw_external_client : public std::enable_shared_from_this<sgw_external_client>
 {
@@ -15,7 +21,8 @@ public:
         pa::config::manager*                     config_manager,
         const std::shared_ptr<pa::config::node>& config,
         const std::shared_ptr<pa::config::node>& prometheus_config,
-        std::shared_ptr<prometheus::Registry> registry
+        std::shared_ptr<prometheus::Registry> registry,
+        std::shared_ptr<io::dense_collector> counter_collector
         );
 
     virtual ~sgw_external_client();
@@ -72,6 +79,17 @@ public:
      */
     void on_session_request(std::shared_ptr<pa::smpp::session> session, pa::smpp::request&& request, uint32_t sequence_number);
 
+    /**
+     * @brief Handles an incoming submit_sm decoded without copying.
+     *
+     * The view refers into the session's receive buffer, so it is only valid during this call; `process_submit_req`
+     * copies the PDU into `submit_info` only once the submit is accepted for forwarding.
+     *
+     * @param[in] request The submit_sm view.
+     * @param sequence_number The sequence number associated with the request.
+     */
+    void on_session_submit_sm(std::shared_ptr<pa::smpp::session> session, const pa::smpp::submit_sm_view& request, uint32_t sequence_number);
+
     /**
      * @brief Handles incoming SMPP responses from the SMPP gateway.
      *
@@ -100,6 +118,13 @@ public:
      */
     void set_session(std::shared_ptr<pa::smpp::session> session);
 
+    /**
+     * @brief Gives back the session slot which check_permision reserved for an accepted bind.
+     *
+     * Called when the session closes, including a close before it reached the shard.
+     */
+    void release_session_slot();
+
     /** getter */
     SMSC::Protobuf::SMPP_MESSAGE_ID_TYPE get_submit_resp_msg_id_base() const;
     SMSC::Protobuf::SMPP_MESSAGE_ID_TYPE get_delivery_report_msg_id_base() const;
@@ -110,6 +135,9 @@ public:
     std::string get_system_id();
     std::string get_system_type();
 
+    /** @brief io_context (shard) which owns this client, its sessions and timers. */
+    boost::asio::io_context* get_io_context() const;
+
     /** getter */
 
     /**
@@ -139,12 +167,59 @@ public:
     void send_deliver_sm(std::shared_ptr<deliver_info> deliverInfo);
 
 private:
-    void on_packet_expire(uint64_t, std::shared_ptr<deliver_info> user_data);
+    void on_packet_expire(uint64_t key, std::shared_ptr<deliver_info> user_data);
+
+    /**
+     * @brief Frees one window slot of the session which `window_id` belongs to, if it is still bound.
+     */
+    void release_window(uint32_t window_id);
 
     void process_deliver_resp(std::shared_ptr<deliver_info> orig_deliver_info);
 
+    /**
+     * @brief Hands a failed deliver_sm/DR back to boninet.
+     *
+     * Runs `deliver_sm::process_resp` on the smpp_gateway io_context, because pinex and loggers live there.
+     * A packet replayed from deliver_store_ is deferred in the store instead, boninet already has its answer.
+     */
+    void reject_deliver(std::shared_ptr<deliver_info> deliver_info, pa::smpp::command_status error);
+
+    /**
+     * @brief Appends a deliver_sm/DR to deliver_store_ and answers boninet with success on its behalf.
+     *
+     * @return `false` if the store is disabled or full, the caller handles the packet as before.
+     */
+    bool park_deliver(std::shared_ptr<deliver_info> deliver_info);
+
+    /**
+     * @brief Moves the next parked packet into send_queue_, while a session is bound.
+     *
+     * @return `false` if nothing was moved.
+     */
+    bool replay_parked();
+
+    /**
+     * @brief Drains send_queue_ as far as flow control and the session windows allow.
+     *
+     * When throttled it sleeps on send_flow_control_ until the next token; otherwise nothing is armed
+     * and the drain is woken by schedule_send_process.
+     */
     void send_process();
 
+    /**
+     * @brief Wakes the drain on the next turn of io_context_, unless it is already pending.
+     *
+     * Called whenever send_queue_ may have become drainable: a packet is queued, a window slot is freed or a session is bound.
+     */
+    void schedule_send_process();
+
+    /**
+     * @brief Whether send_deliver_sm may be called, i.e. a bound session has a free window slot.
+     *
+     * Also true without any bound session, so queued packets are rejected instead of waiting.
+     */
+    bool can_send_deliver() const;
+
     void set_submit_resp_msg_id_base(const std::shared_ptr<pa::config::node>& config);
     void set_delivery_report_msg_id_base(const std::shared_ptr<pa::config::node>& config);
 
@@ -164,6 +239,9 @@ private:
     void set_max_session(const std::shared_ptr<pa::config::node>& config);
     void set_srr_state_generator(const std::shared_ptr<pa::config::node>& config);
     void set_srr_state(const std::shared_ptr<pa::config::node>& config);
+
+    /** @brief adds or removes a PAPER command of submits depending on a boolean config node */
+    void set_policy_command(pa::paper::proto::Request_Type command, const std::shared_ptr<pa::config::node>& config);
     /**
      * @brief Processes a received SUBMIT_SM request.
      *
@@ -172,40 +250,78 @@ private:
      *
      * @param[in] smpp_gateway Reference to an SMSC gateway object.
      * @param[in, out] ext_client Shared pointer to the external client object that sent the request.
-     * @param[in] request Reference to the received SUBMIT_SM PDU containing details of the message.
+     * @param[in] request View of the received SUBMIT_SM PDU, only valid during this call.
      * @param[in] sequence_number Sequence number assigned to the request.
      * @param[in] session Pointer to the SMPP session object associated with the request.
      */
     void process_submit_req(
         std::shared_ptr<smpp_gateway>        smpp_gateway,
         std::shared_ptr<sgw_external_client> ext_client,
-        pa::smpp::submit_sm&&                request,
+        const pa::smpp::submit_sm_view&      request,
         uint32_t                             sequence_number,
         std::shared_ptr<pa::smpp::session>   session
         );
 
+    /**
+     * @brief Second half of submit processing which runs on the smpp_gateway io_context.
+     *
+     * Applies the status report state and either asks PAPER for policies or passes the submit to boninet.
+     *
+     * @param[in, out] user_data Shared pointer to the `submit_info` object prepared by `process_submit_req`.
+     */
+    void forward_submit_req(std::shared_ptr<submit_info> user_data);
+
     std::shared_ptr<smpp_gateway> smpp_gateway_;
+    boost::asio::io_context* io_context_;
     pa::config::manager* config_manager_;
 
+    /**
+     * @brief Client settings which config observers replace at runtime.
+     *
+     * They are read on the shard (submits) and on the smpp_gateway io_context (authentication, pinex encoding),
+     * so an observer never changes them in place, it publishes a changed copy through settings_.
+     */
+    struct settings
+    {
+        int max_session;
+        bool srr_state_generator;
+        std::string srr_state;
+        std::string system_type;
+        bool require_password_checking;
+        bool require_ip_checking;
+        std::string ip_mask;
+        SMSC::Protobuf::SMPP_MESSAGE_ID_TYPE submit_resp_msg_id_base = SMSC::Protobuf::DEC;
+        SMSC::Protobuf::SMPP_MESSAGE_ID_TYPE delivery_report_msg_id_base = SMSC::Protobuf::DEC;
+        bool ignore_user_validity_period;
+        int max_submit_validity_period;
+        int max_delivery_report_validity_period;
+        std::set<pa::paper::proto::Request_Type> policy_commands;
+    };
+
+    static std::shared_ptr<const settings> load_settings(const std::shared_ptr<pa::config::node>& config);
+
+    std::shared_ptr<const settings> current_settings() const
+    {
+        return settings_.load(std::memory_order_acquire);
+    }
+
+    /** @brief applies change to a copy of the settings and publishes it, observers all run on the config thread */
+    template<typename Change>
+    void update_settings(Change&& change)
+    {
+        auto next = std::make_shared<settings>(*current_settings());
+        change(*next);
+        settings_.store(std::move(next), std::memory_order_release);
+    }
+
     std::string system_id_;
-    int max_session_;
-    bool srr_state_generator_;
-    std::string srr_state_;
-    std::string system_type_;
     std::string password_;
-    bool require_password_checking_;
-    bool require_ip_checking_;
-    std::string ip_mask_;
     std::vector<std::string> ip_addresses_;
     std::vector<pa::smpp::bind_type> permitted_bind_types_;
-    SMSC::Protobuf::SMPP_MESSAGE_ID_TYPE submit_resp_msg_id_base_ = SMSC::Protobuf::DEC;
-    SMSC::Protobuf::SMPP_MESSAGE_ID_TYPE delivery_report_msg_id_base_ = SMSC::Protobuf::DEC;
 
-    std::chrono::seconds timeout_sec_;
+    std::atomic<std::shared_ptr<const settings>> settings_;
 
-    bool ignore_user_validity_period_;
-    int max_submit_validity_period_;
-    int max_delivery_report_validity_period_;
+    std::chrono::seconds timeout_sec_;
 
     pa::config::manager::observer config_obs_submit_resp_msg_id_base_;
     pa::config::manager::observer config_obs_delivery_report_msg_id_base_;
@@ -236,96 +352,109 @@ private:
     std::shared_ptr<io::flow_control> receive_flow_control_;
     std::shared_ptr<io::flow_control> send_flow_control_;
 
-    std::set<std::shared_ptr<pa::smpp::session>> binded_sessions_;
+    /**
+     * @brief Unacknowledged deliver_sm/DR PDUs of one bound session.
+     *
+     * `id` is the high half of the packet_expirator_ keys of the session, the low half is the sequence number.
+     */
+    struct session_window
+    {
+        uint32_t id;
+        size_t in_flight{ 0 };
+    };
 
-    std::set<pa::paper::proto::Request_Type> policy_commands_;
+    std::map<std::shared_ptr<pa::smpp::session>, session_window> binded_sessions_;
+    uint32_t next_window_id_{ 0 };
+    size_t window_size_;
+    std::atomic<size_t> binded_sessions_count_{ 0 }; /**< sessions bound or being moved to the shard, reserved by check_permision */
 
     std::deque<std::shared_ptr<deliver_info>> send_queue_;
 
+    std::unique_ptr<io::mmap_queue> deliver_store_; /**< packets parked while the ESME is unbound or backpressured, nullptr if disabled */
+    size_t deliver_store_queue_threshold_{ 0 };     /**< send_queue_ length from which new packets are parked */
+    bool send_process_scheduled_{ false }; /**< a posted drain or a throttle wait of send_flow_control_ is pending */
+
     // monitoring family
     prometheus::Family<prometheus::Gauge>& bind_family_gauge_;
-    prometheus::Family<prometheus::Counter>& bind_family_counter_;
-    prometheus::Family<prometheus::Counter>& submit_family_counter_;
-    prometheus::Family<prometheus::Counter>& submit_resp_family_counter_;
-    prometheus::Family<prometheus::Counter>& deliver_family_counter_;
-    prometheus::Family<prometheus::Counter>& deliver_resp_family_counter_;
-    prometheus::Family<prometheus::Counter>& delivery_report_family_counter_;
-    prometheus::Family<prometheus::Counter>& delivery_report_resp_family_counter_;
     prometheus::Family<prometheus::Gauge>& container_family_gauge_;
 
     // bind monitoring variables
     prometheus::Gauge& connected_connections_;
-    prometheus::Counter& connection_reqs_failed_;
 
     // container monitoring variables
     prometheus::Gauge& wait_for_resp_;
 
     friend class submit_sm;
-    // submits monitoring variables
-    prometheus::Counter& submits_received_;
-    prometheus::Counter& submits_required_dr_;
-    prometheus::Counter& submits_encoding_default_alphabet_;
-    prometheus::Counter& submits_encoding_8_bit_ascii_;
-    prometheus::Counter& submits_encoding_8_bit_data_;
-    prometheus::Counter& submits_encoding_16_bit_data_;
-    prometheus::Counter& submits_invalid_data_encoding_;
-    prometheus::Counter& submits_rejected_;
-    prometheus::Counter& submits_rejected_by_flow_control_;
-    prometheus::Counter& submits_rejected_by_policy_;
-
-    // submit response monitoring variables
-    prometheus::Counter& submit_resp_status_ok_;
-    prometheus::Counter& submit_resp_status_timeout_;
-    prometheus::Counter& submit_resp_status_invalid_data_encoding_;
-    prometheus::Counter& submit_resp_status_invalid_source_address_;
-    prometheus::Counter& submit_resp_status_invalid_source_address_ton_;
-    prometheus::Counter& submit_resp_status_invalid_source_address_npi_;
-    prometheus::Counter& submit_resp_status_invalid_destination_address_;
-    prometheus::Counter& submit_resp_status_invalid_destination_address_ton_;
-    prometheus::Counter& submit_resp_status_invalid_destination_address_npi_;
-    prometheus::Counter& submit_resp_status_others_error_;
-
-    prometheus::Counter& send_submit_resp_successful_;
-    prometheus::Counter& send_submit_resp_failed_;
-
-    // deliver monitoring variables
-    // prometheus::Counter& deliver_route_failed_;
-
-    prometheus::Counter& send_deliver_successful_;
-    prometheus::Counter& send_deliver_failed_;
-
-    // deliver response monitoring variables
-    prometheus::Counter& received_deliver_resp_;
-    prometheus::Counter& rejected_deliver_resp_;
-    prometheus::Counter& deliver_resp_status_timeout_;
-    prometheus::Counter& deliver_resp_status_success_;
-    prometheus::Counter& deliver_resp_status_fail_;
-    prometheus::Counter& send_deliver_resp_successful_;
-    prometheus::Counter& send_deliver_resp_failed_;
-
-    // delivery report monitoring variables
-    // prometheus::Counter& dr_route_failed_;
-
-    prometheus::Counter& received_dr_;
-    prometheus::Counter& dr_status_delivered_;
-    prometheus::Counter& dr_status_expired_;
-    prometheus::Counter& dr_status_deleted_;
-    prometheus::Counter& dr_status_undeliverable_;
-    prometheus::Counter& dr_status_accepted_;
-    prometheus::Counter& dr_status_unknown_;
-    prometheus::Counter& dr_status_rejected_;
-    prometheus::Counter& send_dr_successful_;
-    prometheus::Counter& send_dr_failed_;
-
-    // delivery report response monitoring variables
-    prometheus::Counter& received_dr_resp_;
-    prometheus::Counter& rejected_dr_resp_;
-    prometheus::Counter& dr_resp_status_timeout_;
-    prometheus::Counter& dr_resp_status_successful_;
-    prometheus::Counter& dr_resp_status_failed_;
-    prometheus::Counter& send_dr_resp_successful_;
-    prometheus::Counter& send_dr_resp_failed_;
-
-    //mshadowQ: not used. check it later
-    // prometheus::Counter& rejected_by_flow_control_;
+
+    /** @brief index into counters_, in the order of counter_specs in sgw_external_client.cpp */
+    enum class counter : size_t
+    {
+        // bind
+        connection_reqs_failed,
+
+        // submit
+        submits_received,
+        submits_required_dr,
+        submits_encoding_default_alphabet,
+        submits_encoding_8_bit_ascii,
+        submits_encoding_8_bit_data,
+        submits_encoding_16_bit_data,
+        submits_invalid_data_encoding,
+        submits_rejected,
+        submits_rejected_by_flow_control,
+        submits_rejected_by_policy,
+
+        // submit response
+        submit_resp_status_ok,
+        submit_resp_status_timeout,
+        submit_resp_status_invalid_data_encoding,
+        submit_resp_status_invalid_source_address,
+        submit_resp_status_invalid_source_address_ton,
+        submit_resp_status_invalid_source_address_npi,
+        submit_resp_status_invalid_destination_address,
+        submit_resp_status_invalid_destination_address_ton,
+        submit_resp_status_invalid_destination_address_npi,
+        submit_resp_status_others_error,
+        send_submit_resp_successful,
+        send_submit_resp_failed,
+
+        // deliver
+        send_deliver_successful,
+        send_deliver_failed,
+
+        // deliver response
+        received_deliver_resp,
+        rejected_deliver_resp,
+        deliver_resp_status_timeout,
+        deliver_resp_status_success,
+        deliver_resp_status_fail,
+        send_deliver_resp_successful,
+        send_deliver_resp_failed,
+
+        // delivery report
+        received_dr,
+        dr_status_delivered,
+        dr_status_expired,
+        dr_status_deleted,
+        dr_status_undeliverable,
+        dr_status_accepted,
+        dr_status_unknown,
+        dr_status_rejected,
+        send_dr_successful,
+        send_dr_failed,
+
+        // delivery report response
+        received_dr_resp,
+        rejected_dr_resp,
+        dr_resp_status_timeout,
+        dr_resp_status_successful,
+        dr_resp_status_failed,
+        send_dr_resp_successful,
+        send_dr_resp_failed,
+
+        count
+    };
+
+    std::shared_ptr<io::dense_collector> counter_collector_;
+    std::shared_ptr<io::dense_counters> counters_;
 };
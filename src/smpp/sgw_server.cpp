@@ -13,12 +13,14 @@ sgw_server::sgw_server(
     pa::config::manager*                     config_manager,
     const std::shared_ptr<pa::config::node>& config,
     const std::shared_ptr<pa::config::node>& prometheus_config,
-    std::shared_ptr<prometheus::Registry> registry)
+    std::shared_ptr<prometheus::Registry> registry,
+    std::shared_ptr<io::dense_collector> counter_collector)
     : config_manager_(config_manager)
     , smpp_gateway_(smpp_gateway)
     , io_context_(io_context)
     , prometheus_config_(prometheus_config)
     , registry_(registry)
+    , counter_collector_(counter_collector)
     , config_obs_external_client_insert_{config_manager->on_insert(config->at("external_client"), std::bind_front(&sgw_server::on_external_client_insert, this))}
     , config_obs_external_client_remove_{config_manager->on_remove(config->at("external_client"), std::bind_front(&sgw_server::on_external_client_remove, this))}
     , deliver_routing_family_counter_(prometheus::BuildCounter().Name("smpp_server_deliver_routing").Help("smpp server deliver routing parameters").Register(*registry))
@@ -41,6 +43,22 @@ sgw_server::sgw_server(
     inactivity_threshold_ = config->at("inactivity_timeout")->get<int>();
     enquirelink_threshold_ = config->at("enquire_link_timeout")->get<int>();
 
+    try
+    {
+        worker_threads_ = config->at("worker_threads")->get<uint32_t>();
+    }
+    catch(...)
+    {
+        worker_threads_ = 0;
+    }
+
+    if(worker_threads_)
+    {
+        io_context_pool_ = std::make_unique<io::io_context_pool>(worker_threads_);
+        io_context_pool_->run();
+        LOG_INFO("external clients are sharded over {} worker threads.", worker_threads_);
+    }
+
     for(const auto& ext_client_conf : config->at("external_client")->nodes())
     {
         std::string system_id = ext_client_conf->at("system_id")->get<std::string>();
@@ -50,11 +68,12 @@ sgw_server::sgw_server(
         {
             auto ext_client = std::make_shared<sgw_external_client>(
                 smpp_gateway_,
-                io_context,
+                next_io_context(),
                 config_manager_,
                 ext_client_conf,
                 prometheus_config_,
-                registry_);
+                registry_,
+                counter_collector_);
 
             ext_clients_map_.try_emplace(system_id, ext_client);
             LOG_DEBUG("client '{}' is inserted successfully.", system_id);
@@ -86,6 +105,20 @@ sgw_server::sgw_server(
 
 sgw_server::~sgw_server()
 {
+    if(io_context_pool_)
+    {
+        io_context_pool_->stop();
+    }
+}
+
+boost::asio::io_context* sgw_server::next_io_context()
+{
+    if(io_context_pool_)
+    {
+        return io_context_pool_->get_io_context();
+    }
+
+    return io_context_;
 }
 
 // mshadow: todo: multi connection use different ip_address of unique system-id should be handle.(every connection can have specefic bind_type)
@@ -116,9 +149,33 @@ void sgw_server::on_bind(const pa::smpp::bind_request& bind_request, std::shared
         return;
     }
 
+    if(ext_client->get_io_context() == io_context_)
+    {
+        attach_session(ext_client, session);
+        return;
+    }
+
+    // move the connection to the shard which owns the external client
+    session->close_handler = [ext_client, system_id = bind_request.system_id](std::shared_ptr<pa::smpp::session>, std::optional<std::string> error) {
+        LOG_WARN("session of client {} has been closed before transfer, error: {}", system_id, error.value_or(""));
+        ext_client->release_session_slot();
+    };
+
+    session->transfer(ext_client->get_io_context(), [ext_client](std::shared_ptr<pa::smpp::session> session) {
+        boost::asio::post(*ext_client->get_io_context(), [ext_client, session]() {
+            attach_session(ext_client, session);
+            session->start();
+            session->bind();
+        });
+    });
+}
+
+void sgw_server::attach_session(std::shared_ptr<sgw_external_client> ext_client, std::shared_ptr<pa::smpp::session> session)
+{
     ext_client->set_session(session);
 
     session->request_handler = std::bind_front(&sgw_external_client::on_session_request, ext_client);
+    session->submit_sm_view_handler = std::bind_front(&sgw_external_client::on_session_submit_sm, ext_client);
     session->response_handler = std::bind_front(&sgw_external_client::on_session_response, ext_client);
     session->send_buf_available_handler = std::bind_front(&sgw_external_client::on_session_send_buf_available, ext_client);
     session->close_handler = std::bind_front(&sgw_external_client::on_session_close, ext_client);
@@ -138,11 +195,12 @@ void sgw_server::on_external_client_insert(const std::shared_ptr<pa::config::nod
     {
         auto ext_client = std::make_shared<sgw_external_client>(
             smpp_gateway_,
-            io_context_,
+            next_io_context(),
             config_manager_,
             config,
             prometheus_config_,
-            registry_
+            registry_,
+            counter_collector_
             );
 
         ext_clients_map_.try_emplace(system_id, ext_client);
@@ -156,7 +214,8 @@ void sgw_server::on_external_client_remove(const std::shared_ptr<pa::config::nod
     auto itr = ext_clients_map_.find(system_id);
     if(itr != ext_clients_map_.end())
     {
-        itr->second->stop();
+        auto ext_client = itr->second;
+        boost::asio::dispatch(*ext_client->get_io_context(), [ext_client]() { ext_client->stop(); });
         ext_clients_map_.erase(itr); //client removed
         LOG_DEBUG("client '{}' is removed successfully at runtime.", system_id);
         return;
@@ -236,7 +295,9 @@ void sgw_server::send_deliver(std::shared_ptr<deliver_info> deliver_sm_info)
         return;
     }
 
-    ext_client->flow_controlled_send_deliver(deliver_sm_info);
+    boost::asio::dispatch(*ext_client->get_io_context(), [ext_client, deliver_sm_info]() {
+        ext_client->flow_controlled_send_deliver(deliver_sm_info);
+    });
 }
 
 void sgw_server::send_delivery_report(const std::string& orig_cp_id, std::shared_ptr<deliver_info> deliver_info)
@@ -254,7 +315,9 @@ void sgw_server::send_delivery_report(const std::string& orig_cp_id, std::shared
         return;
     }
 
-    ext_client->send_deliver_sm(deliver_info);
+    boost::asio::dispatch(*ext_client->get_io_context(), [ext_client, deliver_info]() {
+        ext_client->send_deliver_sm(deliver_info);
+    });
 }
 
 //TODO: Majid Darvishan, should be implemented
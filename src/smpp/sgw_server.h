@@ -1,6 +1,7 @@
 #pragma once
 
 #include "src/smpp/sgw_external_client.h"
+#include "src/libs/io_context_pool.hpp"
 
 class routing_matcher;
 
@@ -13,7 +14,8 @@ public:
         pa::config::manager*                     config_manager,
         const std::shared_ptr<pa::config::node>& config,
         const std::shared_ptr<pa::config::node>& prometheus_config,
-        std::shared_ptr<prometheus::Registry> registry
+        std::shared_ptr<prometheus::Registry> registry,
+        std::shared_ptr<io::dense_collector> counter_collector
         );
 
     virtual ~sgw_server();
@@ -39,9 +41,24 @@ private:
     //mshadow: check it
     bool is_available(const std::string& id);
 
+    /**
+     * @brief Picks the io_context for a new external client.
+     *
+     * @return the next shard of `io_context_pool_` or `io_context_` when no worker thread is configured.
+     */
+    boost::asio::io_context* next_io_context();
+
+    /**
+     * @brief Attaches a bound session to its external client and wires the session handlers.
+     *
+     * Must be called on the external client's io_context.
+     */
+    static void attach_session(std::shared_ptr<sgw_external_client> ext_client, std::shared_ptr<pa::smpp::session> session);
+
     pa::config::manager* config_manager_; /**< Pointer to the configuration manager used for loading and managing sgw_server configuration. */
     std::shared_ptr<smpp_gateway> smpp_gateway_; /**< Shared pointer to the SMPP gateway object used for SMPP communication. */
     boost::asio::io_context* io_context_; /**< Pointer to the io_context used for asynchronous operations. */
+    std::unique_ptr<io::io_context_pool> io_context_pool_; /**< Worker shards which own the external clients, null if `worker_threads` is zero. */
     std::shared_ptr<pa::smpp::server> smpp_server_; /**< Shared pointer to the SMPP server instance used for listening on the SMPP port. */
 
     pa::config::manager::observer config_obs_external_client_insert_;               /**< Observers for external client insertion events. */
@@ -55,10 +72,12 @@ private:
     int timeout_;
     uint32_t inactivity_threshold_;
     uint32_t enquirelink_threshold_;
+    uint32_t worker_threads_;
     //
 
     std::shared_ptr<pa::config::node> prometheus_config_; /**< Shared pointer to the Prometheus configuration node for metric collection. */
     std::shared_ptr<prometheus::Registry> registry_;
+    std::shared_ptr<io::dense_collector> counter_collector_; /**< Exposes the per external client counters on scrape. */
 
     /**
      * @brief Handles an authentication request from an external client.
@@ -119,15 +119,17 @@ void submit_sm::send_resp(std::shared_ptr<submit_info> user_data)
         //user_data->error_.GetErrorString());
         "");
 
-    user_data->originating_ext_client_->send_submit_resp(user_data);
+    // the originating session belongs to the external client's io_context
+    auto ext_client = user_data->originating_ext_client_;
+    boost::asio::dispatch(*ext_client->get_io_context(), [ext_client, user_data]() {
+        ext_client->send_submit_resp(user_data);
+    });
 }
 
-bool submit_sm::encode_to_protobuf(
-    std::shared_ptr<submit_info> user_data,
-    std::string&                 encoded)
+void submit_sm::encode_to_protobuf(
+    std::shared_ptr<submit_info>          user_data,
+    SMSC::Protobuf::SMPP::Submit_Sm_Req& submit)
 {
-    SMSC::Protobuf::SMPP::Submit_Sm_Req submit;
-
     submit.set_smsc_unique_id(user_data->smsc_unique_id_);
 
     submit.set_cp_system_id(user_data->originating_ext_client_->get_system_id());
@@ -190,6 +192,4 @@ bool submit_sm::encode_to_protobuf(
 
     // LogProtobufMessage(spdlog::level::debug, submit);
     log_protobuf_message(submit);
-
-    return submit.SerializeToString(&encoded);
 }
@@ -63,18 +63,16 @@ public:
         );
 
     /**
-     * @brief Encodes a submit_info object into a serialized protobuf message.
+     * @brief Encodes a submit_info object into a protobuf message.
      *
-     * This function takes a `submit_info` object containing details of a SUBMIT_SM request and encodes it into a serialized string representation using Protobuf.
-     * The encoded message can then be sent to the SMPP gateway.
+     * This function takes a `submit_info` object containing details of a SUBMIT_SM request and fills a Submit_Sm_Req with it.
+     * The caller serializes the message straight into the pinex send buffer, so it decides where the message lives.
      *
      * @param[in] user_data Shared pointer to the `submit_info` object containing message details.
-     * @param[out] encoded Reference to a string that will hold the serialized protobuf message.
-     *
-     * @return True on success, false on failure.
+     * @param[out] submit The message to fill, usually allocated on a scratch arena.
      */
-    static bool encode_to_protobuf(
-        std::shared_ptr<submit_info> user_data,
-        std::string&                 encoded
+    static void encode_to_protobuf(
+        std::shared_ptr<submit_info>          user_data,
+        SMSC::Protobuf::SMPP::Submit_Sm_Req& submit
         );
 };
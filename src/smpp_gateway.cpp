@@ -38,6 +38,7 @@ smpp_gateway::smpp_gateway(boost::asio::io_context* io_context, pa::config::mana
     // , routing_ {std::make_shared<routing_matcher>(config_manager_, config_->at("routing"))}
     , exposer_(std::make_unique<prometheus::Exposer>(config_->at("prometheus")->at("address")->get<std::string>()))
     , registry_(std::make_shared<prometheus::Registry>())
+    , counter_collector_(std::make_shared<io::dense_collector>())
 {
 
 }
@@ -50,7 +51,8 @@ void smpp_gateway::initilize()
         config_manager_,
         config_->at("smpp_server"),
         config_->at("prometheus"),
-        registry_
+        registry_,
+        counter_collector_
     );
 
     pinex_ = std::make_shared<pinex>(
@@ -59,7 +61,8 @@ void smpp_gateway::initilize()
         config_manager_,
         config_->at("network_interface"),
         config_->at("prometheus"),
-        registry_
+        registry_,
+        counter_collector_
     );
 
     paper_client_ = std::make_shared<paper_client>(
@@ -88,6 +91,7 @@ void smpp_gateway::start()
     start_time_ = time(nullptr);
     run_.store(true);
     exposer_->RegisterCollectable(registry_);
+    exposer_->RegisterCollectable(counter_collector_);
     do_set_timer();
 }
 
@@ -140,6 +144,11 @@ std::string smpp_gateway::component_id() const
     return pinex_->client_id();
 }
 
+boost::asio::io_context* smpp_gateway::get_io_context() const
+{
+    return io_context_;
+}
+
 void smpp_gateway::send_deliver(std::shared_ptr<deliver_info> deliver_info)
 {
     smpp_server_->send_deliver(deliver_info);
@@ -42,6 +42,10 @@ public:
     }
 
     std::string component_id() const;
+
+    /** @brief io_context of pinex, paper_client and loggers; other io_contexts hand their work over to it. */
+    boost::asio::io_context* get_io_context() const;
+
     void get_current_time(unsigned& hours, unsigned& minutes, unsigned& seconds);
 
     void send_deliver(std::shared_ptr<deliver_info> deliver_info);
@@ -65,4 +69,5 @@ private:
 
     std::unique_ptr<prometheus::Exposer> exposer_;
     std::shared_ptr<prometheus::Registry> registry_;
+    std::shared_ptr<io::dense_collector> counter_collector_;
 };